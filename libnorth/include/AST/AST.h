@@ -3,12 +3,16 @@
 #define LIBNORTH_AST_H
 
 #include "Grammar/Token.h"
-#include "Visitor.h"
 #include "Type/Type.h"
 
 #include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Hashing.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/ilist.h>
+#include <llvm/IR/Value.h>
+#include <llvm/Support/Casting.h>
 
 namespace llvm {
 class Function;
@@ -23,40 +27,18 @@ class Type;
 class Module;
 } // namespace north::type
 
+namespace north::utils {
+class DiagnosticBuffer;
+} // namespace north::utils
+
 namespace north::ast {
 
+#define NODE(Name) class Name;
+#include "AST/ASTNodes.def"
+
 enum NodeKind {
-  AST_TypeDef,
-
-  AST_AliasDecl,
-  AST_StructDecl,
-  AST_UnionDecl,
-  AST_EnumDecl,
-  AST_TupleDecl,
-  AST_RangeDecl,
-
-  AST_InterfaceDecl,
-  AST_GenericFunctionDecl,
-  AST_FunctionDecl,
-  AST_VarDecl,
-
-  AST_BinaryExpr,
-  AST_UnaryExpr,
-  AST_LiteralExpr,
-  AST_RangeExpr,
-  AST_CallExpr,
-  AST_ArrayIndexExpr,
-  AST_QualifiedIdentifierExpr,
-  AST_IfExpr,
-  AST_ForExpr,
-  AST_WhileExpr,
-  AST_AssignExpr,
-  AST_StructInitExpr,
-  AST_ArrayExpr,
-
-  AST_OpenStmt,
-  AST_BlockStmt,
-  AST_ReturnStmt,
+#define NODE(Name) AST_##Name,
+#include "AST/ASTNodes.def"
 };
 
 class Node : public llvm::ilist_node<Node> {
@@ -72,11 +54,19 @@ public:
 
   NodeKind getKind() const { return Kind; };
 
-  virtual llvm::Value *accept(Visitor &) = 0;
+protected:
+  /// For copies which end up as a node of another class.
+  void setKind(NodeKind NewKind) { Kind = NewKind; }
+
+public:
+
+  /// Calls the visit overload of \p V for this node's kind, see ASTVisitor.
+  template <typename VisitorT> decltype(auto) accept(VisitorT &V) {
+    return V.dispatch(*this);
+  }
 };
 
 #define AST_NODE(KIND)                                                         \
-  llvm::Value *accept(Visitor &V) override { return V.visit(*this); }          \
   static bool classof(const Node *Node) {                                      \
     return Node->getKind() == AST_##KIND;                                      \
   }
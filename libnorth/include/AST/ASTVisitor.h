@@ -0,0 +1,58 @@
+#ifndef LIBNORTH_AST_ASTVISITOR_H
+#define LIBNORTH_AST_ASTVISITOR_H
+
+#include "AST/AST.h"
+
+#include <llvm/Support/ErrorHandling.h>
+
+namespace north::ast {
+
+/// Base of the AST walkers. Derived implements visit() for every node class
+/// (AST_WALKER_METHODS declares them) and dispatch() selects the overload
+/// with a switch over the node kind, so visiting a node is a direct call
+/// which the compiler is free to inline.
+template <typename Derived, typename Result = void> class ASTVisitor {
+public:
+  Result dispatch(Node &N) {
+    switch (N.getKind()) {
+#define NODE(Name)                                                             \
+  case AST_##Name:                                                             \
+    return static_cast<Derived *>(this)->visit(static_cast<Name &>(N));
+#include "AST/ASTNodes.def"
+    }
+    llvm_unreachable("unknown AST node kind");
+  }
+};
+
+#define AST_WALKER_METHODS(Result)                                             \
+  Result visit(ast::FunctionDecl &);                                           \
+  Result visit(ast::GenericFunctionDecl &);                                    \
+  Result visit(ast::InterfaceDecl &);                                          \
+  Result visit(ast::VarDecl &);                                                \
+  Result visit(ast::AliasDecl &);                                              \
+  Result visit(ast::StructDecl &);                                             \
+  Result visit(ast::EnumDecl &);                                               \
+  Result visit(ast::UnionDecl &);                                              \
+  Result visit(ast::TupleDecl &);                                              \
+  Result visit(ast::RangeDecl &);                                              \
+  Result visit(ast::TypeDef &);                                                \
+  Result visit(ast::UnaryExpr &);                                              \
+  Result visit(ast::BinaryExpr &);                                             \
+  Result visit(ast::LiteralExpr &);                                            \
+  Result visit(ast::RangeExpr &);                                              \
+  Result visit(ast::CallExpr &);                                               \
+  Result visit(ast::ArrayIndexExpr &);                                         \
+  Result visit(ast::QualifiedIdentifierExpr &);                                \
+  Result visit(ast::IfExpr &);                                                 \
+  Result visit(ast::ForExpr &);                                                \
+  Result visit(ast::WhileExpr &);                                              \
+  Result visit(ast::AssignExpr &);                                             \
+  Result visit(ast::OpenStmt &);                                               \
+  Result visit(ast::BlockStmt &);                                              \
+  Result visit(ast::ReturnStmt &);                                             \
+  Result visit(ast::StructInitExpr &);                                         \
+  Result visit(ast::ArrayExpr &);
+
+} // namespace north::ast
+
+#endif // LIBNORTH_AST_ASTVISITOR_H
@@ -8,9 +8,10 @@ class AliasDecl final : public GenericDecl {
   llvm::Type *IRValue;
 
 public:
-  explicit AliasDecl(const Position &Pos, llvm::StringRef Identifier,
-                     llvm::StringRef Alias = "")
-      : GenericDecl(Pos, AST_AliasDecl, Identifier), Alias(Alias) {}
+  explicit AliasDecl(const TokenInfo &TkInfo, llvm::StringRef Alias = "")
+      : GenericDecl(TkInfo.Pos, AST_AliasDecl, TkInfo.toString(),
+                    TkInfo.Symbol),
+        Alias(Alias) {}
 
   llvm::StringRef getAlias() { return Alias; }
   void setAlias(llvm::StringRef NewAlias) { Alias = NewAlias; }
@@ -5,13 +5,19 @@ namespace north::ast {
 
 class Declaration : public Node {
   llvm::StringRef Identifier;
+  SymbolId Symbol;
 
 public:
-  explicit Declaration(const Position &Pos, NodeKind Kind, llvm::StringRef Identifier)
-      : Node(Pos, Kind), Identifier(Identifier) {}
+  explicit Declaration(const Position &Pos, NodeKind Kind, llvm::StringRef Identifier,
+                       SymbolId Symbol = InvalidSymbol)
+      : Node(Pos, Kind), Identifier(Identifier), Symbol(Symbol) {}
 
   llvm::StringRef getIdentifier() { return Identifier; }
-  void setIdentifier(llvm::StringRef NewIdent) { Identifier = NewIdent; }
+  SymbolId getSymbol() const { return Symbol; }
+  void setIdentifier(llvm::StringRef NewIdent, SymbolId NewSymbol) {
+    Identifier = NewIdent;
+    Symbol = NewSymbol;
+  }
 };
 
 } // namespace north::ast
@@ -1,13 +1,13 @@
 #ifndef LIBNORTH_AST_DECLARATIONS_ENUMDECL_H
 #define LIBNORTH_AST_DECLARATIONS_ENUMDECL_H
 
-#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/DenseMap.h>
 
 namespace north::ast {
 
 class EnumDecl final : public GenericDecl {
   std::vector<LiteralExpr> Members;
-  llvm::StringMap<llvm::Value *> IRValues;
+  llvm::DenseMap<SymbolId, llvm::Value *> IRValues;
 
 public:
   explicit EnumDecl(const TokenInfo &Info)
@@ -18,10 +18,10 @@ public:
   llvm::ArrayRef<LiteralExpr> getMemberList() const { return Members; }
   void addMember(const TokenInfo &Info) { Members.emplace_back(Info); }
 
-  llvm::Value *getValue(llvm::StringRef K) const {
+  llvm::Value *getValue(SymbolId K) const {
     return IRValues.find(K)->second;
   }
-  void addValue(llvm::StringRef K, llvm::Value *V) {
+  void addValue(SymbolId K, llvm::Value *V) {
     // TODO: error reporting
     IRValues.try_emplace(K, V);
   }
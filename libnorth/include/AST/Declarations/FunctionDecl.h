@@ -9,16 +9,29 @@ class FunctionDecl : public GenericDecl {
   BlockStmt *Block;
   
   bool IsVarArg;
+  bool BodyChecked = false;
   
   llvm::Function *IR = nullptr;
   llvm::Type *TypeIR = nullptr;
 
+protected:
+  FunctionDecl(NodeKind Kind, const TokenInfo &TkInfo, BlockStmt *Block,
+               bool VarArg)
+      : GenericDecl(TkInfo.Pos, Kind, TkInfo.toString(), TkInfo.Symbol),
+        Block(Block), IsVarArg(VarArg) {}
+
 public:
   FunctionDecl(const TokenInfo &TkInfo, BlockStmt *Block = nullptr, bool VarArg = false)
-      : GenericDecl(TkInfo.Pos, AST_FunctionDecl, TkInfo.toString()),
-        Block(Block), IsVarArg(VarArg) {}
+      : FunctionDecl(AST_FunctionDecl, TkInfo, Block, VarArg) {}
 
-  FunctionDecl(const FunctionDecl &Fn) = default;
+  /// Copies \p Fn as a plain function; this is how generic functions are
+  /// instantiated.
+  FunctionDecl(const FunctionDecl &Fn)
+      : GenericDecl(Fn), Arguments(Fn.Arguments), Type(Fn.Type),
+        Block(Fn.Block), IsVarArg(Fn.IsVarArg), BodyChecked(Fn.BodyChecked),
+        IR(Fn.IR), TypeIR(Fn.TypeIR) {
+    setKind(AST_FunctionDecl);
+  }
 
   bool hasArgs() const { return !Arguments.empty(); }
   llvm::ArrayRef<VarDecl *> getArgumentList() { return Arguments; }
@@ -50,13 +63,27 @@ public:
   }
   
   llvm::Function *maybeGetIR() { return IR; }
+  /// For a declaration replaced by its definition, e.g. a linked one.
+  void setIR(llvm::Function *Fn) { IR = Fn; }
 
   void setVarArg(bool V) { IsVarArg = V; }
   bool isVarArg() { return IsVarArg; }
 
-  AST_NODE(FunctionDecl)
+  /// Whether the body was already type-checked for every instance, see
+  /// type::checkGenericFunction().
+  bool isBodyChecked() const { return BodyChecked; }
+  void setBodyChecked() { BodyChecked = true; }
+
+  static bool classof(const Node *Node) {
+    return Node->getKind() == AST_FunctionDecl ||
+           Node->getKind() == AST_GenericFunctionDecl;
+  }
   
   void createIR(type::Module *);
+
+  /// Points the argument declarations at the IR arguments. Instances of a
+  /// generic function share them, so each instance rebinds before codegen.
+  void bindArguments();
 };
 
 class GenericFunctionDecl : public FunctionDecl {
@@ -65,16 +92,34 @@ public:
     FunctionDecl *Fn;
     llvm::SmallVector<GenericDecl::Generic, 2> Types;
   };
-  
+
+  /// Types substituted for the generic parameters, in declaration order.
+  /// Types are uniqued, so the tuple is compared and hashed by pointer.
+  using TypeTuple = llvm::SmallVector<type::Type *, 2>;
+
 private:
+  struct TypeTupleInfo {
+    static TypeTuple getEmptyKey() {
+      return {reinterpret_cast<type::Type *>(uintptr_t(-1))};
+    }
+    static TypeTuple getTombstoneKey() {
+      return {reinterpret_cast<type::Type *>(uintptr_t(-2))};
+    }
+    static unsigned getHashValue(const TypeTuple &Types) {
+      return llvm::hash_combine_range(Types.begin(), Types.end());
+    }
+    static bool isEqual(const TypeTuple &LHS, const TypeTuple &RHS) {
+      return LHS == RHS;
+    }
+  };
+
   llvm::SmallVector<CallExpr *, 4> Calls;
   llvm::SmallVector<InstantiatedFn, 4> InstantiatedFunctions;
-  
-  FunctionDecl *isInstantiatedAlready(llvm::ArrayRef<GenericDecl::Generic>) const;
+  llvm::DenseMap<TypeTuple, FunctionDecl *, TypeTupleInfo> Instances;
   
 public:
   GenericFunctionDecl(const TokenInfo &TkInfo, BlockStmt *Block = nullptr, bool VarArg = false)
-    : FunctionDecl(TkInfo, Block, VarArg) {}
+    : FunctionDecl(AST_GenericFunctionDecl, TkInfo, Block, VarArg) {}
   
   void addInstantiatedFunction(const InstantiatedFn &Fn) { InstantiatedFunctions.push_back(Fn); }
   llvm::ArrayRef<InstantiatedFn> getInstantiatedFunctions() const { return InstantiatedFunctions; }
@@ -8,10 +8,20 @@ public:
   struct Generic {
     Position Pos;
     llvm::StringRef Name;
+    SymbolId Symbol;
     type::Type *Type = nullptr;
+    /// Interface the parameter is bounded by, as in `[T: Addable]`.
+    llvm::StringRef BoundName;
+    SymbolId Bound = InvalidSymbol;
 
-    Generic(Position Pos, llvm::StringRef Name)
-        : Pos(Pos), Name(Name) {}
+    Generic(Position Pos, llvm::StringRef Name, SymbolId Symbol)
+        : Pos(Pos), Name(Name), Symbol(Symbol) {}
+
+    bool isBounded() const { return Bound != InvalidSymbol; }
+    void setBound(const TokenInfo &TkInfo) {
+      BoundName = TkInfo.toString();
+      Bound = TkInfo.Symbol;
+    }
   };
   using GenericList = llvm::SmallVector<Generic, 2>;
 
@@ -22,20 +32,21 @@ private:
   GenericList Generics;
 
 public:
-  GenericDecl(const Position &Pos, NodeKind Kind, llvm::StringRef Identifier, Modifier Mods = None)
-      : Declaration(Pos, Kind, Identifier), Modifiers(Mods) {}
+  GenericDecl(const Position &Pos, NodeKind Kind, llvm::StringRef Identifier,
+              SymbolId Symbol = InvalidSymbol, Modifier Mods = None)
+      : Declaration(Pos, Kind, Identifier, Symbol), Modifiers(Mods) {}
 
   bool hasGenerics() { return !Generics.empty(); }
   GenericList &getGenericsList() { return Generics; }
-  void addGenericType(const Position &Pos, llvm::StringRef Identifier) {
-    Generics.emplace_back(Pos, Identifier);
+  void addGenericType(const TokenInfo &TkInfo) {
+    Generics.emplace_back(TkInfo.Pos, TkInfo.toString(), TkInfo.Symbol);
   }
 
-  size_t containsGeneric(llvm::StringRef T) const {
-    assert(!T.empty());
+  size_t containsGeneric(SymbolId T) const {
+    assert(T != InvalidSymbol);
     
     for (size_t I = 0; I < Generics.size(); ++I)
-      if (Generics[I].Name == T)
+      if (Generics[I].Symbol == T)
         return I;
     
     return -1;
@@ -51,6 +62,11 @@ public:
   bool isRef() { return (Modifiers & Ref) == Ref; }
   bool isOut() { return (Modifiers & Out) == Out; }
   bool isIn() { return (Modifiers & In) == In; }
+
+  static bool classof(const Node *Node) {
+    return Node->getKind() >= AST_TypeDef &&
+           Node->getKind() <= AST_FunctionDecl;
+  }
 };
 
 } // namespace north::ast
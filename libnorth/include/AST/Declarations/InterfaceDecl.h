@@ -11,7 +11,8 @@ class InterfaceDecl final : public GenericDecl {
 
 public:
   explicit InterfaceDecl(const TokenInfo &TkInfo)
-      : GenericDecl(TkInfo.Pos, AST_InterfaceDecl, TkInfo.toString()),
+      : GenericDecl(TkInfo.Pos, AST_InterfaceDecl, TkInfo.toString(),
+                    TkInfo.Symbol),
         Parent(nullptr) {}
 
   void addFunction(FunctionDecl *Function) { Required.push_back(Function); }
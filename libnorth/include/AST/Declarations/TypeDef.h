@@ -8,7 +8,9 @@ class TypeDef final : public GenericDecl {
 
 public:
   explicit TypeDef(const TokenInfo &TkInfo, TypeDef *Type = nullptr)
-      : GenericDecl(TkInfo.Pos, AST_TypeDef, TkInfo.toString()), Type(Type) {}
+      : GenericDecl(TkInfo.Pos, AST_TypeDef, TkInfo.toString(),
+                    TkInfo.Symbol),
+        Type(Type) {}
 
   GenericDecl *getTypeDecl() { return Type; }
   void setTypeDecl(GenericDecl *NewType) { Type = NewType; }
@@ -15,7 +15,8 @@ class VarDecl final : public Declaration {
 
 public:
   explicit VarDecl(const TokenInfo &TkInfo, bool Arg = false)
-      : Declaration(TkInfo.Pos, AST_VarDecl, TkInfo.toString()), IsArg(Arg), NamedArg(TkInfo.toString()) {}
+      : Declaration(TkInfo.Pos, AST_VarDecl, TkInfo.toString(), TkInfo.Symbol),
+        IsArg(Arg), NamedArg(TkInfo.toString()) {}
   ~VarDecl() {}
 
   GenericDecl *getType() { return Type; }
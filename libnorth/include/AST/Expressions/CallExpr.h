@@ -23,6 +23,11 @@ public:
       : Node(Identifier->getPosition(), AST_CallExpr), Ident(Identifier)
   { assert(Identifier); }
 
+  ~CallExpr() override {
+    for (auto Arg : Args)
+      delete Arg;
+  }
+
   bool hasArgs() { return !Args.empty(); }
   size_t countOfArgs() { return Args.size(); }
   llvm::ArrayRef<Argument *> getArgumentList() const { return Args; }
@@ -43,7 +48,10 @@ public:
   llvm::StringRef getIdentifier(size_t I) { assert(I < Ident->getSize()); return Ident->getPart(I); }
 
   FunctionDecl *getCallableFn() { assert(CallableFn); return CallableFn; }
-  void setCallableFn(FunctionDecl *, type::Module *);
+  /// Binds the call to \p Fn and checks the arguments against it. Errors go
+  /// to \p Diags when given, for callers that run concurrently.
+  void setCallableFn(FunctionDecl *, type::Module *,
+                     utils::DiagnosticBuffer *Diags = nullptr);
   
   llvm::Value *getIR() { return IRValue; }
   void setIR(llvm::Value *IR) { assert(IR); IRValue = IR; }
@@ -8,6 +8,7 @@ class ForExpr : public Node {
   Node *Iter;
   Node *Range;
   BlockStmt *Block;
+  VarDecl *IterVar = nullptr;
 
 public:
   explicit ForExpr(const TokenInfo &TkInfo)
@@ -17,6 +18,10 @@ public:
   Node *getIter() { return Iter; }
   void setIter(LiteralExpr *NewIter) { Iter = NewIter; }
 
+  /// Declaration of the loop variable, visible in the body only.
+  VarDecl *getIterVar() { return IterVar; }
+  void setIterVar(VarDecl *Var) { IterVar = Var; }
+
   Node *getRange() { return Range; }
   void setRange(Node *NewRange) { Range = NewRange; }
 
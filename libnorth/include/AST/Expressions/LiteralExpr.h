@@ -5,6 +5,8 @@ namespace north::ast {
 
 class LiteralExpr : public Node {
   TokenInfo TkInfo;
+  /// Variable an identifier refers to, bound by Sema.
+  VarDecl *Var = nullptr;
 
 public:
   explicit LiteralExpr(const TokenInfo &Info)
@@ -13,6 +15,9 @@ public:
   TokenInfo getTokenInfo() const { return TkInfo; }
   void setTokenInfo(TokenInfo NewType) { TkInfo = NewType; }
 
+  VarDecl *getVar() const { return Var; }
+  void setVar(VarDecl *V) { Var = V; }
+
   AST_NODE(LiteralExpr)
 };
 
@@ -7,6 +7,12 @@ namespace north::ast {
 class QualifiedIdentifierExpr : public Node {
   std::vector<TokenInfo> Ident;
 
+  /// Bound by Sema: either the variable the first part names, together with
+  /// the field index of every following part, or the enum of a constant.
+  VarDecl *Var = nullptr;
+  llvm::SmallVector<uint32_t, 2> Fields;
+  EnumDecl *Enum = nullptr;
+
 public:
   explicit QualifiedIdentifierExpr(const TokenInfo &TkInfo)
       : Node(TkInfo.Pos, AST_QualifiedIdentifierExpr) {
@@ -15,10 +21,18 @@ public:
 
   llvm::ArrayRef<TokenInfo> getIdentifier() const { return Ident; }
   llvm::StringRef getPart(uint8_t I) const { return Ident[I].toString(); }
+  SymbolId getSymbol(uint8_t I) const { return Ident[I].Symbol; }
   void removeFirst() { Ident.erase(Ident.begin()); }
   unsigned getSize() const { return Ident.size(); }
   void AddPart(const TokenInfo &TkInfo) { Ident.push_back(TkInfo); }
 
+  VarDecl *getVar() const { return Var; }
+  void setVar(VarDecl *V) { Var = V; }
+  llvm::ArrayRef<uint32_t> getFieldIndices() const { return Fields; }
+  void addFieldIndex(uint32_t I) { Fields.push_back(I); }
+  EnumDecl *getEnum() const { return Enum; }
+  void setEnum(EnumDecl *E) { Enum = E; }
+
   AST_NODE(QualifiedIdentifierExpr)
   
   bool operator==(const QualifiedIdentifierExpr &) const;
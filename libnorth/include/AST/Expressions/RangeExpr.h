@@ -8,8 +8,8 @@ class RangeExpr : public Node {
   LiteralExpr *Begin, *End;
 
 public:
-  explicit RangeExpr(const TokenInfo &TkInfo)
-      : Node(TkInfo.Pos, AST_RangeExpr), Begin(new LiteralExpr(TkInfo)),
+  explicit RangeExpr(LiteralExpr *Begin)
+      : Node(Begin->getPosition(), AST_RangeExpr), Begin(Begin),
         End(nullptr) {}
 
   LiteralExpr *getBeginValue() const { return Begin; }
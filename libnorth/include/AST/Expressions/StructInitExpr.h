@@ -8,6 +8,7 @@ class StructInitExpr : public Node {
   Node *Identifier;
   std::vector<Node *> Values;
   StructDecl *Type;
+  type::Type *StructType = nullptr;
   llvm::Constant *IRValue;
 
 public:
@@ -23,6 +24,10 @@ public:
   void setType(StructDecl *T) { Type = T; }
   StructDecl *getType() { return Type; }
 
+  /// The type the identifier names, bound by Sema.
+  void setStructType(type::Type *T) { StructType = T; }
+  type::Type *getStructType() { return StructType; }
+
   void setIRValue(llvm::Constant *Val) { IRValue = Val; }
   llvm::Constant *getIRValue() { return IRValue; }
 
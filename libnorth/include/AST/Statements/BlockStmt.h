@@ -6,20 +6,20 @@ namespace north::ast {
 class BlockStmt : public Node {
   FunctionDecl *Owner;
   BlockStmt *ParentBlock;
-  llvm::simple_ilist<ast::Node> *Body;
+  llvm::simple_ilist<ast::Node> Body;
 
 public:
   explicit BlockStmt(const Position &Pos, BlockStmt *Parent = nullptr)
-      : Node(Pos, AST_BlockStmt), Owner(nullptr), ParentBlock(Parent),
-        Body(new llvm::simple_ilist<ast::Node>()) {}
+      : Node(Pos, AST_BlockStmt), Owner(nullptr), ParentBlock(Parent) {}
 
-  void addNode(Node *NewNode) { Body->push_back(*NewNode); }
-  llvm::simple_ilist<ast::Node> *getBody() { return Body; }
+  void addNode(Node *NewNode) { Body.push_back(*NewNode); }
+  llvm::simple_ilist<ast::Node> *getBody() { return &Body; }
 
   void setOwner(FunctionDecl *Fn) { Owner = Fn; }
   FunctionDecl *getOwner() const { return Owner; }
   
   BlockStmt *getParent() { return ParentBlock; }
+  void setParent(BlockStmt *Parent) { ParentBlock = Parent; }
 
   AST_NODE(BlockStmt)
 };
@@ -0,0 +1,65 @@
+//===--- Frontend/CompilerInstance.h - One compilation ----------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Everything a compilation allocates lives in its CompilerInstance: the
+// LLVMContext, the primitive types bound to it, the source buffers and the
+// modules with their nodes. Instances share nothing, so any number of them
+// can work in parallel threads, one thread per instance at a time.
+//
+// The diagnostics reported through the source manager are printed and the
+// errors counted. None stops the compilation by itself; drivers check the
+// count once a stage is done, and don't go on to the next one with errors.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_FRONTEND_COMPILERINSTANCE_H
+#define LIBNORTH_FRONTEND_COMPILERINSTANCE_H
+
+#include "Type/Module.h"
+#include "Type/Type.h"
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/Support/SourceMgr.h>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace north {
+
+class CompilerInstance {
+  // Declared in the order of their dependencies, which are destroyed last.
+  llvm::LLVMContext Context;
+  type::PrimitiveTypes Primitives;
+  llvm::SourceMgr SourceManager;
+  std::vector<std::unique_ptr<type::Module>> Modules;
+  /// The workers of a stage may report errors at once.
+  std::atomic<unsigned> Errors = 0;
+
+public:
+  CompilerInstance();
+  CompilerInstance(const CompilerInstance &) = delete;
+  CompilerInstance &operator=(const CompilerInstance &) = delete;
+  ~CompilerInstance();
+
+  llvm::LLVMContext &getContext() { return Context; }
+  const type::PrimitiveTypes &getPrimitives() const { return Primitives; }
+  llvm::SourceMgr &getSourceManager() { return SourceManager; }
+
+  /// Count of the errors reported through the source manager so far.
+  unsigned getErrorCount() const { return Errors; }
+
+  /// Creates a module of the main source buffer, which must have been added
+  /// to the source manager. The module lives as long as the instance.
+  type::Module &createModule(llvm::StringRef Name);
+};
+
+} // namespace north
+
+#endif // LIBNORTH_FRONTEND_COMPILERINSTANCE_H
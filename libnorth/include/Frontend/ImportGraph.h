@@ -0,0 +1,97 @@
+//===--- Frontend/ImportGraph.h - Modules of a build ------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The modules a build compiles: its inputs and, transitively, every module
+// they open. `open Name` refers to the source `Name.n`, looked up first in the
+// directory of the module opening it and then in the search path. Sources are
+// only lexed to find their `open` statements, the graph is built before any
+// of them is parsed.
+//
+// A module is compiled once every module it opens was exported, so modules
+// which don't depend on each other are compiled in parallel, and a build
+// takes as long as its longest chain of imports rather than as its number
+// of modules.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_FRONTEND_IMPORTGRAPH_H
+#define LIBNORTH_FRONTEND_IMPORTGRAPH_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <string>
+#include <vector>
+
+namespace north {
+
+class ImportGraph {
+public:
+  struct Module {
+    std::string Name;
+    std::string Path;
+    /// Indices of the modules it opens, and of those which open it.
+    std::vector<unsigned> Imports;
+    std::vector<unsigned> Importers;
+  };
+
+private:
+  std::vector<std::string> SearchPath;
+  /// Where the interfaces of modules built separately are, see
+  /// InterfaceLoader.h. Modules found there rather than as sources are left
+  /// for the importers to load.
+  std::string InterfaceDir;
+  std::vector<Module> Modules;
+  llvm::StringMap<unsigned> Index;
+  llvm::raw_ostream &Errs;
+
+public:
+  explicit ImportGraph(std::vector<std::string> SearchPath,
+                       llvm::StringRef InterfaceDir = "",
+                       llvm::raw_ostream &Errs = llvm::errs())
+      : SearchPath(std::move(SearchPath)), InterfaceDir(InterfaceDir),
+        Errs(Errs) {}
+
+  /// Adds the module of the source \p Path, and the modules it opens.
+  /// Returns false, having reported why, if a source can't be read, an
+  /// opened module can't be found, or two sources have the same name.
+  bool addInput(llvm::StringRef Path);
+
+  /// Returns false, having reported the modules involved, if the modules
+  /// open each other in a cycle.
+  bool checkCycles();
+
+  llvm::ArrayRef<Module> getModules() const { return Modules; }
+  size_t size() const { return Modules.size(); }
+
+  /// Index of the module named \p Name, or -1 if it isn't part of the build.
+  int lookup(llvm::StringRef Name) const;
+
+  /// Compiles the modules on \p Jobs threads, the calling one included.
+  /// \p Export is called on a module once it returned for every module the
+  /// module opens, and should make its interface available to them.
+  /// \p Complete is called on it any time later. Modules opening one whose
+  /// \p Export failed are skipped; returns false if any call failed. The
+  /// graph must be free of cycles.
+  bool compile(unsigned Jobs, llvm::function_ref<bool(unsigned)> Export,
+               llvm::function_ref<bool(unsigned)> Complete);
+
+private:
+  /// Adds the module \p Name of the source \p Path, unless it's known
+  /// already, and returns its index or -1 on failure.
+  int addModule(llvm::StringRef Name, llvm::StringRef Path);
+  std::string findSource(llvm::StringRef Name, llvm::StringRef Importer);
+};
+
+} // namespace north
+
+#endif // LIBNORTH_FRONTEND_IMPORTGRAPH_H
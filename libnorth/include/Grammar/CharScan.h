@@ -0,0 +1,52 @@
+//===--- Grammar/CharScan.h - Vectorized character class scans --*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Helpers which find the end of a run of characters of the same class. Every
+// function returns a pointer to the first character in [Ptr, End) which does
+// not belong to the run, or End if the whole range does. The buffer is
+// expected to be null-terminated at End, as llvm::MemoryBuffer guarantees.
+//
+// On x86 the runs are classified 16 (SSE2) or 32 (AVX2) bytes at a time, the
+// implementation is selected once at runtime. Other targets use the scalar
+// loops.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_GRAMMAR_CHARSCAN_H
+#define LIBNORTH_GRAMMAR_CHARSCAN_H
+
+namespace north::scan {
+
+/// Skips ' ', '\t' and '\r'.
+const char *skipBlanks(const char *Ptr, const char *End);
+
+/// Skips 'a'...'z', 'A'...'Z', '0'...'9' and '_'.
+const char *skipIdentifier(const char *Ptr, const char *End);
+
+/// Skips '0'...'9'.
+const char *skipDigits(const char *Ptr, const char *End);
+
+/// Finds the next '\n' or '\0'.
+const char *findLineEnd(const char *Ptr, const char *End);
+
+/// Finds the next '"' or '\0'.
+const char *findStringEnd(const char *Ptr, const char *End);
+
+/// The same scans, a character at a time whatever the target.
+namespace scalar {
+const char *skipBlanks(const char *Ptr, const char *End);
+const char *skipIdentifier(const char *Ptr, const char *End);
+const char *skipDigits(const char *Ptr, const char *End);
+const char *findLineEnd(const char *Ptr, const char *End);
+const char *findStringEnd(const char *Ptr, const char *End);
+} // namespace scalar
+
+} // namespace north::scan
+
+#endif // LIBNORTH_GRAMMAR_CHARSCAN_H
@@ -0,0 +1,54 @@
+//===--- Grammar/Interner.h - Identifier interning --------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Every distinct identifier of a compilation gets a SymbolId. The ids are
+// dense and start at 1, so tables keyed by symbol can be plain arrays indexed
+// by the id, and comparing two names is comparing two integers.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_GRAMMAR_INTERNER_H
+#define LIBNORTH_GRAMMAR_INTERNER_H
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace north {
+
+using SymbolId = uint32_t;
+
+/// Id of tokens and declarations which don't carry a name.
+constexpr SymbolId InvalidSymbol = 0;
+
+class Interner {
+  llvm::StringMap<SymbolId> Ids;
+  std::vector<llvm::StringRef> Names;
+
+public:
+  Interner() : Names(1) {}
+
+  /// Returns the id of \p Name, assigning the next free one if the name is
+  /// seen for the first time.
+  SymbolId intern(llvm::StringRef Name);
+
+  /// Returns the id of \p Name, or InvalidSymbol if it was never interned.
+  SymbolId lookup(llvm::StringRef Name) const;
+
+  llvm::StringRef getName(SymbolId Id) const { return Names[Id]; }
+
+  /// One past the largest id handed out so far.
+  size_t size() const { return Names.size(); }
+};
+
+} // namespace north
+
+#endif // LIBNORTH_GRAMMAR_INTERNER_H
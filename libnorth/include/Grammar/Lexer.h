@@ -11,6 +11,7 @@
 #define LIBNORTH_LEXER_H
 
 #include "Token.h"
+#include "TokenStream.h"
 
 #include <bitset>
 #include <llvm/Support/SourceMgr.h>
@@ -23,10 +24,13 @@ class Lexer {
   const char *Buffer;
   const char *BufferEnd;
 
-  Position Pos;
+  const char *Ptr;
+  uint32_t Length = 0;
   std::bitset<2> Flags;
   uint8_t IndentLevel = 0;
   bool NewLine = false;
+  /// Set once an unexpected char was reported, which ends the tokens.
+  bool Failed = false;
 
 public:
   enum LexerFlag {
@@ -41,14 +45,23 @@ public:
 
   TokenInfo getNextToken();
 
+  /// Lexes the whole buffer at once, ignoring the flags and the indent level.
+  /// Comments are dropped and identifiers are interned into \p Symbols.
+  TokenStream tokenize(Interner &Symbols);
+
   void incrementIndentLevel() { ++IndentLevel; }
   void decrementIndentLevel() { --IndentLevel; }
   uint8_t getIndentLevel() { return IndentLevel; }
 
+  /// Whether the tokens were cut short by an error, reported already.
+  bool hasFailed() const { return Failed; }
+
   const llvm::SourceMgr& getSourceManager() const { return SourceManager; }
 
 private:
   void skipWhitespace();
+  TokenInfo lexToken();
+  Position getPosition() const;
   Token keywordOrIdentifier();
   TokenInfo makeToken(Token Type);
   TokenInfo makeToken(Token Type, uint8_t Length);
@@ -0,0 +1,52 @@
+//===--- Grammar/LineTable.h - Offset to line/column mapping ----*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Positions only record byte offsets. The line starts of a file are collected
+// the first time a line or column is asked for, so a compilation which prints
+// no diagnostics never scans the buffer for line breaks.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_GRAMMAR_LINETABLE_H
+#define LIBNORTH_GRAMMAR_LINETABLE_H
+
+#include <llvm/ADT/StringRef.h>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace north {
+
+struct LineAndColumn {
+  unsigned Line;
+  unsigned Column;
+};
+
+class LineTable {
+  llvm::StringRef Buffer;
+  /// Built on the first lookup, which any number of threads may race to.
+  mutable std::once_flag Built;
+  mutable std::vector<uint32_t> LineStarts;
+
+public:
+  explicit LineTable(llvm::StringRef Buffer) : Buffer(Buffer) {}
+
+  llvm::StringRef getBuffer() const { return Buffer; }
+
+  /// Returns the 1-based line and column of the byte at \p Offset.
+  LineAndColumn getLineAndColumn(uint32_t Offset) const;
+
+private:
+  void build() const;
+};
+
+} // namespace north
+
+#endif // LIBNORTH_GRAMMAR_LINETABLE_H
@@ -14,6 +14,8 @@
 #include "Lexer.h"
 #include "Type/Module.h"
 
+#include <llvm/ADT/DenseMap.h>
+
 namespace north {
 
 namespace ast {
@@ -28,28 +30,80 @@ class GenericDecl;
 
 class Parser {
   Lexer& Lex;
-  bool Peeked = false;
-  TokenInfo Buf[2];
+  TokenStream Tokens;
+
+  /// The parser's place in Tokens. Indent and Dedent are not in the stream,
+  /// they are derived from its Newline markers and the indentation state
+  /// below, so the whole cursor is saved to backtrack.
+  struct Cursor {
+    uint32_t Next = 0;    // Index of the next token to read.
+    uint32_t Current = 0; // Index the current token was read from.
+    Token Kind = Token::Eof;
+    uint8_t IndentLevel = 0;
+    bool IndentationSensitive = false;
+    bool NewLine = false;
+  } Cur;
 
   ast::BlockStmt *CurrentBlock = nullptr;
   type::Module *Module = nullptr;
+  /// Where the nodes are allocated.
+  type::NodeArena &Arena;
   bool ExpectNull = false;
   ast::IfExpr *LastIfNode = nullptr;
 
-public:
-  explicit Parser(Lexer& Lexer, type::Module* Module)
-      : Lex(Lexer), Module(Module) {}
+  /// In lazy mode a body is skipped by its indentation extent, and parsed
+  /// only when its function is reachable from an exported one: one whose
+  /// name doesn't start with `_`, like `main`.
+  bool LazyBodies = false;
+  /// Where each skipped body starts, right after the colon.
+  llvm::DenseMap<ast::FunctionDecl *, Cursor> SkippedBodies;
+  /// Names of the functions called by the code parsed since the last visit
+  /// of the call graph.
+  std::vector<SymbolId> References;
+
+  /// Set for the parsers of the parts of a buffer, see parseInParallel().
+  /// They report nothing and stop at the first error: the buffer is then
+  /// parsed again serially, which reports it.
+  bool Tentative = false;
+  /// Any parse stops at its first error, what follows it being unreliable.
+  bool Failed = false;
+
+  /// Parses a part of another parser's buffer, see parseInParallel().
+  Parser(Lexer &Lexer, type::Module *Module, TokenStream Tokens,
+         type::NodeArena &Arena)
+      : Lex(Lexer), Tokens(std::move(Tokens)), Module(Module), Arena(Arena),
+        Tentative(true) {}
 
+public:
+  explicit Parser(Lexer& Lexer, type::Module* Module, bool LazyBodies = false)
+      : Lex(Lexer), Tokens(Lexer.tokenize(Module->getInterner())), Module(Module),
+        Arena(Module->getArena()), LazyBodies(LazyBodies) {
+    // What precedes a lexing error isn't parsed either.
+    Failed = Lexer.hasFailed();
+  }
+
+  /// Parses the buffer into the module's AST and registers its declarations.
+  /// Large buffers are split into parts at top-level declarations, which are
+  /// parsed concurrently, each into its own arena, and merged in source order.
   void parse();
 
 private:
+  Token advance(Cursor &C) const;
   Token nextToken();
-  Token peekToken();
+  Token peekToken(unsigned Distance = 1) const;
+  TokenInfo current() const;
+  llvm::SMRange getRange(const Position &Pos) const;
   bool match(Token With);
   void expect(Token What);
+  /// Reports \p Message at the current token.
+  void error(const llvm::Twine &Message);
 
   bool tryParseLiteral();
 
+  bool parseInParallel();
+  ast::Node *parseTopLevelDecl();
+  void addDeclaration(ast::Node *Decl);
+
   ast::OpenStmt *parseOpenStmt();
 
   ast::GenericDecl *parseTypeDefinition();
@@ -77,6 +131,9 @@ private:
   ast::ArrayExpr *parseArrayExpr();
 
   ast::FunctionDecl *parseFunctionDecl();
+  void parseFunctionBody(ast::FunctionDecl *);
+  void skipFunctionBody(ast::FunctionDecl *);
+  void parseReferencedBodies();
   ast::FunctionDecl *parseFunctionSignature();
   void parseArgumentList(ast::FunctionDecl *);
 
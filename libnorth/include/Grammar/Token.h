@@ -10,109 +10,41 @@
 #ifndef LIBNORTH_TOKEN_H
 #define LIBNORTH_TOKEN_H
 
+#include "Interner.h"
+
 #include <llvm/ADT/StringRef.h>
 
 namespace north {
 
-enum class Token {
-  Eof = 0,
-  Comment,
-
-  Indent,
-  Dedent,
-
-  Identifier,
-  Int,
-  Char,
-  String,
-
-  Def,
-  Nil,
-  Open,
-  Interface,
-  Type,
-  Var,
-  Let,
-  If,
-  In,
-  Else,
-  For,
-  While,
-  Switch,
-  Return,
-
-  LParen,
-  RParen,
-
-  LBrace,
-  RBrace,
-
-  LBracket,
-  RBracket,
-
-  Dot,
-  DotDot,
-  Ellipsis,
-
-  Assign,
-  DivAssign,
-  MultAssign,
-  PlusAssign,
-  MinusAssign,
-  AndAssign,
-  OrAssign,
-  RShiftAssign,
-  LShiftAssign,
-
-  Eq,
-  NotEq,
-  GreaterEq,
-  LessEq,
-
-  Colon,
-  Comma,
-  Semicolon,
-
-  Div,
-  Mult,
-  Plus,
-  Minus,
-
-  Increment,
-  Decrement,
-
-  Not,
-  And,
-  Or,
-  GreaterThan,
-  LessThan,
-  Wildcard,
-
-  AndAnd,
-  OrOr,
-  RShift,
-  LShift,
-
-  RightArrow,
+enum class Token : uint8_t {
+#define TOKEN(Name, Description) Name,
+#include "Grammar/TokenKinds.def"
 };
 
+/// A source range as a byte offset into its file and a length. Lines and
+/// columns are not kept here; a LineTable computes them when needed.
 struct Position {
-  unsigned Line;
-  unsigned Column;
-  const char *Offset;
-  unsigned Length;
+  uint32_t Offset;
+  uint32_t Length;
 };
 
 struct TokenInfo {
   Position Pos;
   Token Type;
+  SymbolId Symbol = InvalidSymbol;
+  const char *Buffer = nullptr;
 
+  const char *getPointer() const { return Buffer + Pos.Offset; }
   llvm::StringRef toString() const;
 };
 
 const char *tokenToString(Token Tk);
 llvm::StringRef tokenView(TokenInfo Tk);
 
+/// Returns the keyword spelled by \p Str, or Token::Identifier if there is
+/// none.
+Token lookupKeyword(llvm::StringRef Str);
+
 } // namespace north
 
 #endif // LIBNORTH_TOKEN_H
@@ -0,0 +1,60 @@
+//===--- Grammar/TokenStream.h - Pre-lexed token buffer ---------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The tokens of a whole buffer, stored as parallel arrays so that scanning the
+// kinds touches one byte per token. Indentation is not resolved here: every
+// run of line breaks becomes a Token::Newline whose offset is the start of the
+// following line and whose length is the number of spaces it begins with. The
+// parser turns those into Indent and Dedent tokens as it walks the stream.
+// The stream always ends with Token::Eof.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_GRAMMAR_TOKENSTREAM_H
+#define LIBNORTH_GRAMMAR_TOKENSTREAM_H
+
+#include "Token.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace north {
+
+class TokenStream {
+  const char *Buffer;
+
+  std::vector<Token> Kinds;
+  std::vector<uint32_t> Offsets;
+  std::vector<uint32_t> Lengths;
+  std::vector<SymbolId> Symbols;
+
+public:
+  explicit TokenStream(const char *Buffer) : Buffer(Buffer) {}
+
+  void reserve(size_t Size);
+  void push(const TokenInfo &Tk);
+
+  size_t size() const { return Kinds.size(); }
+  const char *getBuffer() const { return Buffer; }
+
+  Token getKind(size_t Idx) const { return Kinds[Idx]; }
+  uint32_t getOffset(size_t Idx) const { return Offsets[Idx]; }
+  uint32_t getLength(size_t Idx) const { return Lengths[Idx]; }
+  SymbolId getSymbol(size_t Idx) const { return Symbols[Idx]; }
+
+  TokenInfo get(size_t Idx) const;
+
+  /// Copies the tokens in [Begin, End), ended with a Token::Eof. Offsets
+  /// still refer to the whole buffer.
+  TokenStream slice(size_t Begin, size_t End) const;
+};
+
+} // namespace north
+
+#endif // LIBNORTH_GRAMMAR_TOKENSTREAM_H
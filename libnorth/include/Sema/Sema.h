@@ -0,0 +1,78 @@
+//===--- Sema/Sema.h - Name resolution --------------------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_SEMA_SEMA_H
+#define LIBNORTH_SEMA_SEMA_H
+
+#include "AST/ASTVisitor.h"
+#include "Type/Scope.h"
+#include "Utils/Diagnostics.h"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+
+namespace north::sema {
+
+/// Binds the names used in one function body. Bodies don't depend on each
+/// other, so each one gets its own resolver: the scope, the diagnostics and
+/// the calls of generic functions found are all local to it.
+class BodyResolver : public ast::ASTVisitor<BodyResolver> {
+public:
+  struct GenericCall {
+    ast::GenericFunctionDecl *Fn;
+    ast::CallExpr *Callee;
+  };
+
+private:
+  type::Module *Module;
+  type::Scope Scope;
+  ast::FunctionDecl *CurrentFn;
+  utils::DiagnosticBuffer Diags;
+  llvm::SmallVector<GenericCall, 4> GenericCalls;
+
+public:
+  /// \p Globals are the top-level variables visible to the body.
+  BodyResolver(type::Module *Module, llvm::ArrayRef<ast::VarDecl *> Globals);
+
+  utils::DiagnosticBuffer &getDiagnostics() { return Diags; }
+  llvm::ArrayRef<GenericCall> getGenericCalls() const { return GenericCalls; }
+
+  AST_WALKER_METHODS(void)
+
+private:
+  void resolveFunction(ast::FunctionDecl &);
+  void declare(ast::VarDecl *Var);
+  ast::StructDecl *getStruct(ast::GenericDecl *TypeDecl);
+  ast::StructDecl *getStructOf(ast::VarDecl *Var);
+  void error(const Position &Pos, const llvm::Twine &Message);
+};
+
+/// Runs between the parser and the backends and binds every identifier to
+/// its declaration: variables, struct fields (by index), enum constants and
+/// callees. The backends only read the bindings and never look a name up.
+///
+/// The parser has already collected the declarations, so the module's
+/// tables are only read here. Top-level variables are resolved first, in
+/// order; then every function body is resolved concurrently, and the
+/// results are merged back in source order.
+class Sema {
+  type::Module *Module;
+
+public:
+  explicit Sema(type::Module *Module) : Module(Module) {}
+
+  /// Resolves the whole module. Errors are reported through its source
+  /// manager; returns false if there were any, and the module must not be
+  /// compiled any further.
+  bool resolve();
+};
+
+} // namespace north::sema
+
+#endif // LIBNORTH_SEMA_SEMA_H
@@ -0,0 +1,46 @@
+//===--- Serialization/ASTCache.h - On-disk AST cache -----------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_SERIALIZATION_ASTCACHE_H
+#define LIBNORTH_SERIALIZATION_ASTCACHE_H
+
+#include <llvm/ADT/StringRef.h>
+
+#include <string>
+
+namespace north::type {
+class Module;
+} // namespace north::type
+
+namespace north::serialization {
+
+/// A directory of serialized ASTs, see ASTFile.h, named after the hash of
+/// the source they were parsed from. Files are memory-mapped, so a hit costs
+/// about as much as building the nodes.
+class ASTCache {
+  std::string Dir;
+
+public:
+  explicit ASTCache(llvm::StringRef Dir) : Dir(Dir) {}
+
+  /// Rebuilds the AST of \p Module from the cache. Returns false if its
+  /// source wasn't cached, or the file is damaged.
+  bool load(type::Module &Module) const;
+
+  /// Caches the AST of \p Module. The cache is only an optimization, so
+  /// failures are ignored.
+  void store(type::Module &Module) const;
+
+private:
+  std::string getPath(llvm::StringRef Source) const;
+};
+
+} // namespace north::serialization
+
+#endif // LIBNORTH_SERIALIZATION_ASTCACHE_H
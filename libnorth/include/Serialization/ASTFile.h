@@ -0,0 +1,64 @@
+//===--- Serialization/ASTFile.h - Binary AST format ------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A compact binary form of a module's AST as the parser builds it, before
+// Sema binds any name. It only makes sense together with the source it was
+// parsed from: every position and every string is an offset into that source,
+// whose size and hash the header records.
+//
+//   header   'N' 'A' 'S' 'T', version, source size, SHA1 of the source
+//   symbols  count, then each interned name, in the order of their ids
+//   nodes    count, then one record per node, children before parents
+//   roots    count, then the top-level declarations, in source order
+//   parents  count, then (block, parent block) pairs
+//
+// Integers are ULEB128. A record starts with the node kind and position, and
+// refers to its children by their distance back to it, or 0 for none. Blocks
+// name their parent, which may come later, in the trailing table instead.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_SERIALIZATION_ASTFILE_H
+#define LIBNORTH_SERIALIZATION_ASTFILE_H
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <array>
+#include <cstdint>
+
+namespace north::type {
+class Module;
+} // namespace north::type
+
+namespace north::serialization {
+
+/// Bumped on every change of the layout; files of another version are
+/// rejected.
+constexpr uint32_t ASTFileVersion = 1;
+
+using SourceHash = std::array<uint8_t, 20>;
+
+SourceHash hashSource(llvm::StringRef Source);
+
+/// Serializes the AST of \p Module, leaving out the declarations imported
+/// by its `open` statements. Returns false if the AST holds a string
+/// which isn't part of the module's source; what was written then can't be
+/// read back and should be discarded.
+bool writeAST(type::Module &Module, llvm::raw_ostream &OS);
+
+/// Rebuilds the AST serialized in \p Data into \p Module, which must be
+/// empty, and registers its declarations. Returns false if \p Data is not a
+/// well-formed serialization of the module's source; the module is left
+/// untouched in that case.
+bool readAST(llvm::StringRef Data, type::Module &Module);
+
+} // namespace north::serialization
+
+#endif // LIBNORTH_SERIALIZATION_ASTFILE_H
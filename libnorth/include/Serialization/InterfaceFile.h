@@ -0,0 +1,78 @@
+//===--- Serialization/InterfaceFile.h - Module interfaces ------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// What a module exports, in the record format of ASTFile.h, for the modules
+// which open it. Unlike an AST file, an interface stands on its own: the
+// names and tokens it holds are copied into it, so an importer never reads
+// the source of the module.
+//
+//   header   'N' 'I' 'N' 'T', version
+//   strings  size, then every name and token spelling, one per line
+//   imports  count, then the names of the modules the module opens
+//   symbols  count, then the name of each symbol the records use
+//   nodes    count, then one record per node, as in an AST file
+//   roots    count, then the exported declarations, in source order
+//   parents  count, then (block, parent block) pairs
+//
+// Strings are a length and an offset into the strings, and symbols are
+// numbered from 1 in the order of the table. Records carry no position: the
+// declarations are attributed to the `open` statement which loaded them.
+//
+// A module exports its types and interfaces, and the functions it defines
+// whose name doesn't start with `_`. Only generic functions keep their body,
+// which each importer instantiates for itself.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_SERIALIZATION_INTERFACEFILE_H
+#define LIBNORTH_SERIALIZATION_INTERFACEFILE_H
+
+#include "Grammar/Token.h"
+
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <cstdint>
+
+namespace north::type {
+class Module;
+} // namespace north::type
+
+namespace north::serialization {
+
+/// Bumped on every change of the layout; files of another version are
+/// rejected.
+constexpr uint32_t InterfaceFileVersion = 1;
+
+/// Extension of interface files, which are named after their module.
+constexpr const char *InterfaceFileExtension = ".ni";
+
+/// Serializes the declarations \p Module exports. Returns false, having
+/// reported why and written nothing, if an exported generic body uses a
+/// private function or a top-level variable, which importers couldn't
+/// instantiate it with.
+bool writeInterface(type::Module &Module, llvm::raw_ostream &OS);
+
+/// Registers the declarations serialized in \p Data in \p Module, as if they
+/// were declared at \p Pos. \p Data must outlive the module, whose nodes
+/// refer to its strings. Before any declaration is registered, \p LoadImport
+/// is called with the name of every module the interface's module opens, and
+/// must make the types they export known; reading stops if it returns false.
+///
+/// Returns false if \p Data is not a well-formed interface. The module is
+/// left without any of its declarations then, but may have interned some of
+/// its names.
+bool readInterface(llvm::StringRef Data, type::Module &Module,
+                   const Position &Pos,
+                   llvm::function_ref<bool(llvm::StringRef)> LoadImport);
+
+} // namespace north::serialization
+
+#endif // LIBNORTH_SERIALIZATION_INTERFACEFILE_H
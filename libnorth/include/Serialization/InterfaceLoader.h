@@ -0,0 +1,61 @@
+//===--- Serialization/InterfaceLoader.h - Loads interfaces -----*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_SERIALIZATION_INTERFACELOADER_H
+#define LIBNORTH_SERIALIZATION_INTERFACELOADER_H
+
+#include "Type/Module.h"
+
+#include <llvm/ADT/StringSet.h>
+
+#include <string>
+
+namespace north::serialization {
+
+/// Loads the interfaces of opened modules, see InterfaceFile.h, from a
+/// directory where they are named after their module. The files are
+/// memory-mapped and handed to the importer's SourceMgr, which keeps them
+/// alive as long as the nodes referring to them. Interfaces written by the
+/// same build are handed over in memory instead.
+class InterfaceLoader : public type::ModuleLoader {
+  std::string Dir;
+  llvm::StringMap<llvm::StringRef> Interfaces;
+  /// Each module is loaded once, however many modules open it.
+  llvm::StringSet<> Loaded;
+
+public:
+  explicit InterfaceLoader(llvm::StringRef Dir) : Dir(Dir) {}
+
+  bool load(type::Module &Importer, ast::OpenStmt &Import) override;
+
+  /// Makes \p Data the interface of the module \p Name, in place of its file.
+  /// \p Data must outlive the importer.
+  void addInterface(llvm::StringRef Name, llvm::StringRef Data) {
+    Interfaces[Name] = Data;
+  }
+
+  /// Path of the interface of the module named \p Name in \p Dir.
+  static std::string getPath(llvm::StringRef Dir, llvm::StringRef Name);
+
+  /// Writes the interface of \p Module in \p Dir, named after the stem of
+  /// its source. Returns false on failure.
+  static bool store(type::Module &Module, llvm::StringRef Dir);
+
+  /// Writes \p Interface, serialized already, as the interface of the module
+  /// \p Name in \p Dir. Returns false on failure.
+  static bool store(llvm::StringRef Name, llvm::StringRef Interface,
+                    llvm::StringRef Dir);
+
+private:
+  bool load(type::Module &Importer, llvm::StringRef Name, const Position &Pos);
+};
+
+} // namespace north::serialization
+
+#endif // LIBNORTH_SERIALIZATION_INTERFACELOADER_H
@@ -0,0 +1,75 @@
+//===--- Serialization/ObjectCache.h - On-disk object cache -----*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// A directory of compiled modules: the object file and the interface of each,
+// named after the hash of everything they were built from. That's the source
+// of the module, the interfaces of the modules it opens, and the options which
+// name the compiler, the target and the flags. A hit saves the whole
+// compilation of the module.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_SERIALIZATION_OBJECTCACHE_H
+#define LIBNORTH_SERIALIZATION_OBJECTCACHE_H
+
+#include "Serialization/ASTFile.h"
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <atomic>
+#include <string>
+#include <utility>
+
+namespace north::serialization {
+
+/// Bumped on every change of the code generation, which invalidates the
+/// objects cached by former compilers.
+constexpr uint32_t ObjectCacheVersion = 1;
+
+class ObjectCache {
+  std::string Dir;
+  std::atomic<unsigned> Hits{0};
+  std::atomic<unsigned> Misses{0};
+
+public:
+  using Key = SourceHash;
+
+  /// A module opened, by name, and its interface.
+  using Import = std::pair<llvm::StringRef, llvm::StringRef>;
+
+  explicit ObjectCache(llvm::StringRef Dir) : Dir(Dir) {}
+
+  /// Hashes what a module is compiled from: \p Options, which must tell
+  /// apart the targets and flags producing different objects, \p Source and
+  /// the \p Imports, in any order. The compiler is accounted for by the LLVM
+  /// version and ObjectCacheVersion.
+  static Key getKey(llvm::StringRef Options, llvm::StringRef Source,
+                    llvm::ArrayRef<Import> Imports);
+
+  /// Copies the object cached for \p K to \p ObjectPath, and reads its
+  /// interface into \p Interface. Returns false, leaving \p Interface
+  /// untouched, on a miss.
+  bool load(const Key &K, llvm::StringRef ObjectPath, std::string &Interface);
+
+  /// Caches the object at \p ObjectPath and \p Interface for \p K. The
+  /// cache is only an optimization, so failures are ignored.
+  void store(const Key &K, llvm::StringRef ObjectPath,
+             llvm::StringRef Interface) const;
+
+  unsigned getHits() const { return Hits; }
+  unsigned getMisses() const { return Misses; }
+
+private:
+  std::string getPath(const Key &K, llvm::StringRef Extension) const;
+};
+
+} // namespace north::serialization
+
+#endif // LIBNORTH_SERIALIZATION_OBJECTCACHE_H
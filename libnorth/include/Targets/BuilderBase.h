@@ -10,7 +10,7 @@
 #ifndef LIBNORTH_TARGETS_BUILDER_H
 #define LIBNORTH_TARGETS_BUILDER_H
 
-#include "AST/Visitor.h"
+#include "AST/ASTVisitor.h"
 #include "Type/Module.h"
 #include "Type/Scope.h"
 
@@ -15,9 +15,8 @@
 
 namespace north::targets {
 
-class CBuilder : public ast::Visitor, BuilderBase {
+class CBuilder : public ast::ASTVisitor<CBuilder>, BuilderBase {
   std::unique_ptr<north::type::Module> Module;
-  type::Scope *CurrentScope;
   ast::FunctionDecl *CurrentFn;
 
   llvm::raw_fd_ostream outs;
@@ -26,11 +25,10 @@ class CBuilder : public ast::Visitor, BuilderBase {
 public:
   explicit CBuilder(north::type::Module *Module)
       : BuilderBase(Module),
-      CurrentScope(Module->getGlobalScope()),
       CurrentFn(nullptr),
       outs(Module->getModuleIdentifier() + ".c", EC) {}
 
-  AST_WALKER_METHODS
+  AST_WALKER_METHODS(void)
 };
 
 } // namespace north::targets
@@ -13,32 +13,79 @@
 #include "BuilderBase.h"
 #include "Type/Module.h"
 
+#include <llvm/ADT/DenseMap.h>
+
+#include <vector>
+
 namespace north::targets {
 
-class IRBuilder : public ast::Visitor, BuilderBase {
+class IRBuilder : public ast::ASTVisitor<IRBuilder, llvm::Value *>,
+                  BuilderBase {
+public:
+  /// The types typeInstance() found for the nodes of an instance's body.
+  using InstanceTypes = llvm::DenseMap<const ast::Node *, llvm::Type *>;
+
+private:
+  /// The module the IR goes to: the module built, or one of another context
+  /// receiving instances on a worker thread, see instantiateGenerics().
+  llvm::Module &Target;
+  llvm::LLVMContext &Context;
   llvm::IRBuilder<> Builder;
-  type::Scope *CurrentScope;
   ast::FunctionDecl *CurrentFn;
 
   bool GetVal = false;
   bool LoadArg = false;
 
-  static llvm::LLVMContext Context;
+  /// Set while an instance is emitted. Instances share their body's nodes,
+  /// so the types come from here and the values of the arguments and
+  /// variables are kept in Locals, rather than on the nodes.
+  const InstanceTypes *Types = nullptr;
+  llvm::DenseMap<const ast::VarDecl *, std::pair<llvm::Value *, llvm::Type *>>
+      Locals;
+  /// Types of the module built, and their counterparts in Context.
+  llvm::DenseMap<llvm::Type *, llvm::Type *> MappedTypes;
+
+  /// Emits instances of \p Module's generic functions into \p Target.
+  IRBuilder(type::Module *Module, llvm::Module &Target)
+      : BuilderBase(Module), Target(Target), Context(Target.getContext()),
+        Builder(Context), CurrentFn(nullptr) {}
 
 public:
   explicit IRBuilder(type::Module *Module)
-      : BuilderBase(Module), Builder(Context),
-        CurrentScope(Module->getGlobalScope()), CurrentFn(nullptr) {}
+      : IRBuilder(Module, *Module) {}
 
-  static llvm::LLVMContext &getContext() { return Context; }
+  /// Monomorphization: declares every distinct instance of the module's
+  /// generic functions and binds their call sites, then emits the bodies.
+  /// Must run before the module's own declarations are visited.
+  ///
+  /// The instances are typed one after another, then given \p Jobs above
+  /// one, their bodies are emitted side by side, a chunk of instances at a
+  /// time, each chunk into a module and context of its own, which is linked
+  /// back into this module. Returns false if that fails, which leaves the
+  /// module unusable.
+  bool instantiateGenerics(unsigned Jobs = 1);
 
-  AST_WALKER_METHODS
+  AST_WALKER_METHODS(llvm::Value *)
 
 private:
-  type::Type *getTypeFromIdent(ast::Node *);
+  /// Declares the instances and binds their call sites, see
+  /// instantiateGenerics(). The order only depends on the module's source.
+  std::vector<ast::FunctionDecl *> declareInstances();
+  /// Infers the types the body of the instance \p Fn needs, and reports
+  /// what doesn't match. Instances are typed one at a time, in this thread.
+  InstanceTypes typeInstance(ast::FunctionDecl &Fn);
+  /// Emits the body of \p Fn into Target, only reading its nodes.
+  void emitInstance(ast::FunctionDecl &Fn, const InstanceTypes &FnTypes);
+
+  /// The counterparts in Context of the module's types and functions.
+  llvm::Type *mapType(llvm::Type *T);
+  llvm::Function *getFunction(ast::FunctionDecl &Fn);
+  /// The value of \p Var, and its type.
+  std::pair<llvm::Value *, llvm::Type *> getVar(ast::VarDecl &Var);
+  void setVar(ast::VarDecl &Var, llvm::Value *Value, llvm::Type *Type);
+
   llvm::Value *cmpWithTrue(llvm::Value *);
-  llvm::Value *getStructField(ast::Node *, llvm::Value *,
-                              ast::QualifiedIdentifierExpr &);
+  llvm::Value *getStructField(llvm::Value *, ast::QualifiedIdentifierExpr &);
   llvm::Constant *createEscapedString(ast::LiteralExpr &);
 };
 
@@ -11,12 +11,19 @@
 #define LIBNORTH_TYPE_MODULE_H
 
 #include "AST/AST.h"
+#include "Grammar/Interner.h"
+#include "Grammar/LineTable.h"
 
-#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/ilist.h>
+#include <llvm/Support/Allocator.h>
 #include <llvm/IR/Module.h>
 #include <llvm/Support/SourceMgr.h>
 
+#include <memory>
+#include <vector>
+
 namespace north::ast {
 
 class GenericDecl;
@@ -27,53 +34,203 @@ class FunctionDecl;
 
 namespace north::type {
 
+class Module;
+class PrimitiveTypes;
 class Scope;
 class Type;
 
+/// Owns AST nodes: they live exactly as long as the arena. An arena is only
+/// ever used by one thread at a time, so a parser working on a part of the
+/// buffer fills its own arena and hands it to the module afterwards.
+class NodeArena {
+  llvm::BumpPtrAllocator Allocator;
+  std::vector<ast::Node *> Nodes;
+
+public:
+  NodeArena() = default;
+  NodeArena(const NodeArena &) = delete;
+  NodeArena &operator=(const NodeArena &) = delete;
+  ~NodeArena();
+
+  template <typename T, typename... ArgTypes> T *create(ArgTypes &&... Args) {
+    auto Node =
+        new (Allocator.Allocate<T>()) T(std::forward<ArgTypes>(Args)...);
+    Nodes.push_back(Node);
+    return Node;
+  }
+};
+
+/// Brings the declarations exported by an opened module into the module
+/// opening it. Modules without a loader record their imports and nothing
+/// else.
+class ModuleLoader {
+public:
+  virtual ~ModuleLoader() = default;
+
+  /// Registers the declarations exported by the module \p Import names in
+  /// \p Importer. Returns false, having reported why, if they can't be found.
+  virtual bool load(Module &Importer, ast::OpenStmt &Import) = 0;
+};
+
 class Module : public llvm::Module {
   using InterfaceDecl     = north::ast::InterfaceDecl;
-  using InterfaceListType = llvm::StringMap<InterfaceDecl *>;
-  using TypeListType      = llvm::StringMap<Type *>;
-  using FunctionListType  = llvm::StringMap<north::ast::FunctionDecl *>;
   using ImportListType    = std::vector<llvm::StringRef>;
 
+  /// Declarations indexed by the SymbolId of their name.
+  template <typename T> class SymbolTable {
+    std::vector<T *> Entries;
+
+  public:
+    T *lookup(SymbolId Id) const {
+      return Id < Entries.size() ? Entries[Id] : nullptr;
+    }
+
+    /// Returns false if \p Id is already taken.
+    bool insert(SymbolId Id, T *Entry, const Interner &Symbols) {
+      if (Id >= Entries.size())
+        Entries.resize(Symbols.size());
+      if (Entries[Id])
+        return false;
+      Entries[Id] = Entry;
+      return true;
+    }
+  };
+
+  Interner Symbols;
   Scope *GlobalScope;
-  InterfaceListType InterfaceList;
-  TypeListType TypeList;
-  FunctionListType FunctionList;
+  SymbolTable<InterfaceDecl> InterfaceList;
+  SymbolTable<Type> TypeList;
+  SymbolTable<north::ast::FunctionDecl> FunctionList;
   ImportListType ImportList;
-
-  llvm::simple_ilist<ast::Node> *AST = nullptr;
-
+  ModuleLoader *Loader = nullptr;
+  /// Set once the loader failed to load an opened module.
+  bool FailedImport = false;
+  /// Top-level declarations which came from another module's interface.
+  llvm::DenseSet<const ast::Node *> ImportedDecls;
+
+  /// Types are allocated here.
+  llvm::BumpPtrAllocator Allocator;
+  /// Every AST node of the module is allocated in one of these arenas and
+  /// lives exactly as long as the module.
+  NodeArena Nodes;
+  std::vector<std::unique_ptr<NodeArena>> AdoptedArenas;
+  llvm::simple_ilist<ast::Node> AST;
+
+  /// Uniquing table: one type::Type per distinct IR type, so inference
+  /// allocates only the first time it meets a type. Aliases don't take the
+  /// entry of the type they name, see Type.
+  llvm::DenseMap<llvm::Type *, Type *> UniqueTypes;
+  llvm::DenseMap<std::pair<ast::GenericDecl *, SymbolId>, Type *> ParamTypes;
+
+  /// Memoized inference results, see TypeInference.h. Those found within
+  /// a generic body depend on its instance and go to GenericBodyTypes
+  /// instead, which only lives as long as the instance.
+  llvm::DenseMap<const ast::Node *, Type *> InferredTypes;
+  llvm::DenseMap<const ast::Node *, Type *> GenericBodyTypes;
+  bool InGenericBody = false;
+
+  const PrimitiveTypes &Primitives;
   llvm::SourceMgr& SourceManager;
+  LineTable Lines;
   
   bool hasGenericDeclarations = false;
 
 public:
-  explicit Module(llvm::StringRef, llvm::LLVMContext &, llvm::SourceMgr &);
-
-  Type *getType(llvm::StringRef Name) const;
-  Type *getTypeOrNull(llvm::StringRef Name) const;
+  /// Builds the module of the main buffer of \p SourceMgr. \p Primitives
+  /// must be the table of \p C; CompilerInstance::createModule() pairs them.
+  Module(llvm::StringRef, llvm::LLVMContext &C, llvm::SourceMgr &SourceMgr,
+         const PrimitiveTypes &Primitives);
+  ~Module();
+
+  /// Constructs an AST node in the module's arena.
+  template <typename T, typename... ArgTypes> T *create(ArgTypes &&... Args) {
+    return Nodes.create<T>(std::forward<ArgTypes>(Args)...);
+  }
+
+  NodeArena &getArena() { return Nodes; }
+  /// Keeps the nodes of \p Arena alive as long as the module.
+  void adoptArena(std::unique_ptr<NodeArena> Arena) {
+    AdoptedArenas.push_back(std::move(Arena));
+  }
+
+  Interner &getInterner() { return Symbols; }
+  const PrimitiveTypes &getPrimitives() const { return Primitives; }
+
+  /// Reports \p Name undefined if it is, and returns i32 instead so that
+  /// the stage can go on to its end, see CompilerInstance.
+  Type *getType(SymbolId Name) const;
+  Type *getTypeOrNull(SymbolId Name) const;
+
+  /// Returns the unique type whose IR is \p IR, creating it on first use.
+  Type *getUniqueType(llvm::Type *IR);
+  Type *getPointerType(Type *Pointee);
+  Type *getArrayType(Type *Element, uint64_t Size);
+  /// Returns the type standing for generic parameter \p Param of \p Owner.
+  Type *getGenericParamType(ast::GenericDecl *Owner, SymbolId Param);
+
+  /// Makes a declared type the canonical owner of its IR type.
+  void registerType(Type *T);
+
+  Type *getInferredType(const ast::Node *N) const {
+    return (InGenericBody ? GenericBodyTypes : InferredTypes).lookup(N);
+  }
+  void setInferredType(const ast::Node *N, Type *T) {
+    (InGenericBody ? GenericBodyTypes : InferredTypes)[N] = T;
+  }
+
+  /// Brackets the inference of one instance of a generic body. Instances
+  /// share the body, so what is inferred in between is dropped on either
+  /// side, while the results for the rest of the module are kept.
+  void enterGenericBody() {
+    GenericBodyTypes.clear();
+    InGenericBody = true;
+  }
+  void leaveGenericBody() {
+    GenericBodyTypes.clear();
+    InGenericBody = false;
+  }
   
-  InterfaceDecl *getInterface(llvm::StringRef Name) const;
+  /// Returns the interface \p Name, or reports it undefined where it is
+  /// referred to, at \p Pos, and returns null.
+  InterfaceDecl *getInterface(SymbolId Name, const Position &Pos) const;
+  ast::FunctionDecl *lookupFunction(SymbolId Name) const {
+    return FunctionList.lookup(Name);
+  }
   
   ast::FunctionDecl *getFn(ast::CallExpr &Callee, Scope *S);
   
   const ImportListType& getImportList() const { return ImportList; }
 
+  void setLoader(ModuleLoader *NewLoader) { Loader = NewLoader; }
+  /// Whether an opened module couldn't be loaded, which was reported.
+  bool hasFailedImport() const { return FailedImport; }
+  bool isImported(const ast::Node *Decl) const {
+    return ImportedDecls.count(Decl);
+  }
+
   void addType(north::ast::GenericDecl *);
   void addInterface(north::ast::InterfaceDecl *);
-  void addFunction(north::ast::FunctionDecl *);
+  /// Registers \p Fn, and declares its IR unless \p CreateIR is false.
+  void addFunction(north::ast::FunctionDecl *, bool CreateIR = true);
+  /// Records the import, and loads the opened module's declarations if the
+  /// module has a loader; see hasFailedImport().
   void addImport(north::ast::OpenStmt *);
-  
-  void checkCall(ast::CallExpr *Callee);
+
+  /// Appends \p Decl to the AST, and registers it if it declares a type, an
+  /// interface or a function; see addFunction() for \p CreateIR.
+  void addDeclaration(ast::Node *Decl, bool CreateIR = true);
+  /// Same as addDeclaration(), for a declaration of another module.
+  void addImportedDeclaration(ast::Node *Decl);
 
   Scope *getGlobalScope() { return GlobalScope; }
 
-  void setAST(llvm::simple_ilist<ast::Node> *NewAST) { AST = NewAST; }
-  llvm::simple_ilist<ast::Node> *getAST() { return AST; }
+  llvm::simple_ilist<ast::Node> *getAST() { return &AST; }
 
   llvm::SourceMgr &getSourceManager() const { return SourceManager; }
+  const LineTable &getLineTable() const { return Lines; }
+
+  /// Maps \p Pos back into the module's source buffer for diagnostics.
+  llvm::SMRange getRange(const Position &Pos) const;
 };
 
 } // namespace north::type
@@ -13,7 +13,10 @@
 #include "Type/Module.h"
 
 #include <llvm/ADT/ArrayRef.h>
-#include <llvm/ADT/StringMap.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+
+#include <vector>
 
 namespace north::ast {
 
@@ -24,26 +27,37 @@ class VarDecl;
 
 namespace north::type {
 
+/// Variables visible at the current point of name resolution, kept as one
+/// flat table instead of a chain of per-block maps. Bindings are pushed in
+/// declaration order and popped when their block is left; the index maps a
+/// symbol to its innermost binding, so lookup doesn't depend on nesting.
 class Scope {
-  Scope *Parent;
-  llvm::StringMap<north::ast::VarDecl *> Vars;
-  uint8_t IndentLevel;
+  struct Binding {
+    SymbolId Symbol;
+    uint32_t Depth;
+    north::ast::VarDecl *Var;
+    /// Binding of the same symbol this one shadows, or NoBinding.
+    uint32_t Shadowed;
+  };
+  static constexpr uint32_t NoBinding = ~0u;
+
+  std::vector<Binding> Bindings;
+  llvm::DenseMap<SymbolId, uint32_t> Innermost;
+  /// Size of Bindings when each open block was entered.
+  llvm::SmallVector<uint32_t, 16> Blocks;
   type::Module *Owner;
 
 public:
-  explicit Scope(type::Module *Owner)
-      : Parent(nullptr), IndentLevel(0), Owner(Owner) {}
-  explicit Scope(Scope *Parent, type::Module *Owner)
-      : Parent(Parent), IndentLevel(Parent->getIndentLevel() + 1),
-        Owner(Owner) {}
-
-  Scope *getParent() { return Parent; }
-  void addElement(north::ast::VarDecl *Var);
-  uint8_t getIndentLevel() const { return IndentLevel; }
-  north::ast::VarDecl *lookup(llvm::StringRef Name);
-
-private:
-  north::ast::VarDecl *lookupParentScopes(llvm::StringRef Name);
+  explicit Scope(type::Module *Owner) : Owner(Owner) {}
+
+  void enterBlock() { Blocks.push_back(Bindings.size()); }
+  void leaveBlock();
+  uint32_t getDepth() const { return Blocks.size(); }
+
+  /// Returns false if a variable of the same name is already defined in
+  /// the current block.
+  bool addElement(north::ast::VarDecl *Var);
+  north::ast::VarDecl *lookup(SymbolId Name) const;
 };
 
 } // namespace north::type
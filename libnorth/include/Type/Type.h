@@ -16,7 +16,10 @@
 #include <llvm/Support/raw_ostream.h>
 
 namespace north::ast {
+class Node;
 class GenericDecl;
+class FunctionDecl;
+class VarDecl;
 } // namespace north::ast
 
 namespace north::type {
@@ -24,12 +27,27 @@ namespace north::type {
 class Module;
 class Scope;
 
+/// Types are uniqued by their module: every distinct type exists exactly
+/// once, so two types are equal iff they are the same object.
+///
+/// Distinct means distinct IR. Inference only sees the IR of values, so
+/// types with the same IR are one type to it: `char` is `i8`, and an alias
+/// is the type it names, as the structural comparison of types always had
+/// it. A declaration keeps its own object in the module's table of names,
+/// but the type inferred for its values is the one of its IR.
 class Type {
   ast::GenericDecl *Decl;
   llvm::Type *IRType;
   Module *Mod;
+  /// For a generic parameter: its name; Decl is the generic declaration.
+  SymbolId Param = InvalidSymbol;
   
-  explicit Type(llvm::Type *T) : Decl(nullptr), IRType(T) {}
+  explicit Type(llvm::Type *T) : Decl(nullptr), IRType(T), Mod(nullptr) {}
+  Type(ast::GenericDecl *Owner, SymbolId Param)
+      : Decl(Owner), IRType(nullptr), Mod(nullptr), Param(Param) {}
+
+  friend class Module;
+  friend class PrimitiveTypes;
 
 public:
   Type(ast::GenericDecl *TypeDecl, Module *Mod) : Decl(TypeDecl), IRType(nullptr), Mod(Mod) {
@@ -43,24 +61,30 @@ public:
   ast::GenericDecl *getDecl() { return Decl; }
 
   bool isPrimitive() { return !Decl; }
+  /// Generic parameters only exist while a generic body is checked and
+  /// have no IR.
+  bool isGenericParam() const { return Param != InvalidSymbol; }
+};
 
-  static Type *Void;
-  static Type *Int8;
-  static Type *Int16;
-  static Type *Int32;
-  static Type *Int64;
-  static Type *Float;
-  static Type *Double;
-  static Type *Char;
+/// The primitive types, whose IR belongs to one LLVMContext. Every module of
+/// a compilation shares the table of its context, see CompilerInstance.
+class PrimitiveTypes {
+  Type VoidTy, Int8Ty, Int16Ty, Int32Ty, Int64Ty, FloatTy, DoubleTy;
 
-  static Type *getArrayType(Type *, uint64_t);
-  
-  friend Type *inferFunctionType(ast::FunctionDecl &, Module *, Scope *);
-  friend Type *inferVarType(ast::VarDecl &, Module *, Scope *);
-  friend Type *inferExprType(ast::Node *, Module *, Scope *);
-  
-  bool operator==(const Type &) const;
-  bool operator!=(const Type &) const;
+public:
+  explicit PrimitiveTypes(llvm::LLVMContext &Context);
+  PrimitiveTypes(const PrimitiveTypes &) = delete;
+  PrimitiveTypes &operator=(const PrimitiveTypes &) = delete;
+
+  Type *const Void = &VoidTy;
+  Type *const Int8 = &Int8Ty;
+  Type *const Int16 = &Int16Ty;
+  Type *const Int32 = &Int32Ty;
+  Type *const Int64 = &Int64Ty;
+  Type *const Float = &FloatTy;
+  Type *const Double = &DoubleTy;
+  /// Same IR as i8, hence the same type, see Type.
+  Type *const Char = &Int8Ty;
 };
 
 } // namespace north::type
@@ -10,28 +10,50 @@
 #ifndef LIBNORTH_TYPE_TYPEINFERENCE_H
 #define LIBNORTH_TYPE_TYPEINFERENCE_H
 
-#include "AST/Visitor.h"
+#include "AST/ASTVisitor.h"
 #include "Type.h"
 
+#include <llvm/ADT/DenseMap.h>
+
 namespace north::type {
 
 class Module;
-class Scope;
 
-Type *inferFunctionType(ast::FunctionDecl &, Module *, Scope *);
-Type *inferVarType(ast::VarDecl &, Module *, Scope *);
-Type *inferExprType(ast::Node *, Module *, Scope *);
+/// Identifiers must already be resolved, see sema::Sema.
+Type *inferFunctionType(ast::FunctionDecl &, Module *);
+Type *inferVarType(ast::VarDecl &, Module *);
+Type *inferExprType(ast::Node *, Module *);
+
+/// Type-checks the body of \p Fn once for all of its instances, treating
+/// the generic parameters as opaque types that allow only the calls their
+/// bounds demand. Only done when every parameter is bounded by a defined
+/// interface; returns false if the body was not checked.
+bool checkGenericFunction(ast::GenericFunctionDecl &Fn, Module *);
+
+/// Whether \p T provides every function \p Interface requires. A generic
+/// parameter of the interface stands for \p T in the signatures.
+bool implementsInterface(Type *T, ast::InterfaceDecl *Interface, Module *);
 
 namespace detail {
 
-class InferenceVisitor : public ast::Visitor {
+class InferenceVisitor : public ast::ASTVisitor<InferenceVisitor, Type *> {
   Module *Mod;
-  Scope *CurrentScope;
+  /// Variables whose type doesn't come from their IR, i.e. ones typed by
+  /// generic parameters while a generic body is checked.
+  llvm::DenseMap<const ast::VarDecl *, Type *> Symbolic;
+
+  Type *typeOf(ast::VarDecl *Var);
 
 public:
-  explicit InferenceVisitor(Module *Mod, Scope *Scope)
-      : Mod(Mod), CurrentScope(Scope){};
-  AST_WALKER_METHODS
+  explicit InferenceVisitor(Module *Mod) : Mod(Mod) {}
+
+  /// Returns the type of \p N, computing it only if the module has not
+  /// annotated the node yet.
+  Type *infer(ast::Node &N);
+
+  void bind(const ast::VarDecl *Var, Type *T) { Symbolic[Var] = T; }
+
+  AST_WALKER_METHODS(Type *)
 };
 
 } // namespace detail
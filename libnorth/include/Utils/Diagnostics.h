@@ -0,0 +1,47 @@
+//===--- Utils/Diagnostics.h - Deferred diagnostics -------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LIBNORTH_UTILS_DIAGNOSTICS_H
+#define LIBNORTH_UTILS_DIAGNOSTICS_H
+
+#include <llvm/ADT/Twine.h>
+#include <llvm/Support/SourceMgr.h>
+
+#include <string>
+#include <vector>
+
+namespace north::utils {
+
+/// Diagnostics recorded by a worker thread. The SourceMgr and its handler
+/// are not thread-safe, so they are printed by the owner once the workers
+/// are done, in an order that doesn't depend on scheduling.
+class DiagnosticBuffer {
+  struct Entry {
+    llvm::SourceMgr::DiagKind Kind;
+    llvm::SMRange Range;
+    std::string Message;
+  };
+
+  std::vector<Entry> Entries;
+
+public:
+  void report(llvm::SMRange Range, llvm::SourceMgr::DiagKind Kind,
+              const llvm::Twine &Message) {
+    Entries.push_back({Kind, Range, Message.str()});
+  }
+
+  bool empty() const { return Entries.empty(); }
+
+  /// Prints the diagnostics in the order they were reported.
+  void flush(llvm::SourceMgr &SourceManager);
+};
+
+} // namespace north::utils
+
+#endif // LIBNORTH_UTILS_DIAGNOSTICS_H
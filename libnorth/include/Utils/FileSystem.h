@@ -10,11 +10,22 @@
 #ifndef LIBNORTH_UTILS_FILEMANAGER_H
 #define LIBNORTH_UTILS_FILEMANAGER_H
 
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
 
 namespace north::utils {
   
-llvm::SourceMgr *openFile(llvm::StringRef Path);
+/// Loads \p Path as the main buffer of \p SourceManager. Returns false,
+/// having printed why, if the file can't be read.
+bool openFile(llvm::StringRef Path, llvm::SourceMgr &SourceManager);
+
+/// Writes \p Path through \p Write into a temporary file of the same
+/// directory, which is renamed over \p Path only if \p Write returned true,
+/// so that readers never see a partial file. Returns false on failure.
+bool writeFileAtomically(
+    llvm::StringRef Path,
+    llvm::function_ref<bool(llvm::raw_ostream &)> Write);
 
 } // north::utils
 
@@ -9,6 +9,7 @@
 
 #include "AST/AST.h"
 #include "Type/Module.h"
+#include "Utils/Diagnostics.h"
 
 #include <llvm/ADT/Twine.h>
 #include <llvm/Support/FormatVariadic.h>
@@ -16,19 +17,24 @@
 
 namespace north::ast {
   
-void CallExpr::setCallableFn(FunctionDecl *Fn, type::Module *Module) {
+void CallExpr::setCallableFn(FunctionDecl *Fn, type::Module *Module,
+                             utils::DiagnosticBuffer *Diags) {
   assert(Fn);
   assert(Module);
+
+  auto Report = [&](llvm::SMRange Range, const llvm::Twine &Message) {
+    if (Diags)
+      return Diags->report(Range, llvm::SourceMgr::DiagKind::DK_Error, Message);
+    Module->getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
+                                            Message, Range);
+  };
   
   if (this->countOfArgs() != Fn->countOfArgs() && !Fn->isVarArg()) {
     auto Pos = this->getPosition();
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+    auto Range = Module->getRange(Pos);
 
-    Module->getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-        llvm::formatv("expected {0} args, not {1}", Fn->countOfArgs(), this->countOfArgs()), Range);
+    Report(Range, llvm::formatv("expected {0} args, not {1}", Fn->countOfArgs(), this->countOfArgs()));
   }
 
   for (size_t I = 0; I < this->countOfArgs(); ++I) {
@@ -40,12 +46,9 @@ void CallExpr::setCallableFn(FunctionDecl *Fn, type::Module *Module) {
         if (CallArg->ArgName == "") {
           auto FnPos = CallArg->Arg->getPosition();
 
-          auto Range = llvm::SMRange(
-              llvm::SMLoc::getFromPointer(FnPos.Offset),
-              llvm::SMLoc::getFromPointer(FnPos.Offset + FnPos.Length));
+          auto Range = Module->getRange(FnPos);
           
-          Module->getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                     "expected label `" + FnArg->getNamedArg() + "`", Range);
+          Report(Range, "expected label `" + FnArg->getNamedArg() + "`");
         }
 
         if (CallArg->ArgName != FnArg->getNamedArg()) {
@@ -55,8 +58,7 @@ void CallExpr::setCallableFn(FunctionDecl *Fn, type::Module *Module) {
               llvm::SMLoc::getFromPointer(Arg.data()),
               llvm::SMLoc::getFromPointer(Arg.data() + Arg.size()));
 
-          Module->getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                     "expected label `" + FnArg->getNamedArg() + "`", Range);
+          Report(Range, "expected label `" + FnArg->getNamedArg() + "`");
         }
       } else {
         if (CallArg->ArgName != "") {
@@ -66,8 +68,7 @@ void CallExpr::setCallableFn(FunctionDecl *Fn, type::Module *Module) {
               llvm::SMLoc::getFromPointer(Arg.data()),
               llvm::SMLoc::getFromPointer(Arg.data() + Arg.size()));
 
-          Module->getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                     "unexpected label `" + CallArg->ArgName + "`", Range);
+          Report(Range, "unexpected label `" + CallArg->ArgName + "`");
         }
       }
     }
@@ -30,13 +30,14 @@ FunctionDecl *GenericFunctionDecl::instantiate(ast::CallExpr *Callee,
   InstantiatedFn Fn;
   size_t CountOfArgs = this->countOfArgs();
 
-  // Infer generic types
+  // Infer generic types. The module memoizes the arguments' types, for as
+  // long as they hold, see Module::enterGenericBody().
   for (auto &Generic : this->getGenericsList()) {
     for (size_t I = 0; I < CountOfArgs; ++I) {
-      if (Generic.Name == this->getArg(I)->getType()->getIdentifier()) {
-        Generic.Type =
-            inferExprType(Callee->getArg(I)->Arg, Mod, Mod->getGlobalScope());
-        Fn.Types.push_back(Generic);
+      if (Generic.Symbol == this->getArg(I)->getType()->getSymbol()) {
+        Generic.Type = inferExprType(Callee->getArg(I)->Arg, Mod);
+        if (Generic.Type)
+          Fn.Types.push_back(Generic);
         break;
       }
     }
@@ -45,12 +46,12 @@ FunctionDecl *GenericFunctionDecl::instantiate(ast::CallExpr *Callee,
   // Was all generic types inferred?
   if (Fn.Types.size() < this->countOfGenerics()) {
     auto Args = Callee->getArgumentList();
-    auto Start = Args.front()->Arg->getPosition().Offset;
-    auto LastArg = Args.back()->Arg->getPosition();
-    auto End = LastArg.Offset + LastArg.Length;
+    auto Start = Args.empty() ? Callee->getPosition()
+                              : Args.front()->Arg->getPosition();
+    auto End = Args.empty() ? Start : Args.back()->Arg->getPosition();
 
-    auto Range = llvm::SMRange(llvm::SMLoc::getFromPointer(Start),
-                               llvm::SMLoc::getFromPointer(End));
+    auto Range = llvm::SMRange(Mod->getRange(Start).Start,
+                               Mod->getRange(End).End);
 
     Mod->getSourceManager().PrintMessage(Range.Start,
                                          llvm::SourceMgr::DiagKind::DK_Error,
@@ -59,15 +60,41 @@ FunctionDecl *GenericFunctionDecl::instantiate(ast::CallExpr *Callee,
     return nullptr;
   }
 
-  if (auto AlreadyInstantiated = this->isInstantiatedAlready(Fn.Types))
-    return AlreadyInstantiated;
+  TypeTuple Key;
+  for (auto &Generic : Fn.Types)
+    Key.push_back(Generic.Type);
 
-  Fn.Fn = new ast::FunctionDecl(*this);
+  auto [Instance, Inserted] = this->Instances.try_emplace(Key, nullptr);
+  if (!Inserted)
+    return Instance->second;
+
+  // Check the bounds, once per distinct instance
+  for (auto &Generic : Fn.Types) {
+    if (!Generic.isBounded())
+      continue;
+
+    auto Interface = Mod->getInterface(Generic.Bound, Generic.Pos);
+    if (!Interface)
+      return nullptr;
+    if (implementsInterface(Generic.Type, Interface, Mod))
+      continue;
+
+    auto Range = Mod->getRange(Callee->getPosition());
+    Mod->getSourceManager().PrintMessage(Range.Start,
+                                         llvm::SourceMgr::DiagKind::DK_Error,
+                                         "type of `" + Generic.Name +
+                                             "` doesn't implement `" +
+                                             Generic.BoundName + "`",
+                                         Range);
+    return nullptr;
+  }
+
+  Fn.Fn = Instance->second = Mod->create<ast::FunctionDecl>(*this);
   // Instantiate arguments
   for (size_t I = 0; I < CountOfArgs; ++I) {
     // TODO: handling errors
     auto FnArg = this->getArg(I);
-    if (auto T = this->containsGeneric(FnArg->getType()->getIdentifier());
+    if (auto T = this->containsGeneric(FnArg->getType()->getSymbol());
         T != -1) {
       auto &ArgType = Fn.Types[T].Type;
       Fn.Fn->instantiateGeneric(T, ArgType);
@@ -77,7 +104,7 @@ FunctionDecl *GenericFunctionDecl::instantiate(ast::CallExpr *Callee,
 
   // Instantiate return type
   if (auto RetType = Fn.Fn->getTypeDecl()) {
-    if (auto T = Fn.Fn->containsGeneric(RetType->getIdentifier()); T != -1) {
+    if (auto T = Fn.Fn->containsGeneric(RetType->getSymbol()); T != -1) {
       auto Generic = Fn.Fn->getGeneric(T).Type;
       Fn.Fn->setTypeIR(Generic->getIR());
     }
@@ -89,36 +116,6 @@ FunctionDecl *GenericFunctionDecl::instantiate(ast::CallExpr *Callee,
   return Fn.Fn;
 }
 
-FunctionDecl *GenericFunctionDecl::isInstantiatedAlready(
-    llvm::ArrayRef<GenericDecl::Generic> TypeList) const {
-
-  for (auto Fn : this->InstantiatedFunctions) {
-    if (Fn.Types.size() != TypeList.size())
-      continue;
-
-    bool IsInstantiatedAlready = true;
-
-    for (auto &Generic : Fn.Types) {
-      IsInstantiatedAlready = true;
-
-      for (auto &IGeneric : TypeList) {
-        if (*Generic.Type != *IGeneric.Type) {
-          IsInstantiatedAlready = false;
-          break;
-        }
-      }
-
-      if (IsInstantiatedAlready)
-        break;
-    }
-
-    if (IsInstantiatedAlready)
-      return Fn.Fn;
-  }
-
-  return nullptr;
-}
-
 namespace {
 
 llvm::GlobalValue::LinkageTypes getLinkageType(north::ast::FunctionDecl *Fn) {
@@ -136,11 +133,11 @@ void FunctionDecl::createIR(type::Module *Module) {
   if (auto ReturnType = this->getTypeIR()) {
     ResultType = ReturnType;
   } else if (auto ReturnType = this->getTypeDecl()) {
-    ResultType = Module->getType(ReturnType->getIdentifier())->getIR();
+    ResultType = Module->getType(ReturnType->getSymbol())->getIR();
     if (ReturnType->isPtr())
       ResultType = ResultType->getPointerTo(0);
   } else {
-    ResultType = type::Type::Void->getIR();
+    ResultType = Module->getPrimitives().Void->getIR();
   }
 
   std::vector<llvm::Type *> ArgList;
@@ -153,7 +150,7 @@ void FunctionDecl::createIR(type::Module *Module) {
         ArgList.push_back(ArgType);
       } else {
         auto Argument =
-            Module->getType(Arg->getType()->getIdentifier())->getIR();
+            Module->getType(Arg->getType()->getSymbol())->getIR();
         ArgList.push_back(Arg->getType()->isPtr() ? Argument->getPointerTo(0)
                                                   : Argument);
       }
@@ -164,16 +161,17 @@ void FunctionDecl::createIR(type::Module *Module) {
     FnType = llvm::FunctionType::get(ResultType, this->isVarArg());
   }
 
-  auto IR = llvm::Function::Create(FnType, getLinkageType(this),
+  this->IR = llvm::Function::Create(FnType, getLinkageType(this),
                                    this->getIdentifier(), *Module);
+  bindArguments();
+}
 
-  for (auto &IrArg : IR->args()) {
+void FunctionDecl::bindArguments() {
+  for (auto &IrArg : getIR()->args()) {
     auto AstArg = this->getArg(IrArg.getArgNo());
     AstArg->setIRType(IrArg.getType());
     AstArg->setIRValue(&IrArg);
   }
-
-  this->IR = IR;
 }
 
 } // namespace north::ast
@@ -14,7 +14,7 @@ namespace north::ast {
 bool QualifiedIdentifierExpr::operator==(const QualifiedIdentifierExpr &RHS) const {
   if (this->getSize() == RHS.getSize()) {
     for (size_t I = 0; I < this->getSize(); ++I)
-      if (this->getPart(I) != RHS.getPart(I))
+      if (this->getSymbol(I) != RHS.getSymbol(I))
         return false;
     return true;
   }
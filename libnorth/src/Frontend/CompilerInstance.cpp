@@ -0,0 +1,39 @@
+//===--- Frontend/CompilerInstance.cpp - One compilation --------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Frontend/CompilerInstance.h"
+
+#include <mutex>
+
+namespace north {
+
+CompilerInstance::CompilerInstance() : Primitives(Context) {
+  SourceManager.setDiagHandler(
+      [](const llvm::SMDiagnostic &Diag, void *Instance) {
+        if (Diag.getKind() == llvm::SourceMgr::DK_Error)
+          ++static_cast<CompilerInstance *>(Instance)->Errors;
+
+        // Modules compiled in parallel may report at once; one prints at a
+        // time.
+        static std::mutex PrintLock;
+        std::lock_guard<std::mutex> Lock(PrintLock);
+        Diag.print("", llvm::errs());
+      },
+      this);
+}
+
+CompilerInstance::~CompilerInstance() = default;
+
+type::Module &CompilerInstance::createModule(llvm::StringRef Name) {
+  Modules.push_back(std::make_unique<type::Module>(Name, Context,
+                                                   SourceManager, Primitives));
+  return *Modules.back();
+}
+
+} // namespace north
@@ -0,0 +1,230 @@
+//===--- Frontend/ImportGraph.cpp - Modules of a build ----------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Frontend/ImportGraph.h"
+#include "Grammar/Interner.h"
+#include "Grammar/Lexer.h"
+#include "Serialization/InterfaceLoader.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SourceMgr.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace north {
+
+using namespace llvm;
+
+/// Extension of the sources `open` statements refer to.
+static constexpr const char *SourceExtension = ".n";
+
+bool ImportGraph::addInput(StringRef Path) {
+  return addModule(sys::path::stem(Path), Path) >= 0;
+}
+
+int ImportGraph::lookup(StringRef Name) const {
+  auto It = Index.find(Name);
+  return It == Index.end() ? -1 : int(It->second);
+}
+
+std::string ImportGraph::findSource(StringRef Name, StringRef Importer) {
+  auto Find = [&](StringRef Dir) {
+    SmallString<128> Path(Dir);
+    sys::path::append(Path, Name + SourceExtension);
+    return sys::fs::is_regular_file(Path) ? std::string(Path.str())
+                                          : std::string();
+  };
+
+  auto Path = Find(sys::path::parent_path(Importer));
+  for (auto I = SearchPath.begin(), E = SearchPath.end();
+       Path.empty() && I != E; ++I)
+    Path = Find(*I);
+  return Path;
+}
+
+int ImportGraph::addModule(StringRef Name, StringRef Path) {
+  auto Known = Index.find(Name);
+  if (Known != Index.end()) {
+    auto &Module = Modules[Known->second];
+    if (Module.Path == Path || sys::fs::equivalent(Module.Path, Path))
+      return Known->second;
+    Errs << "error: two modules are named '" << Name << "': " << Module.Path
+         << " and " << Path << '\n';
+    return -1;
+  }
+
+  auto Buffer = MemoryBuffer::getFile(Path);
+  if (!Buffer) {
+    Errs << Path << ": " << Buffer.getError().message() << '\n';
+    return -1;
+  }
+
+  unsigned Id = Modules.size();
+  Modules.push_back({std::string(Name), std::string(Path), {}, {}});
+  Index[Name] = Id;
+
+  // Lexical errors are left for the compilation of the module to report.
+  SourceMgr SourceManager;
+  SourceManager.setDiagHandler([](const SMDiagnostic &, void *) {});
+  SourceManager.AddNewSourceBuffer(std::move(*Buffer), SMLoc());
+
+  Interner Symbols;
+  auto Tokens = Lexer(SourceManager).tokenize(Symbols);
+
+  bool Failed = false;
+  for (size_t I = 0; I + 1 < Tokens.size(); ++I) {
+    if (Tokens.getKind(I) != Token::Open ||
+        Tokens.getKind(I + 1) != Token::Identifier)
+      continue;
+
+    auto Import = Symbols.getName(Tokens.getSymbol(I + 1));
+    // A module opening itself is let be, as its loader does.
+    if (Import == Name)
+      continue;
+
+    auto Source = findSource(Import, Path);
+    if (Source.empty()) {
+      if (!InterfaceDir.empty() &&
+          sys::fs::exists(serialization::InterfaceLoader::getPath(InterfaceDir,
+                                                                  Import)))
+        continue;
+
+      auto Loc = SMLoc::getFromPointer(Tokens.get(I + 1).getPointer());
+      SourceManager
+          .GetMessage(Loc, SourceMgr::DK_Error,
+                      "can't find module '" + Import + "'")
+          .print("", Errs);
+      Failed = true;
+      continue;
+    }
+
+    int ImportId = addModule(Import, Source);
+    if (ImportId < 0) {
+      Failed = true;
+      continue;
+    }
+
+    auto &Imports = Modules[Id].Imports;
+    if (is_contained(Imports, unsigned(ImportId)))
+      continue;
+    Imports.push_back(ImportId);
+    Modules[ImportId].Importers.push_back(Id);
+  }
+
+  return Failed ? -1 : int(Id);
+}
+
+bool ImportGraph::checkCycles() {
+  enum class State { Unvisited, Visiting, Done };
+  std::vector<State> States(Modules.size(), State::Unvisited);
+  std::vector<unsigned> Stack;
+
+  std::function<bool(unsigned)> Visit = [&](unsigned Id) {
+    if (States[Id] == State::Done)
+      return true;
+
+    if (States[Id] == State::Visiting) {
+      Errs << "error: modules open each other:";
+      auto Begin = std::find(Stack.begin(), Stack.end(), Id);
+      for (auto I = Begin; I != Stack.end(); ++I)
+        Errs << ' ' << Modules[*I].Name << " ->";
+      Errs << ' ' << Modules[Id].Name << '\n';
+      return false;
+    }
+
+    States[Id] = State::Visiting;
+    Stack.push_back(Id);
+    for (auto Import : Modules[Id].Imports)
+      if (!Visit(Import))
+        return false;
+    Stack.pop_back();
+    States[Id] = State::Done;
+    return true;
+  };
+
+  for (unsigned Id = 0; Id < Modules.size(); ++Id)
+    if (!Visit(Id))
+      return false;
+  return true;
+}
+
+bool ImportGraph::compile(unsigned Jobs, function_ref<bool(unsigned)> Export,
+                          function_ref<bool(unsigned)> Complete) {
+  struct Task {
+    unsigned Id;
+    bool Exports;
+  };
+
+  std::mutex Lock;
+  std::condition_variable Changed;
+  std::deque<Task> Ready;
+  /// Tasks queued or running; the workers are done once there are none.
+  size_t Pending = 0;
+  bool Failed = false;
+
+  // Exports go first, since they are what the other modules wait for.
+  std::vector<unsigned> Unexported(Modules.size());
+  for (unsigned Id = 0; Id < Modules.size(); ++Id) {
+    Unexported[Id] = Modules[Id].Imports.size();
+    if (!Unexported[Id]) {
+      Ready.push_back({Id, true});
+      ++Pending;
+    }
+  }
+
+  auto Work = [&] {
+    std::unique_lock<std::mutex> Guard(Lock);
+    while (true) {
+      Changed.wait(Guard, [&] { return !Ready.empty() || !Pending; });
+      if (Ready.empty())
+        return;
+
+      auto Current = Ready.front();
+      Ready.pop_front();
+
+      Guard.unlock();
+      bool Done = Current.Exports ? Export(Current.Id) : Complete(Current.Id);
+      Guard.lock();
+
+      --Pending;
+      if (!Done) {
+        Failed = true;
+      } else if (Current.Exports) {
+        Ready.push_back({Current.Id, false});
+        ++Pending;
+        for (auto Importer : Modules[Current.Id].Importers) {
+          if (--Unexported[Importer])
+            continue;
+          Ready.push_front({Importer, true});
+          ++Pending;
+        }
+      }
+      Changed.notify_all();
+    }
+  };
+
+  std::vector<std::thread> Workers;
+  for (unsigned I = 1; I < std::min<size_t>(Jobs, Modules.size()); ++I)
+    Workers.emplace_back(Work);
+  Work();
+  for (auto &Worker : Workers)
+    Worker.join();
+
+  return !Failed;
+}
+
+} // namespace north
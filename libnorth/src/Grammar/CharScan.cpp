@@ -0,0 +1,241 @@
+//===--- Grammar/CharScan.cpp - Vectorized character class scans -*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Grammar/CharScan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__) &&        \
+    (defined(__GNUC__) || defined(__clang__))
+#define NORTH_SCAN_X86 1
+#include <immintrin.h>
+#define NORTH_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace north::scan {
+
+namespace {
+
+#ifdef NORTH_SCAN_X86
+
+__m128i inRange(__m128i V, char Lo, char Hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(V, _mm_set1_epi8(Lo - 1)),
+                       _mm_cmplt_epi8(V, _mm_set1_epi8(Hi + 1)));
+}
+
+__m128i isOneOf(__m128i V, char A, char B) {
+  return _mm_or_si128(_mm_cmpeq_epi8(V, _mm_set1_epi8(A)),
+                      _mm_cmpeq_epi8(V, _mm_set1_epi8(B)));
+}
+
+__m128i negate(__m128i V) {
+  return _mm_xor_si128(V, _mm_set1_epi8(-1));
+}
+
+NORTH_AVX2 __m256i inRange(__m256i V, char Lo, char Hi) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(V, _mm256_set1_epi8(Lo - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(Hi + 1), V));
+}
+
+NORTH_AVX2 __m256i isOneOf(__m256i V, char A, char B) {
+  return _mm256_or_si256(_mm256_cmpeq_epi8(V, _mm256_set1_epi8(A)),
+                         _mm256_cmpeq_epi8(V, _mm256_set1_epi8(B)));
+}
+
+NORTH_AVX2 __m256i negate(__m256i V) {
+  return _mm256_xor_si256(V, _mm256_set1_epi8(-1));
+}
+
+#endif
+
+// Every character class provides a scalar predicate and, on x86, the same
+// predicate over a vector of bytes, which yields 0xFF for every byte that
+// belongs to the run and 0x00 for every byte that ends it.
+
+struct Blank {
+  static bool in(char C) { return C == ' ' || C == '\t' || C == '\r'; }
+
+#ifdef NORTH_SCAN_X86
+  static __m128i in(__m128i V) {
+    return _mm_or_si128(isOneOf(V, ' ', '\t'),
+                        _mm_cmpeq_epi8(V, _mm_set1_epi8('\r')));
+  }
+
+  NORTH_AVX2 static __m256i in(__m256i V) {
+    return _mm256_or_si256(isOneOf(V, ' ', '\t'),
+                           _mm256_cmpeq_epi8(V, _mm256_set1_epi8('\r')));
+  }
+#endif
+};
+
+struct IdentifierChar {
+  static bool in(char C) {
+    return (C >= 'a' && C <= 'z') || (C >= 'A' && C <= 'Z') ||
+           (C >= '0' && C <= '9') || C == '_';
+  }
+
+#ifdef NORTH_SCAN_X86
+  // Setting the 0x20 bit folds 'A'...'Z' onto 'a'...'z' and moves no other
+  // character into that range.
+  static __m128i in(__m128i V) {
+    auto Lower = _mm_or_si128(V, _mm_set1_epi8(0x20));
+    return _mm_or_si128(
+        _mm_or_si128(inRange(Lower, 'a', 'z'), inRange(V, '0', '9')),
+        _mm_cmpeq_epi8(V, _mm_set1_epi8('_')));
+  }
+
+  NORTH_AVX2 static __m256i in(__m256i V) {
+    auto Lower = _mm256_or_si256(V, _mm256_set1_epi8(0x20));
+    return _mm256_or_si256(
+        _mm256_or_si256(inRange(Lower, 'a', 'z'), inRange(V, '0', '9')),
+        _mm256_cmpeq_epi8(V, _mm256_set1_epi8('_')));
+  }
+#endif
+};
+
+struct Digit {
+  static bool in(char C) { return C >= '0' && C <= '9'; }
+
+#ifdef NORTH_SCAN_X86
+  static __m128i in(__m128i V) { return inRange(V, '0', '9'); }
+  NORTH_AVX2 static __m256i in(__m256i V) { return inRange(V, '0', '9'); }
+#endif
+};
+
+struct LineBody {
+  static bool in(char C) { return C != '\n' && C != '\0'; }
+
+#ifdef NORTH_SCAN_X86
+  static __m128i in(__m128i V) { return negate(isOneOf(V, '\n', '\0')); }
+  NORTH_AVX2 static __m256i in(__m256i V) {
+    return negate(isOneOf(V, '\n', '\0'));
+  }
+#endif
+};
+
+struct StringBody {
+  static bool in(char C) { return C != '"' && C != '\0'; }
+
+#ifdef NORTH_SCAN_X86
+  static __m128i in(__m128i V) { return negate(isOneOf(V, '"', '\0')); }
+  NORTH_AVX2 static __m256i in(__m256i V) {
+    return negate(isOneOf(V, '"', '\0'));
+  }
+#endif
+};
+
+template <typename Class>
+const char *scanScalar(const char *Ptr, const char *End) {
+  while (Ptr != End && Class::in(*Ptr))
+    ++Ptr;
+  return Ptr;
+}
+
+#ifdef NORTH_SCAN_X86
+
+template <typename Class>
+const char *scanSSE2(const char *Ptr, const char *End) {
+  for (; End - Ptr >= 16; Ptr += 16) {
+    auto V = _mm_loadu_si128(reinterpret_cast<const __m128i *>(Ptr));
+    unsigned Mask = ~_mm_movemask_epi8(Class::in(V)) & 0xFFFF;
+    if (Mask)
+      return Ptr + __builtin_ctz(Mask);
+  }
+  return scanScalar<Class>(Ptr, End);
+}
+
+template <typename Class>
+NORTH_AVX2 const char *scanAVX2(const char *Ptr, const char *End) {
+  for (; End - Ptr >= 32; Ptr += 32) {
+    auto V = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Ptr));
+    unsigned Mask = ~static_cast<unsigned>(_mm256_movemask_epi8(Class::in(V)));
+    if (Mask)
+      return Ptr + __builtin_ctz(Mask);
+  }
+  return scanSSE2<Class>(Ptr, End);
+}
+
+#endif
+
+using ScanFn = const char *(*)(const char *, const char *);
+
+struct Scanners {
+  ScanFn Blanks;
+  ScanFn Identifier;
+  ScanFn Digits;
+  ScanFn LineEnd;
+  ScanFn StringEnd;
+};
+
+#define SCANNERS(IMPL)                                                         \
+  Scanners {                                                                   \
+    IMPL<Blank>, IMPL<IdentifierChar>, IMPL<Digit>, IMPL<LineBody>,            \
+        IMPL<StringBody>                                                       \
+  }
+
+Scanners selectScanners() {
+#ifdef NORTH_SCAN_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return SCANNERS(scanAVX2);
+  return SCANNERS(scanSSE2);
+#else
+  return SCANNERS(scanScalar);
+#endif
+}
+
+#undef SCANNERS
+
+const Scanners Impl = selectScanners();
+
+} // namespace
+
+const char *skipBlanks(const char *Ptr, const char *End) {
+  return Impl.Blanks(Ptr, End);
+}
+
+const char *skipIdentifier(const char *Ptr, const char *End) {
+  return Impl.Identifier(Ptr, End);
+}
+
+const char *skipDigits(const char *Ptr, const char *End) {
+  return Impl.Digits(Ptr, End);
+}
+
+const char *findLineEnd(const char *Ptr, const char *End) {
+  return Impl.LineEnd(Ptr, End);
+}
+
+const char *findStringEnd(const char *Ptr, const char *End) {
+  return Impl.StringEnd(Ptr, End);
+}
+
+namespace scalar {
+
+const char *skipBlanks(const char *Ptr, const char *End) {
+  return scanScalar<Blank>(Ptr, End);
+}
+
+const char *skipIdentifier(const char *Ptr, const char *End) {
+  return scanScalar<IdentifierChar>(Ptr, End);
+}
+
+const char *skipDigits(const char *Ptr, const char *End) {
+  return scanScalar<Digit>(Ptr, End);
+}
+
+const char *findLineEnd(const char *Ptr, const char *End) {
+  return scanScalar<LineBody>(Ptr, End);
+}
+
+const char *findStringEnd(const char *Ptr, const char *End) {
+  return scanScalar<StringBody>(Ptr, End);
+}
+
+} // namespace scalar
+
+} // namespace north::scan
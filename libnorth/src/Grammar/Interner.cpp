@@ -0,0 +1,26 @@
+//===--- Grammar/Interner.cpp - Identifier interning ------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Grammar/Interner.h"
+
+namespace north {
+
+SymbolId Interner::intern(llvm::StringRef Name) {
+  auto Inserted = Ids.try_emplace(Name, Names.size());
+  if (Inserted.second)
+    Names.push_back(Inserted.first->getKey());
+  return Inserted.first->second;
+}
+
+SymbolId Interner::lookup(llvm::StringRef Name) const {
+  auto Found = Ids.find(Name);
+  return Found != Ids.end() ? Found->second : InvalidSymbol;
+}
+
+} // namespace north
@@ -18,36 +18,15 @@
 /// IDENTIFIER = CHAR | '_' { SYMBOL };
 
 #include "Grammar/Lexer.h"
+#include "Grammar/CharScan.h"
 
 namespace north {
 
-namespace {
-
-struct Keyword {
-  const char *Keyword;
-  unsigned char Length;
-  Token KwToken;
-};
-
-#define KW_COUNT 14
-const Keyword Keywords[KW_COUNT] = {
-    {"def", 3, Token::Def},       {"else", 4, Token::Else},
-    {"for", 3, Token::For},       {"if", 2, Token::If},
-    {"in", 2, Token::In},         {"interface", 9, Token::Interface},
-    {"let", 3, Token::Let},       {"nil", 3, Token::Nil},
-    {"open", 4, Token::Open},     {"return", 6, Token::Return},
-    {"switch", 6, Token::Switch}, {"type", 4, Token::Type},
-    {"var", 3, Token::Var},       {"while", 5, Token::While}};
-
-} // namespace
-
 Lexer::Lexer(llvm::SourceMgr& SourceMgr) : SourceManager(SourceMgr) {
   Buffer = SourceManager.getMemoryBuffer(1)->getBufferStart();
   BufferEnd = SourceManager.getMemoryBuffer(1)->getBufferEnd();
 
-  Pos.Offset = Buffer;
-  Pos.Column = 1;
-  Pos.Line = 1;
+  Ptr = Buffer;
 }
 
 void Lexer::skipWhitespace() {
@@ -55,17 +34,14 @@ void Lexer::skipWhitespace() {
     return;
 
   while (true) {
-    switch (*Pos.Offset) {
+    switch (*Ptr) {
     case '\n':
     __new_line:
-      ++Pos.Offset;
-      ++Pos.Line;
+      ++Ptr;
 
-      if (*Pos.Offset == '\n')
+      if (*Ptr == '\n')
         goto __new_line;
 
-      Pos.Column = 1;
-
       if (getFlagState(IndentationSensitive)) {
         NewLine = true;
         return;
@@ -75,10 +51,10 @@ void Lexer::skipWhitespace() {
 
     case ' ':
     case '\t':
-    case '\r':
-      ++Pos.Offset;
-      ++Pos.Column;
+    case '\r': {
+      Ptr = scan::skipBlanks(Ptr + 1, BufferEnd);
       continue;
+    }
 
     default:
       return;
@@ -87,44 +63,35 @@ void Lexer::skipWhitespace() {
 }
 
 Token Lexer::keywordOrIdentifier() {
-  if (Pos.Length < 2 || Pos.Length > 9)
-    return Token::Identifier;
+  return lookupKeyword(llvm::StringRef(Ptr, Length));
+}
 
-  for (uint8_t i = 0; i != KW_COUNT; ++i) {
-    if (Pos.Length == Keywords[i].Length) {
-      if (strncmp(Keywords[i].Keyword, Pos.Offset, Pos.Length) == 0)
-        return Keywords[i].KwToken;
-    }
-  }
-  return Token::Identifier;
+Position Lexer::getPosition() const {
+  return Position{static_cast<uint32_t>(Ptr - Buffer), Length};
 }
 
 TokenInfo Lexer::makeToken(Token Tok) {
-  TokenInfo result{Pos, Tok};
-  Pos.Column += Pos.Length;
-  Pos.Offset += Pos.Length;
-  return result;
+  TokenInfo Result{getPosition(), Tok, InvalidSymbol, Buffer};
+  Ptr += Length;
+  return Result;
 }
 
-TokenInfo Lexer::makeToken(Token Tok, uint8_t Length) {
-  Pos.Length = Length;
-  TokenInfo Result{Pos, Tok};
-  Pos.Column += Pos.Length;
-  Pos.Offset += Pos.Length;
-  return Result;
+TokenInfo Lexer::makeToken(Token Tok, uint8_t TokLength) {
+  Length = TokLength;
+  return makeToken(Tok);
 }
 
 TokenInfo Lexer::makeEof() {
   if (IndentLevel)
-    return TokenInfo{Pos, Token::Dedent};
-  return TokenInfo{Pos, Token::Eof};
+    return TokenInfo{getPosition(), Token::Dedent, InvalidSymbol, Buffer};
+  return TokenInfo{getPosition(), Token::Eof, InvalidSymbol, Buffer};
 }
 
 uint8_t Lexer::checkIndentLevel() {
   uint8_t I = 0, NecessaryIndent = IndentLevel * 2;
 
   for (; I != NecessaryIndent; ++I)
-    if (Pos.Offset[I] != ' ')
+    if (Ptr[I] != ' ')
       return 0;
 
   return I;
@@ -136,13 +103,12 @@ TokenInfo Lexer::getNextToken() {
   skipWhitespace();
 
   if (NewLine) {
-    if (auto Length = checkIndentLevel()) {
+    if (auto Indent = checkIndentLevel()) {
       NewLine = false;
       if (getFlagState(IndentationSensitive))
-        return makeToken(Token::Indent, Length);
-      Pos.Length = Length;
-      Pos.Column += Length;
-      Pos.Offset += Length;
+        return makeToken(Token::Indent, Indent);
+      Length = Indent;
+      Ptr += Indent;
     } else {
       if (IndentLevel)
         return makeToken(Token::Dedent, 0);
@@ -152,31 +118,85 @@ TokenInfo Lexer::getNextToken() {
     goto __start;
   }
 
-  Pos.Length = 0;
+  auto Tok = lexToken();
+  if (Tok.Type == Token::Comment && !Flags[YieldComments])
+    goto __start;
+  return Tok;
+}
 
-  if (isalpha(*Pos.Offset)) {
-    while (isalnum(Pos.Offset[++Pos.Length]) || Pos.Offset[Pos.Length] == '_')
-      ;
+TokenStream Lexer::tokenize(Interner &Symbols) {
+  assert(Ptr == Buffer && !IndentLevel && "lexer was already used");
 
-    return makeToken(keywordOrIdentifier());
+  TokenStream Tokens(Buffer);
+  Tokens.reserve((BufferEnd - Buffer) / 4 + 1);
+
+  while (true) {
+    switch (*Ptr) {
+    case '\n':
+      // Lines holding nothing but blanks or a comment are skipped, the
+      // marker is placed on the next line with code on it.
+      while (true) {
+        do
+          ++Ptr;
+        while (*Ptr == '\n');
+
+        for (Length = 0; Ptr[Length] == ' '; ++Length)
+          ;
+        auto Rest = scan::skipBlanks(Ptr + Length, BufferEnd);
+        if (*Rest == '#')
+          Rest = scan::findLineEnd(Rest + 1, BufferEnd);
+        if (*Rest != '\n')
+          break;
+        Ptr = Rest;
+      }
+      Tokens.push({getPosition(), Token::Newline});
+      continue;
+
+    case ' ':
+    case '\t':
+    case '\r': {
+      Ptr = scan::skipBlanks(Ptr + 1, BufferEnd);
+      continue;
+    }
+    }
+
+    auto Tok = lexToken();
+    if (Tok.Type == Token::Comment)
+      continue;
+
+    // Errors are reported by lexToken and end the stream as well.
+    if (Tok.Type == Token::Eof) {
+      Length = 0;
+      Tokens.push({getPosition(), Token::Eof});
+      return Tokens;
+    }
+
+    if (Tok.Type == Token::Identifier)
+      Tok.Symbol = Symbols.intern(Tok.toString());
+    Tokens.push(Tok);
   }
+}
 
-  if (isdigit(*Pos.Offset)) {
-    while (isdigit(Pos.Offset[++Pos.Length]))
-      ;
+TokenInfo Lexer::lexToken() {
+  Length = 0;
 
+  if (isalpha(*Ptr)) {
+    Length = scan::skipIdentifier(Ptr + 1, BufferEnd) - Ptr;
+    return makeToken(keywordOrIdentifier());
+  }
+
+  if (isdigit(*Ptr)) {
+    Length = scan::skipDigits(Ptr + 1, BufferEnd) - Ptr;
     return makeToken(Token::Int);
   }
 
-  switch (*Pos.Offset) {
+  switch (*Ptr) {
   case '"': {
-    do {
-      ++Pos.Length;
-      if (Pos.Offset[Pos.Length] == '\0')
-        return makeEof();
-    } while (Pos.Offset[Pos.Length] != '"');
+    auto End = scan::findStringEnd(Ptr + 1, BufferEnd);
+    if (*End != '"')
+      return makeEof();
 
-    ++Pos.Length;
+    Length = End - Ptr + 1;
     return makeToken(Token::String);
   }
 
@@ -184,37 +204,22 @@ TokenInfo Lexer::getNextToken() {
     return makeToken(Token::Char, 3);
 
   case '_': {
-    if (Pos.Offset[1] == '_' || isalpha(Pos.Offset[1])) {
-      do {
-        ++Pos.Length;
-      } while (Pos.Offset[Pos.Length] == '_' ||
-          isalnum(Pos.Offset[Pos.Length]));
-
+    if (Ptr[1] == '_' || isalpha(Ptr[1])) {
+      Length =
+          scan::skipIdentifier(Ptr + 1, BufferEnd) - Ptr;
       return makeToken(keywordOrIdentifier());
     }
     return makeToken(Token::Wildcard, 1);
   }
 
-  case '#':
-    do {
-      ++Pos.Length;
-      if (Pos.Offset[Pos.Length] == '\0')
-        return makeEof();
-    } while (Pos.Offset[Pos.Length] != '\n');
-
-    ++Pos.Length;
-    ++Pos.Line;
-
-    if (Flags[YieldComments]) {
-      return makeToken(Token::Comment);
-    } else {
-      Pos.Column += Pos.Length;
-      Pos.Offset += Pos.Length;
-      goto __start;
-    }
+  case '#': {
+    // The line break is left to end the line the comment is on.
+    Length = scan::findLineEnd(Ptr + 1, BufferEnd) - Ptr;
+    return makeToken(Token::Comment);
+  }
 
   case '/': {
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::DivAssign, 2);
     return makeToken(Token::Div, 1);
   }
@@ -235,8 +240,8 @@ TokenInfo Lexer::getNextToken() {
     return makeToken(Token::RBrace, 1);
 
   case '.': {
-    if (Pos.Offset[1] == '.') {
-      if (Pos.Offset[2] == '.')
+    if (Ptr[1] == '.') {
+      if (Ptr[2] == '.')
         return makeToken(Token::Ellipsis, 3);
       return makeToken(Token::DotDot, 2);
     }
@@ -244,7 +249,7 @@ TokenInfo Lexer::getNextToken() {
   }
 
   case '=': {
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::Eq, 2);
     return makeToken(Token::Assign, 1);
   }
@@ -257,78 +262,79 @@ TokenInfo Lexer::getNextToken() {
     return makeToken(Token::Semicolon, 1);
 
   case '*':
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::MultAssign, 2);
     return makeToken(Token::Mult, 1);
   case '+':
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::PlusAssign, 2);
-    if (Pos.Offset[1] == '+')
+    if (Ptr[1] == '+')
       return makeToken(Token::Increment, 2);
     return makeToken(Token::Plus, 1);
   case '-':
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::MinusAssign, 2);
-    if (Pos.Offset[1] == '>')
+    if (Ptr[1] == '>')
       return makeToken(Token::RightArrow, 2);
-    if (Pos.Offset[1] == '-')
+    if (Ptr[1] == '-')
       return makeToken(Token::Decrement, 2);
     return makeToken(Token::Minus, 1);
 
   case '&': {
-    if (Pos.Offset[1] == '&')
+    if (Ptr[1] == '&')
       return makeToken(Token::AndAnd, 2);
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::AndAssign, 2);
     return makeToken(Token::And, 1);
   }
 
   case '|': {
-    if (Pos.Offset[1] == '|')
+    if (Ptr[1] == '|')
       return makeToken(Token::OrOr, 2);
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::OrAssign, 2);
     return makeToken(Token::Or, 1);
   }
 
   case '>': {
-    if (Pos.Offset[1] == '>') {
-      if (Pos.Offset[2] == '=')
+    if (Ptr[1] == '>') {
+      if (Ptr[2] == '=')
         return makeToken(Token::RShiftAssign, 3);
       return makeToken(Token::RShift, 2);
     }
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::GreaterEq, 2);
     return makeToken(Token::GreaterThan, 1);
   }
 
   case '<': {
-    if (Pos.Offset[1] == '<') {
-      if (Pos.Offset[2] == '=')
+    if (Ptr[1] == '<') {
+      if (Ptr[2] == '=')
         return makeToken(Token::LShiftAssign, 3);
       return makeToken(Token::LShift, 2);
     }
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::LessEq, 2);
     return makeToken(Token::LessThan, 1);
   }
 
   case '!':
-    if (Pos.Offset[1] == '=')
+    if (Ptr[1] == '=')
       return makeToken(Token::NotEq, 2);
     return makeToken(Token::Not, 1);
   }
 
-  if (*Pos.Offset == '\0' || Pos.Offset >= BufferEnd)
+  if (*Ptr == '\0' || Ptr >= BufferEnd)
     return makeEof();
 
 
   auto Range = llvm::SMRange(
-      llvm::SMLoc::getFromPointer(Pos.Offset),
-      llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+      llvm::SMLoc::getFromPointer(Ptr),
+      llvm::SMLoc::getFromPointer(Ptr + Length));
   SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-      "unexpected char '" + llvm::Twine(*Pos.Offset) + "\'", Range);
+      "unexpected char '" + llvm::Twine(*Ptr) + "\'", Range);
 
+  Failed = true;
   return {};
 }
 
@@ -0,0 +1,39 @@
+//===--- Grammar/LineTable.cpp - Offset to line/column mapping --*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Grammar/LineTable.h"
+#include "Grammar/CharScan.h"
+
+#include <algorithm>
+
+namespace north {
+
+void LineTable::build() const {
+  auto Begin = Buffer.begin(), End = Buffer.end();
+
+  LineStarts.reserve(Buffer.size() / 32 + 1);
+  LineStarts.push_back(0);
+
+  // findLineEnd also stops at '\0', which does not start a new line.
+  for (auto Ptr = scan::findLineEnd(Begin, End); Ptr != End;
+       Ptr = scan::findLineEnd(Ptr + 1, End)) {
+    if (*Ptr == '\n')
+      LineStarts.push_back(Ptr + 1 - Begin);
+  }
+}
+
+LineAndColumn LineTable::getLineAndColumn(uint32_t Offset) const {
+  std::call_once(Built, [this] { build(); });
+
+  auto Next = std::upper_bound(LineStarts.begin(), LineStarts.end(), Offset);
+  auto Line = Next - LineStarts.begin();
+  return {static_cast<unsigned>(Line), Offset - LineStarts[Line - 1] + 1};
+}
+
+} // namespace north
@@ -9,7 +9,12 @@
 
 #include "Grammar/Parser.h"
 
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/Parallel.h>
+
+#include <memory>
 
 namespace north {
 
@@ -17,48 +22,110 @@ using llvm::Function;
 using llvm::FunctionType;
 using llvm::Type;
 
-Token Parser::nextToken() {
-  if (!Peeked) {
-    Buf[0] = Lex.getNextToken();
-  } else {
-    Buf[0] = Buf[1];
-    Peeked = false;
+Token Parser::advance(Cursor &C) const {
+  // A parse stops at its first error.
+  if (Failed)
+    return C.Kind = Token::Eof;
+
+  while (true) {
+    auto Kind = Tokens.getKind(C.Next);
+
+    if (!C.NewLine && Kind == Token::Newline) {
+      if (!C.IndentationSensitive) {
+        ++C.Next;
+        continue;
+      }
+      C.NewLine = true;
+    }
+
+    C.Current = C.Next;
+
+    if (C.NewLine) {
+      // A line continues the block if it is indented at least as deep as the
+      // block. Otherwise the line break stays pending and yields a dedent
+      // until enough blocks are closed.
+      unsigned Width = C.IndentLevel * 2;
+      if (Width && Tokens.getLength(C.Next) >= Width) {
+        C.NewLine = false;
+        ++C.Next;
+        if (C.IndentationSensitive)
+          return C.Kind = Token::Indent;
+        continue;
+      }
+
+      if (C.IndentLevel)
+        return C.Kind = Token::Dedent;
+
+      C.NewLine = false;
+      ++C.Next;
+      continue;
+    }
+
+    if (Kind == Token::Eof)
+      return C.Kind = C.IndentLevel ? Token::Dedent : Token::Eof;
+
+    ++C.Next;
+    return C.Kind = Kind;
   }
-  return Buf[0].Type;
 }
 
-Token Parser::peekToken() {
-  if (!Peeked) {
-    Buf[1] = Lex.getNextToken();
-    Peeked = true;
-  }
+Token Parser::nextToken() {
+  return advance(Cur);
+}
+
+Token Parser::peekToken(unsigned Distance) const {
+  auto C = Cur;
+  auto Kind = Cur.Kind;
+  while (Distance--)
+    Kind = advance(C);
+  return Kind;
+}
+
+TokenInfo Parser::current() const {
+  auto Tok = Tokens.get(Cur.Current);
+  Tok.Type = Cur.Kind;
+
+  if (Cur.Kind == Token::Indent)
+    Tok.Pos.Length = Cur.IndentLevel * 2;
+  else if (Cur.Kind == Token::Dedent)
+    Tok.Pos.Length = 0;
+
+  return Tok;
+}
 
-  return Buf[1].Type;
+llvm::SMRange Parser::getRange(const Position &Pos) const {
+  auto Start = Tokens.getBuffer() + Pos.Offset;
+  return llvm::SMRange(llvm::SMLoc::getFromPointer(Start),
+                       llvm::SMLoc::getFromPointer(Start + Pos.Length));
 }
 
 bool Parser::match(Token With) {
-  if (peekToken() == With) {
-    nextToken();
-    return true;
-  }
-  return false;
+  auto C = Cur;
+  if (advance(C) != With)
+    return false;
+
+  Cur = C;
+  return true;
 }
 
 void Parser::expect(Token What) {
   if (!match(What)) {
     nextToken();
 
-    auto Pos = Buf[0].Pos;
+    error(llvm::formatv("expected {0}, found {1}\n", tokenToString(What),
+                        tokenToString(Cur.Kind)));
+  }
+}
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-    auto Msg = llvm::formatv("expected {0}, found {1}\n", tokenToString(What),
-                             tokenToString(Buf[0].Type));
+void Parser::error(const llvm::Twine &Message) {
+  bool Report = !Tentative && !Failed;
+  Failed = true;
+  if (!Report)
+    return;
 
-    Lex.getSourceManager().PrintMessage(Range.Start,
-        llvm::SourceMgr::DiagKind::DK_Error, Msg, Range);
-  }
+  auto Range = getRange(current().Pos);
+  Lex.getSourceManager().PrintMessage(
+      Range.Start, llvm::SourceMgr::DiagKind::DK_Error, Message, Range);
 }
 
 bool Parser::tryParseLiteral() {
@@ -170,65 +237,143 @@ static const Precedence PrecedenceTable[] = {
     Binary, // LShift,
 
     None, // RightArrow
+
+    None, // Newline
 };
 
 uint8_t getTokenPrec(Token Tok) {
   return PrecedenceTable[static_cast<uint8_t>(Tok)];
 }
 
+/// Buffers with fewer tokens are parsed serially.
+constexpr size_t ParallelParseThreshold = 1 << 16;
+/// How many tokens each part of a buffer parsed in parallel has, at least.
+constexpr size_t TokensPerPart = 1 << 14;
+
 } // namespace
 
+void Parser::parse() {
+  // Lazy mode follows the calls across the whole buffer, so it stays serial.
+  if (!LazyBodies && Tokens.size() >= ParallelParseThreshold &&
+      parseInParallel())
+    return;
+
+  // A declaration cut short by an error is left out, half-built.
+  while (auto Decl = parseTopLevelDecl()) {
+    if (Failed)
+      break;
+    addDeclaration(Decl);
+  }
+
+  if (LazyBodies && !Failed)
+    parseReferencedBodies();
+}
+
+bool Parser::parseInParallel() {
+  // A declaration keyword at the start of an unindented line begins a
+  // top-level item, which parses the same whatever precedes it.
+  auto BeginsItem = [&](uint32_t I) {
+    switch (Tokens.getKind(I)) {
+    case Token::Def:
+    case Token::Type:
+    case Token::Interface:
+    case Token::Var:
+    case Token::Open:
+      return Tokens.getKind(I - 1) == Token::Newline &&
+             Tokens.getLength(I - 1) == 0;
+    default:
+      return false;
+    }
+  };
+
+  struct Part {
+    uint32_t Begin = 0;
+    uint32_t End = 0;
+    std::unique_ptr<type::NodeArena> Arena = nullptr;
+    std::vector<ast::Node *> Decls = {};
+    bool Failed = false;
+  };
+
+  std::vector<Part> Parts;
+  uint32_t Begin = 0;
+  uint32_t Eof = Tokens.size() - 1;
+  for (uint32_t I = TokensPerPart; I < Eof; ++I) {
+    if (!BeginsItem(I))
+      continue;
+    Parts.push_back({Begin, I});
+    Begin = I;
+    I += TokensPerPart - 1;
+  }
+  Parts.push_back({Begin, Eof});
+
+  if (Parts.size() < 2)
+    return false;
+
+  llvm::parallelForEachN(size_t(0), Parts.size(), [&](size_t I) {
+    auto &Part = Parts[I];
+    Part.Arena = std::make_unique<type::NodeArena>();
+
+    Parser PartParser(Lex, Module, Tokens.slice(Part.Begin, Part.End),
+                      *Part.Arena);
+    while (auto Decl = PartParser.parseTopLevelDecl())
+      Part.Decls.push_back(Decl);
+    Part.Failed = PartParser.Failed;
+  });
+
+  // The serial parse reports the errors, exactly as it would have without
+  // this attempt.
+  if (llvm::any_of(Parts, [](const Part &P) { return P.Failed; }))
+    return false;
+
+  for (auto &Part : Parts) {
+    for (auto Decl : Part.Decls)
+      addDeclaration(Decl);
+    Module->adoptArena(std::move(Part.Arena));
+  }
+  return true;
+}
+
 /// toplevel = { openStmt
 ///            | typeDefinition
 ///            | functionDecl
 ///            | interfaceDecl
 ///            | varDecl };
-void Parser::parse() {
-  auto Tree = new llvm::simple_ilist<ast::Node>();
-
+ast::Node *Parser::parseTopLevelDecl() {
   while (true) {
     switch (nextToken()) {
     case Token::Open:
-      Tree->push_back(*parseOpenStmt());
-      break;
+      return parseOpenStmt();
 
     case Token::Type:
-      Tree->push_back(*parseTypeDefinition());
-      break;
+      return parseTypeDefinition();
 
     case Token::Def:
-      Tree->push_back(*parseFunctionDecl());
-      break;
+      return parseFunctionDecl();
 
     case Token::Interface:
-      Tree->push_back(*parseInterfaceDecl());
-      break;
+      return parseInterfaceDecl();
 
     case Token::Var:
-      Tree->push_back(*parseVarDecl());
-      break;
+      return parseVarDecl();
 
     case Token::Eof:
-      Module->setAST(Tree);
-      return;
+      return nullptr;
 
     default:
-      auto Pos = Buf[0].Pos;
-
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-      Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-          "unexpected char '" + llvm::StringRef(Pos.Offset, 1) + llvm::StringRef("\'"), Range);
+      error("unexpected char '" + llvm::StringRef(current().getPointer(), 1) + llvm::StringRef("\'"));
     }
   }
 }
 
+void Parser::addDeclaration(ast::Node *Decl) {
+  // In lazy mode the IR is only created for functions found reachable.
+  Module->addDeclaration(Decl, !LazyBodies);
+}
+
 /// openStmt = 'open' IDENTIFIER;
 ast::OpenStmt *Parser::parseOpenStmt() {
   expect(Token::Identifier);
-  return new ast::OpenStmt(Buf[0].Pos, Buf[0].toString());
+  return Arena.create<ast::OpenStmt>(current().Pos, current().toString());
 }
 
 /// typeDefinition =
@@ -241,7 +386,7 @@ ast::OpenStmt *Parser::parseOpenStmt() {
 ///         | rangeExpr );
 ast::GenericDecl *Parser::parseTypeDefinition() {
   expect(Token::Identifier);
-  auto Result = new ast::TypeDef(Buf[0]);
+  auto Result = Arena.create<ast::TypeDef>(current());
 
   parseGenericTypeList(Result);
 
@@ -280,17 +425,9 @@ ast::GenericDecl *Parser::parseTypeDefinition() {
     break;
 
   default:
-    auto Pos = Buf[0].Pos;
-
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-    Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                        "invalid type declaration", Range);
+    error("invalid type declaration");
   }
 
-  Module->addType(Result);
   return Result;
 }
 
@@ -316,14 +453,7 @@ ast::GenericDecl *Parser::parseTypeDecl() {
     return parseTupleDecl();
 
   default:
-    auto Pos = Buf[0].Pos;
-
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-    Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                        "invalid type declaration", Range);
+    error("invalid type declaration");
   }
 
   return nullptr;
@@ -331,7 +461,7 @@ ast::GenericDecl *Parser::parseTypeDecl() {
 
 /// aliasDecl = IDENTIFIER { '.' IDENTIFIER } genericTypeList;
 ast::AliasDecl *Parser::parseAliasDecl(bool IsPtr) {
-  auto Alias = new ast::AliasDecl(Buf[0].Pos, Buf[0].toString());
+  auto Alias = Arena.create<ast::AliasDecl>(current());
   if (IsPtr)
     Alias->setModifier(ast::GenericDecl::Ptr);
   parseGenericTypeList(Alias);
@@ -340,7 +470,7 @@ ast::AliasDecl *Parser::parseAliasDecl(bool IsPtr) {
 
 /// structDecl = '{' varDecl { ',' varDecl } '}';
 ast::StructDecl *Parser::parseStructDecl() {
-  auto Struct = new ast::StructDecl(Buf[0].Pos);
+  auto Struct = Arena.create<ast::StructDecl>(current().Pos);
 
   while (auto Var = parseVarDecl()) {
     Struct->addField(Var);
@@ -355,20 +485,13 @@ ast::StructDecl *Parser::parseStructDecl() {
 
 /// unionDecl = '|' IDENTIFIER { '|' IDENTIFIER };
 ast::UnionDecl *Parser::parseUnionDecl() {
-  auto Union = new ast::UnionDecl(Buf[0]);
+  auto Union = Arena.create<ast::UnionDecl>(current());
 
   do {
     if (auto Type = parseTypeDecl()) {
       Union->addField(Type);
     } else {
-      auto Pos = Buf[0].Pos;
-
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-      Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                          "invalid union declaration: unexpected " + Buf[0].toString(), Range);
+      error("invalid union declaration: unexpected " + current().toString());
     }
   } while (match(Token::Or));
 
@@ -378,12 +501,12 @@ ast::UnionDecl *Parser::parseUnionDecl() {
 /// enumDecl = (IDENTIFIER { ',' IDENTIFIER })
 ///          | rangeDecl;
 ast::EnumDecl *Parser::parseEnumDecl() {
-  auto Enum = new ast::EnumDecl(Buf[0]);
+  auto Enum = Arena.create<ast::EnumDecl>(current());
 
   // TODO: range decl in enum
   while (match(Token::Comma)) {
     expect(Token::Identifier);
-    Enum->addMember(Buf[0]);
+    Enum->addMember(current());
   }
 
   return Enum;
@@ -391,20 +514,13 @@ ast::EnumDecl *Parser::parseEnumDecl() {
 
 /// tupleDecl = '(' IDENTIFIER { ',' IDENTIFIER } ')';
 ast::TupleDecl *Parser::parseTupleDecl() {
-  auto Tuple = new ast::TupleDecl(Buf[0]);
+  auto Tuple = Arena.create<ast::TupleDecl>(current());
 
   do {
     if (auto Member = parseVarDecl()) {
       Tuple->addMember(Member);
     } else {
-      auto Pos = Buf[0].Pos;
-
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-      Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                          "invalid tuple declaration: unexpected " + Buf[0].toString(), Range);
+      error("invalid tuple declaration: unexpected " + current().toString());
     }
   } while (match(Token::Comma));
 
@@ -415,7 +531,7 @@ ast::TupleDecl *Parser::parseTupleDecl() {
 
 /// rangeDecl = 'type' IDENTIFIER '=' rangeExpr;
 ast::RangeDecl *Parser::parseRangeDecl() {
-  auto Ranges = new ast::RangeDecl(Buf[0]);
+  auto Ranges = Arena.create<ast::RangeDecl>(current());
 
   do {
     Ranges->addRange(parseRangeExpr());
@@ -431,20 +547,20 @@ ast::RangeDecl *Parser::parseRangeDecl() {
 ///           functionSignature { '\n' functionSignature };
 ast::InterfaceDecl *Parser::parseInterfaceDecl() {
   expect(Token::Identifier);
-  auto Interface = new ast::InterfaceDecl(Buf[0]);
+  auto Interface = Arena.create<ast::InterfaceDecl>(current());
   parseGenericTypeList(Interface);
 
   if (match(Token::Colon)) {
     expect(Token::Identifier);
-    auto Parent = new ast::InterfaceDecl(Buf[0]);
+    auto Parent = Arena.create<ast::InterfaceDecl>(current());
     parseGenericTypeList(Interface);
     Interface->setParent(Parent);
   }
 
   expect(Token::Assign);
 
-  Lex.incrementIndentLevel();
-  Lex.turnFlag(Lexer::IndentationSensitive, true);
+  ++Cur.IndentLevel;
+  Cur.IndentationSensitive = true;
 
   while (match(Token::Indent)) {
     expect(Token::Def);
@@ -452,8 +568,8 @@ ast::InterfaceDecl *Parser::parseInterfaceDecl() {
   }
 
   expect(Token::Dedent);
-  Lex.decrementIndentLevel();
-  Lex.turnFlag(Lexer::IndentationSensitive, false);
+  --Cur.IndentLevel;
+  Cur.IndentationSensitive = false;
 
   return Interface;
 }
@@ -475,13 +591,16 @@ ast::Node *Parser::parseExpression(uint8_t Prec, bool SkipCurrentToken) {
 ast::Node *Parser::parsePrefix() {
   ast::Node *Res = nullptr;
 
-  switch (Buf[0].Type) {
+  switch (Cur.Kind) {
   case Token::Mult:
   case Token::Not:
   case Token::Minus:
   case Token::Increment:
   case Token::Decrement:
-    return new ast::UnaryExpr(Buf[0], Buf[0].Type, parseExpression(Unary));
+  {
+    auto Op = current();
+    return Arena.create<ast::UnaryExpr>(Op, Op.Type, parseExpression(Unary));
+  }
 
   case Token::Identifier:
     if (peekToken() == Token::Dot)
@@ -495,21 +614,15 @@ ast::Node *Parser::parsePrefix() {
   case Token::Int:
   case Token::String:
   case Token::Nil:
-    return new ast::LiteralExpr(Buf[0]);
+    return Arena.create<ast::LiteralExpr>(current());
 
   case Token::If:
     return parseIfExpr();
 
   case Token::Else:
     if (!LastIfNode) {
-      auto Pos = Buf[0].Pos;
-
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-      Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                          "else without if", Range);
+      error("else without if");
+      return nullptr;
     }
     LastIfNode->setElseBranch(parseIfExpr(true));
     LastIfNode = LastIfNode->getElseBranch();
@@ -539,7 +652,9 @@ ast::Node *Parser::parsePrefix() {
 }
 
 ast::Node *Parser::parseInfix(ast::Node *LHS) {
-  switch (Buf[0].Type) {
+  auto Op = current();
+
+  switch (Op.Type) {
   case Token::LParen:
     return parseCallExpr(LHS);
 
@@ -566,8 +681,8 @@ ast::Node *Parser::parseInfix(ast::Node *LHS) {
   case Token::Plus:
   case Token::Minus:
   case Token::Or:
-    return new ast::BinaryExpr(Buf[0], LHS, Buf[0].Type,
-                               parseExpression(getTokenPrec(Buf[0].Type)));
+    return Arena.create<ast::BinaryExpr>(Op, LHS, Op.Type,
+                               parseExpression(getTokenPrec(Op.Type)));
 
   case Token::Assign:
   case Token::DivAssign:
@@ -578,8 +693,8 @@ ast::Node *Parser::parseInfix(ast::Node *LHS) {
   case Token::OrAssign:
   case Token::RShiftAssign:
   case Token::LShiftAssign:
-    return new ast::AssignExpr(Buf[0], LHS, Buf[0].Type,
-                               parseExpression(getTokenPrec(Buf[0].Type)));
+    return Arena.create<ast::AssignExpr>(Op, LHS, Op.Type,
+                               parseExpression(getTokenPrec(Op.Type)));
 
   default:
     return nullptr;
@@ -588,7 +703,7 @@ ast::Node *Parser::parseInfix(ast::Node *LHS) {
 
 /// structInitExpr = IDENTIFIER '{' expr { ',' expr } '}';
 ast::StructInitExpr *Parser::parseStructInitExpr(ast::Node *Ident) {
-  auto Expr = new ast::StructInitExpr(Ident);
+  auto Expr = Arena.create<ast::StructInitExpr>(Ident);
 
   do {
     Expr->addValue(parseExpression());
@@ -603,30 +718,32 @@ ast::CallExpr *Parser::parseCallExpr(ast::Node *Ident) {
   ast::CallExpr *Callee = nullptr;
 
   if (auto Identifier = llvm::dyn_cast<ast::QualifiedIdentifierExpr>(Ident)) {
-    Callee = new ast::CallExpr(Identifier);
+    Callee = Arena.create<ast::CallExpr>(Identifier);
+    if (LazyBodies)
+      References.push_back(Identifier->getSymbol(0));
   } else if (auto Literal = llvm::dyn_cast<ast::LiteralExpr>(Ident)) {
-    Callee = new ast::CallExpr(new ast::QualifiedIdentifierExpr(Literal->getTokenInfo()));
+    Callee = Arena.create<ast::CallExpr>(Arena.create<ast::QualifiedIdentifierExpr>(Literal->getTokenInfo()));
+    if (LazyBodies)
+      References.push_back(Literal->getTokenInfo().Symbol);
   } else {
-    auto Pos = Buf[0].Pos;
-
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-    Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                        "invalid call expression", Range);
+    error("invalid call expression");
+    return nullptr;
   }
 
   if (peekToken() != Token::RParen) {
     while (true) {
-      if (match(Token::Identifier) && peekToken() == Token::Colon) {
-        auto Name = Buf[0].toString();
+      llvm::StringRef Name;
+      if (peekToken() == Token::Identifier && peekToken(2) == Token::Colon) {
+        nextToken();
+        Name = current().toString();
         nextToken();
-        Callee->addArgument(parseExpression(), Name);
-      } else {
-        Callee->addArgument(parseExpression(0, Buf[0].Type != Token::Identifier));
       }
 
+      auto Arg = parseExpression();
+      if (Failed)
+        return nullptr;
+      Callee->addArgument(Arg, Name);
+
       if (!match(Token::Comma))
         break;
     }
@@ -634,26 +751,17 @@ ast::CallExpr *Parser::parseCallExpr(ast::Node *Ident) {
 
   expect(Token::RParen);
 
-  Module->checkCall(Callee);
-  
   return Callee;
 }
 
 /// arrayIndexExpr = IDENTIFIER '[' expr ']';
 ast::ArrayIndexExpr *Parser::parseArrayIndexExpr(ast::Node *Ident) {
-  auto Idx = new ast::ArrayIndexExpr(Ident);
+  auto Idx = Arena.create<ast::ArrayIndexExpr>(Ident);
 
   if (auto Expr = parseExpression()) {
     Idx->setIdxExpr(Expr);
   } else {
-    auto Pos = Buf[0].Pos;
-
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-    Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                        "invalid array index", Range);
+    error("invalid array index");
   }
 
   expect(Token::RBracket);
@@ -662,11 +770,11 @@ ast::ArrayIndexExpr *Parser::parseArrayIndexExpr(ast::Node *Ident) {
 
 /// qualifiedIdentifier = IDENTIFIER '.' IDENTIFIER { '.' IDENTIFIER };
 ast::QualifiedIdentifierExpr *Parser::parseQualifiedIdentifier() {
-  auto Ident = new ast::QualifiedIdentifierExpr(Buf[0]);
+  auto Ident = Arena.create<ast::QualifiedIdentifierExpr>(current());
 
   while (match(Token::Dot)) {
     expect(Token::Identifier);
-    Ident->AddPart(Buf[0]);
+    Ident->AddPart(current());
   }
 
   return Ident;
@@ -674,18 +782,19 @@ ast::QualifiedIdentifierExpr *Parser::parseQualifiedIdentifier() {
 
 /// forExpr = 'for' literalExpr 'in' expr ':' blockStmt;
 ast::ForExpr *Parser::parseForExpr() {
-  auto *Loop = new ast::ForExpr(Buf[0]);
+  auto *Loop = Arena.create<ast::ForExpr>(current());
 
   // TODO: use parseExpression()
   if (tryParseLiteral()) {
-    Loop->setIter(new ast::LiteralExpr(Buf[0]));
+    Loop->setIter(Arena.create<ast::LiteralExpr>(current()));
+    Loop->setIterVar(Arena.create<ast::VarDecl>(current(), true));
     expect(Token::In);
 
     if (tryParseLiteral()) {
       if (peekToken() == Token::DotDot)
         Loop->setRange(parseRangeExpr());
-      else if (Buf[0].Type == Token::Identifier)
-        Loop->setRange(new ast::LiteralExpr(Buf[0]));
+      else if (Cur.Kind == Token::Identifier)
+        Loop->setRange(Arena.create<ast::LiteralExpr>(current()));
       else
         goto __error;
     } else {
@@ -698,21 +807,15 @@ ast::ForExpr *Parser::parseForExpr() {
     return Loop;
   } else {
   __error:
-    auto Pos = Buf[0].Pos;
-
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-    Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                        "invalid for expression: unexpected " + Buf[0].toString(), Range);
+    error("invalid for expression: unexpected " + current().toString());
     return nullptr;
   }
 }
 
 /// whileExpr = 'while' expr ':' blockStmt;
 ast::WhileExpr *Parser::parseWhileExpr() {
-  auto Loop = new ast::WhileExpr(Buf[0], parseExpression());
+  auto Tok = current();
+  auto Loop = Arena.create<ast::WhileExpr>(Tok, parseExpression());
   expect(Token::Colon);
   Loop->setBlock(parseBlockStmt());
 
@@ -722,11 +825,10 @@ ast::WhileExpr *Parser::parseWhileExpr() {
 /// ifExpr = 'if' expr ':' blockStmt
 ///        { 'else' ['if' expr] ':' blockStmt };
 ast::IfExpr *Parser::parseIfExpr(bool isElse) {
-  ast::IfExpr *If = nullptr;
-
-  If = isElse
-      ? new ast::IfExpr(Buf[0], match(Token::If) ? parseExpression() : nullptr)
-      : new ast::IfExpr(Buf[0], parseExpression());
+  auto Tok = current();
+  auto If = isElse
+      ? Arena.create<ast::IfExpr>(Tok, match(Token::If) ? parseExpression() : nullptr)
+      : Arena.create<ast::IfExpr>(Tok, parseExpression());
 
   expect(Token::Colon);
   If->setBlock(parseBlockStmt());
@@ -737,20 +839,14 @@ ast::IfExpr *Parser::parseIfExpr(bool isElse) {
 
 /// rangeExpr = literalExpr '..' literalExpr;
 ast::RangeExpr *Parser::parseRangeExpr() {
-  auto Range = new ast::RangeExpr(Buf[0]);
+  auto Range = Arena.create<ast::RangeExpr>(
+      Arena.create<ast::LiteralExpr>(current()));
   expect(Token::DotDot);
 
   if (tryParseLiteral()) {
-    Range->setEndValue(new ast::LiteralExpr(Buf[0]));
+    Range->setEndValue(Arena.create<ast::LiteralExpr>(current()));
   } else {
-    auto Pos = Buf[0].Pos;
-
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-    Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                        "invalid range expression: unexpected " + Buf[0].toString(), Range);
+    error("invalid range expression: unexpected " + current().toString());
   }
 
   return Range;
@@ -758,9 +854,9 @@ ast::RangeExpr *Parser::parseRangeExpr() {
 
 /// arrayExpr = '[' expr { ',' expr } ']';
 ast::ArrayExpr *Parser::parseArrayExpr() {
-  auto Array = new ast::ArrayExpr(Buf[0]);
+  auto Array = Arena.create<ast::ArrayExpr>(current());
 
-  Lex.turnFlag(Lexer::IndentationSensitive, false);
+  Cur.IndentationSensitive = false;
 
   while (auto Val = parseExpression()) {
     Array->addValue(Val);
@@ -770,17 +866,10 @@ ast::ArrayExpr *Parser::parseArrayExpr() {
   expect(Token::RBracket);
 
   if (!Array->getCap()) {
-    auto Pos = Buf[0].Pos;
-
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-    Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                                        "unimplemented: empty array", Range);
+    error("unimplemented: empty array");
   }
 
-  Lex.turnFlag(Lexer::IndentationSensitive, true);
+  Cur.IndentationSensitive = true;
 
   return Array;
 }
@@ -790,23 +879,101 @@ ast::FunctionDecl *Parser::parseFunctionDecl() {
   auto Result = parseFunctionSignature();
 
   if (match(Token::Colon)) {
-    auto Block = parseBlockStmt();
-    Block->setOwner(Result);
-    Result->setBlockStmt(Block);
+    if (LazyBodies)
+      skipFunctionBody(Result);
+    else
+      parseFunctionBody(Result);
   }
 
-  Module->addFunction(Result);
   return Result;
 }
 
+void Parser::parseFunctionBody(ast::FunctionDecl *Fn) {
+  auto Block = parseBlockStmt();
+  Block->setOwner(Fn);
+  Fn->setBlockStmt(Block);
+}
+
+void Parser::skipFunctionBody(ast::FunctionDecl *Fn) {
+  SkippedBodies[Fn] = Cur;
+
+  // The body ends with the first line indented less than one level, the
+  // same line break parseBlockStmt() ends it with. Keywords which only start
+  // a declaration end it too, so a missing line break can't swallow the
+  // following declarations.
+  auto EndsBody = [&](uint32_t I) {
+    switch (Tokens.getKind(I)) {
+    case Token::Newline:
+      return Tokens.getLength(I) < 2;
+    case Token::Eof:
+    case Token::Def:
+    case Token::Type:
+    case Token::Interface:
+    case Token::Open:
+      return true;
+    default:
+      return false;
+    }
+  };
+
+  auto Next = Cur.Next;
+  while (!EndsBody(Next))
+    ++Next;
+  Cur.Next = Next;
+}
+
+void Parser::parseReferencedBodies() {
+  std::vector<ast::FunctionDecl *> Worklist;
+  llvm::DenseSet<ast::FunctionDecl *> Reached;
+
+  auto Reach = [&](ast::FunctionDecl *Fn) {
+    if (Fn && Reached.insert(Fn).second)
+      Worklist.push_back(Fn);
+  };
+  auto ReachReferences = [&] {
+    for (auto Symbol : References)
+      Reach(Module->lookupFunction(Symbol));
+    References.clear();
+  };
+
+  for (auto &Node : *Module->getAST())
+    if (auto Fn = llvm::dyn_cast<ast::FunctionDecl>(&Node))
+      if (!Fn->getIdentifier().startswith("_"))
+        Reach(Fn);
+  // Calls in the initializers of top-level variables.
+  ReachReferences();
+
+  auto Saved = Cur;
+  while (!Worklist.empty()) {
+    auto Fn = Worklist.back();
+    Worklist.pop_back();
+
+    auto Body = SkippedBodies.find(Fn);
+    if (Body == SkippedBodies.end())
+      continue;
+
+    Cur = Body->second;
+    parseFunctionBody(Fn);
+    ReachReferences();
+  }
+  Cur = Saved;
+
+  // In source order, as the module would have been built eagerly. Imported
+  // declarations got theirs as they were loaded.
+  for (auto &Node : *Module->getAST())
+    if (auto Fn = llvm::dyn_cast<ast::FunctionDecl>(&Node))
+      if (Reached.count(Fn) && !Fn->hasGenerics() && !Fn->maybeGetIR())
+        Fn->createIR(Module);
+}
+
 /// functionSignature = 'def' IDENTIFIER [genericTypeList] argumentList
 ///         ['->' typeDecl];
 ast::FunctionDecl *Parser::parseFunctionSignature() {
   expect(Token::Identifier);
   auto Signature =
     peekToken() == Token::LBracket
-      ? new ast::GenericFunctionDecl(Buf[0])
-      : new ast::FunctionDecl(Buf[0]);
+      ? Arena.create<ast::GenericFunctionDecl>(current())
+      : Arena.create<ast::FunctionDecl>(current());
 
   parseGenericTypeList(Signature);
   parseArgumentList(Signature);
@@ -842,7 +1009,7 @@ void Parser::parseArgumentList(ast::FunctionDecl *Function) {
 ///         | returnStmt;
 ast::Node *Parser::parsePrimary() {
   if (match(Token::Return)) {
-    auto ReturnStmt = new ast::ReturnStmt(Buf[0].Pos);
+    auto ReturnStmt = Arena.create<ast::ReturnStmt>(current().Pos);
     ReturnStmt->setReturnExpr(parseExpression());
     return ReturnStmt;
   }
@@ -855,11 +1022,11 @@ ast::Node *Parser::parsePrimary() {
 
 /// blockStmt = INDENT primary { '\n' INDENT primary };
 ast::BlockStmt *Parser::parseBlockStmt() {
-  Lex.turnFlag(Lexer::IndentationSensitive, true);
+  Cur.IndentationSensitive = true;
 
-  Lex.incrementIndentLevel();
+  ++Cur.IndentLevel;
 
-  auto Block = new ast::BlockStmt(Buf[0].Pos, CurrentBlock);
+  auto Block = Arena.create<ast::BlockStmt>(current().Pos, CurrentBlock);
   CurrentBlock = Block;
 
   while (match(Token::Indent)) {
@@ -874,10 +1041,10 @@ ast::BlockStmt *Parser::parseBlockStmt() {
 
   expect(Token::Dedent);
 
-  Lex.decrementIndentLevel();
+  --Cur.IndentLevel;
 
-  if (!Lex.getIndentLevel()) {
-    Lex.turnFlag(Lexer::IndentationSensitive, false);
+  if (!Cur.IndentLevel) {
+    Cur.IndentationSensitive = false;
     LastIfNode = nullptr;
   }
 
@@ -888,26 +1055,20 @@ ast::BlockStmt *Parser::parseBlockStmt() {
 ast::VarDecl *Parser::parseVarDecl(bool IsArg) {
   if (!match(Token::Identifier) && !match(Token::Wildcard)) {
     if (IsArg) {
-      auto Pos = Buf[0].Pos;
-
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-      Lex.getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-          "expected `identifier` or `_`, found " + Buf[0].toString(), Range);
+      error("expected `identifier` or `_`, found " + current().toString());
     } else {
       return nullptr;
     }
   }
 
-  auto Result = new ast::VarDecl(Buf[0], IsArg);
+  auto Result = Arena.create<ast::VarDecl>(current(), IsArg);
 
   if (IsArg) {
-    auto Buffer = Buf[0];
+    auto Buffer = current();
     if (match(Token::Identifier)) {
+      auto Name = current();
       Result->setNamedArg(Buffer.toString());
-      Result->setIdentifier(Buf[0].toString());
+      Result->setIdentifier(Name.toString(), Name.Symbol);
     }
   }
 
@@ -931,7 +1092,7 @@ void Parser::parseGenericTypeList(ast::GenericDecl *Declaration) {
   expect(Token::RBracket);
 }
 
-/// genericType = IDENTIFIER;
+/// genericType = IDENTIFIER [':' IDENTIFIER];
 /// TODO: specialization
 void Parser::parseGenericType(ast::GenericDecl *Declaration) {
   expect(Token::Identifier);
@@ -939,14 +1100,21 @@ void Parser::parseGenericType(ast::GenericDecl *Declaration) {
   // TODO:
   switch (Declaration->getKind()) {
   case ast::NodeKind::AST_FunctionDecl:
+  case ast::NodeKind::AST_GenericFunctionDecl:
+  case ast::NodeKind::AST_InterfaceDecl:
     /*auto Fn = static_cast<ast::FunctionDecl *>(Declaration);
      Fn->getBlockStmt()->get*/
-    Declaration->addGenericType(Buf[0].Pos, Buf[0].toString());
+    Declaration->addGenericType(current());
     break;
     
   default:
     assert(false && "unimplemented");
   }
+
+  if (match(Token::Colon)) {
+    expect(Token::Identifier);
+    Declaration->getGenericsList().back().setBound(current());
+  }
 }
 
 } // namespace north
@@ -9,35 +9,127 @@
 
 #include "Grammar/Token.h"
 
+#include <array>
+#include <cstring>
+
 namespace north {
 
+namespace {
+
+struct Keyword {
+  const char *Spelling;
+  unsigned char Length;
+  Token Kind;
+};
+
+constexpr Keyword Keywords[] = {
+#define KEYWORD(Name, Spelling) {Spelling, sizeof(Spelling) - 1, Token::Name},
+#include "Grammar/TokenKinds.def"
+};
+
+constexpr size_t KeywordCount = std::size(Keywords);
+
+constexpr auto MinKeywordLength = [] {
+  unsigned char Min = Keywords[0].Length;
+  for (auto &K : Keywords)
+    Min = K.Length < Min ? K.Length : Min;
+  return Min;
+}();
+
+constexpr auto MaxKeywordLength = [] {
+  unsigned char Max = Keywords[0].Length;
+  for (auto &K : Keywords)
+    Max = K.Length > Max ? K.Length : Max;
+  return Max;
+}();
+
+/// Every keyword is told apart by its length, first and last characters, so
+/// a hash of those three picks the only candidate which has to be compared.
+/// The multipliers are searched for at compile time, which keeps the table
+/// collision-free whatever keywords TokenKinds.def lists.
+constexpr unsigned KeywordTableSize = 32;
+
+struct KeywordHash {
+  unsigned FirstMul;
+  unsigned LastMul;
+
+  constexpr unsigned operator()(size_t Length, unsigned char First,
+                                unsigned char Last) const {
+    return (Length + First * FirstMul + Last * LastMul) % KeywordTableSize;
+  }
+
+  constexpr unsigned operator()(const char *Str, size_t Length) const {
+    return (*this)(Length, Str[0], Str[Length - 1]);
+  }
+};
+
+constexpr bool isPerfect(KeywordHash Hash) {
+  bool Used[KeywordTableSize] = {};
+  for (auto &K : Keywords) {
+    auto Slot = Hash(K.Spelling, K.Length);
+    if (Used[Slot])
+      return false;
+    Used[Slot] = true;
+  }
+  return true;
+}
+
+constexpr KeywordHash findKeywordHash() {
+  for (unsigned FirstMul = 1; FirstMul != 64; ++FirstMul)
+    for (unsigned LastMul = 1; LastMul != 64; ++LastMul)
+      if (isPerfect({FirstMul, LastMul}))
+        return {FirstMul, LastMul};
+  return {0, 0};
+}
+
+constexpr KeywordHash Hash = findKeywordHash();
+static_assert(Hash.FirstMul, "keywords have no perfect hash, grow the table");
+static_assert(KeywordCount < 128, "keyword index does not fit the table");
+
+/// Maps a hash slot to the index of its keyword in Keywords, or -1.
+constexpr auto KeywordTable = [] {
+  std::array<signed char, KeywordTableSize> Table{};
+  for (auto &Slot : Table)
+    Slot = -1;
+  for (size_t I = 0; I != KeywordCount; ++I)
+    Table[Hash(Keywords[I].Spelling, Keywords[I].Length)] = I;
+  return Table;
+}();
+
+} // namespace
+
 llvm::StringRef TokenInfo::toString() const {
-  if (*Pos.Offset == '\'' || *Pos.Offset == '\"')
-    return llvm::StringRef(Pos.Offset + 1, Pos.Length - 2);
-  return llvm::StringRef(Pos.Offset, Pos.Length);
+  auto Ptr = getPointer();
+  if (*Ptr == '\'' || *Ptr == '\"')
+    return llvm::StringRef(Ptr + 1, Pos.Length - 2);
+  return llvm::StringRef(Ptr, Pos.Length);
 }
 
 const char *tokenToString(Token Tk) {
   static const char *Tokens[] = {
-      "end of file", "comment",     "indent",   "dedent", "identifier",
-      "`int`",       "char",        "`string`", "`def`",  "`nil`",
-      "`open`",      "`interface`", "`type`",   "`var`",  "`let`",
-      "`if`",        "`in`",        "`else`",   "`for`",  "`while`",
-      "`switch`",    "`return`",    "`(`",      "`)`",    "`{`",
-      "`}`",         "`[`",         "`]`",      "`.`",    "`..`",
-      "`...`",       "`=`",         "`/=`",     "`*=`",   "`+=`",
-      "`-=`",        "`&=`",        "`|=`",     "`>>=`",  "`<<=`",
-      "`==`",        "`!=`",        "`>=`",     "`<=`",   "`:`",
-      "`,`",         "`;`",         "`/`",      "`*`",    "`+`",
-      "`-`",         "`++`",        "`--`",     "`!`",    "`&`",
-      "`|`",         "`>`",         "`<`",      "`_`",    "`&&`",
-      "`||`",        "`>>`",        "`<<`",     "`->`"};
+#define TOKEN(Name, Description) Description,
+#include "Grammar/TokenKinds.def"
+  };
 
   return Tokens[static_cast<uint8_t>(Tk)];
 }
 
 llvm::StringRef tokenView(TokenInfo Tk) {
-  return llvm::StringRef(Tk.Pos.Offset, Tk.Pos.Length);
+  return llvm::StringRef(Tk.getPointer(), Tk.Pos.Length);
+}
+
+Token lookupKeyword(llvm::StringRef Str) {
+  if (Str.size() < MinKeywordLength || Str.size() > MaxKeywordLength)
+    return Token::Identifier;
+
+  auto Index = KeywordTable[Hash(Str.data(), Str.size())];
+  if (Index < 0)
+    return Token::Identifier;
+
+  auto &K = Keywords[Index];
+  if (K.Length != Str.size() || memcmp(K.Spelling, Str.data(), K.Length) != 0)
+    return Token::Identifier;
+  return K.Kind;
 }
 
 } // namespace north
@@ -0,0 +1,46 @@
+//===--- Grammar/TokenStream.cpp - Pre-lexed token buffer -------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Grammar/TokenStream.h"
+
+namespace north {
+
+void TokenStream::reserve(size_t Size) {
+  Kinds.reserve(Size);
+  Offsets.reserve(Size);
+  Lengths.reserve(Size);
+  Symbols.reserve(Size);
+}
+
+void TokenStream::push(const TokenInfo &Tk) {
+  Kinds.push_back(Tk.Type);
+  Offsets.push_back(Tk.Pos.Offset);
+  Lengths.push_back(Tk.Pos.Length);
+  Symbols.push_back(Tk.Symbol);
+}
+
+TokenInfo TokenStream::get(size_t Idx) const {
+  Position Pos{Offsets[Idx], Lengths[Idx]};
+  return TokenInfo{Pos, Kinds[Idx], Symbols[Idx], Buffer};
+}
+
+TokenStream TokenStream::slice(size_t Begin, size_t End) const {
+  TokenStream Slice(Buffer);
+  Slice.Kinds.assign(Kinds.begin() + Begin, Kinds.begin() + End);
+  Slice.Offsets.assign(Offsets.begin() + Begin, Offsets.begin() + End);
+  Slice.Lengths.assign(Lengths.begin() + Begin, Lengths.begin() + End);
+  Slice.Symbols.assign(Symbols.begin() + Begin, Symbols.begin() + End);
+
+  // Placed where the next slice begins.
+  auto Offset = End < size() ? Offsets[End] : Offsets.back();
+  Slice.push({Position{Offset, 0}, Token::Eof, InvalidSymbol, Buffer});
+  return Slice;
+}
+
+} // namespace north
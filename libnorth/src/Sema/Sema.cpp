@@ -0,0 +1,306 @@
+//===--- Sema/Sema.cpp - Name resolution ------------------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Sema/Sema.h"
+#include "Type/Module.h"
+#include "Type/Type.h"
+
+#include <llvm/Support/Parallel.h>
+#include <llvm/Support/SourceMgr.h>
+
+#include <memory>
+
+namespace north::sema {
+
+using namespace llvm;
+
+bool Sema::resolve() {
+  struct Body {
+    ast::FunctionDecl *Fn;
+    /// Count of the top-level variables declared before the function.
+    size_t Globals;
+    /// Count of the generic calls made by those variables.
+    size_t GlobalCalls;
+  };
+
+  std::vector<Body> Bodies;
+  std::vector<ast::VarDecl *> Globals;
+  BodyResolver TopLevel(Module, {});
+
+  for (auto &Node : *Module->getAST()) {
+    if (auto Fn = dyn_cast<ast::FunctionDecl>(&Node)) {
+      if (Fn->getBlockStmt())
+        Bodies.push_back(
+            {Fn, Globals.size(), TopLevel.getGenericCalls().size()});
+    } else if (auto Var = dyn_cast<ast::VarDecl>(&Node)) {
+      Var->accept(TopLevel);
+      Globals.push_back(Var);
+    }
+  }
+  bool Resolved = TopLevel.getDiagnostics().empty();
+  TopLevel.getDiagnostics().flush(Module->getSourceManager());
+
+  std::vector<std::unique_ptr<BodyResolver>> Resolvers(Bodies.size());
+  parallelForEachN(size_t(0), Bodies.size(), [&](size_t I) {
+    auto Visible = makeArrayRef(Globals).take_front(Bodies[I].Globals);
+    Resolvers[I] = std::make_unique<BodyResolver>(Module, Visible);
+    Bodies[I].Fn->accept(*Resolvers[I]);
+  });
+
+  // Source order keeps both the first error reported and the order of
+  // generic instances independent of scheduling. The calls of top-level
+  // variables go between those of the bodies around them.
+  auto GlobalCalls = TopLevel.getGenericCalls();
+  auto AddCalls = [](ArrayRef<BodyResolver::GenericCall> Calls) {
+    for (auto &Call : Calls)
+      Call.Fn->addCallExpr(Call.Callee);
+  };
+
+  size_t Merged = 0;
+  for (size_t I = 0; I < Bodies.size(); ++I) {
+    AddCalls(GlobalCalls.slice(Merged, Bodies[I].GlobalCalls - Merged));
+    Merged = Bodies[I].GlobalCalls;
+
+    auto &Resolver = Resolvers[I];
+    Resolved &= Resolver->getDiagnostics().empty();
+    Resolver->getDiagnostics().flush(Module->getSourceManager());
+    AddCalls(Resolver->getGenericCalls());
+  }
+  AddCalls(GlobalCalls.drop_front(Merged));
+  return Resolved;
+}
+
+BodyResolver::BodyResolver(type::Module *Module, ArrayRef<ast::VarDecl *> Globals)
+    : Module(Module), Scope(Module), CurrentFn(nullptr) {
+  for (auto Var : Globals)
+    Scope.addElement(Var);
+}
+
+void BodyResolver::error(const Position &Pos, const Twine &Message) {
+  Diags.report(Module->getRange(Pos), SourceMgr::DiagKind::DK_Error, Message);
+}
+
+void BodyResolver::declare(ast::VarDecl *Var) {
+  if (!Scope.addElement(Var))
+    error(Var->getPosition(), "duplicate definition of variable '" +
+                                  Var->getIdentifier() + "'");
+}
+
+ast::StructDecl *BodyResolver::getStruct(ast::GenericDecl *TypeDecl) {
+  if (!TypeDecl)
+    return nullptr;
+
+  auto Type = Module->getTypeOrNull(TypeDecl->getSymbol());
+  if (!Type)
+    return nullptr;
+
+  if (auto Def = dyn_cast_or_null<ast::TypeDef>(Type->getDecl()))
+    return dyn_cast_or_null<ast::StructDecl>(Def->getTypeDecl());
+  return nullptr;
+}
+
+ast::StructDecl *BodyResolver::getStructOf(ast::VarDecl *Var) {
+  // The initializer is more precise than the declared type, as it was
+  // before resolution moved out of the IR builder.
+  if (auto Init = dyn_cast_or_null<ast::StructInitExpr>(Var->getValue()))
+    return Init->getType();
+  if (auto Call = dyn_cast_or_null<ast::CallExpr>(Var->getValue()))
+    if (auto Fn = Module->getFn(*Call, &Scope))
+      return getStruct(Fn->getTypeDecl());
+  return getStruct(Var->getType());
+}
+
+void BodyResolver::resolveFunction(ast::FunctionDecl &Fn) {
+  if (!Fn.getBlockStmt())
+    return;
+
+  CurrentFn = &Fn;
+  Fn.getBlockStmt()->accept(*this);
+  CurrentFn = nullptr;
+}
+
+void BodyResolver::visit(ast::FunctionDecl &Fn) { resolveFunction(Fn); }
+
+// Instances share the body of the generic function, so it is resolved once.
+void BodyResolver::visit(ast::GenericFunctionDecl &Fn) { resolveFunction(Fn); }
+
+void BodyResolver::visit(ast::InterfaceDecl &) {}
+
+void BodyResolver::visit(ast::VarDecl &Var) {
+  // The variable isn't visible in its own initializer.
+  if (auto Value = Var.getValue())
+    Value->accept(*this);
+  declare(&Var);
+}
+
+void BodyResolver::visit(ast::AliasDecl &) {}
+void BodyResolver::visit(ast::StructDecl &) {}
+void BodyResolver::visit(ast::EnumDecl &) {}
+void BodyResolver::visit(ast::UnionDecl &) {}
+void BodyResolver::visit(ast::TupleDecl &) {}
+void BodyResolver::visit(ast::RangeDecl &) {}
+void BodyResolver::visit(ast::TypeDef &) {}
+
+void BodyResolver::visit(ast::UnaryExpr &Unary) {
+  Unary.getOperand()->accept(*this);
+}
+
+void BodyResolver::visit(ast::BinaryExpr &Binary) {
+  Binary.getLHS()->accept(*this);
+  Binary.getRHS()->accept(*this);
+}
+
+void BodyResolver::visit(ast::LiteralExpr &Literal) {
+  auto Info = Literal.getTokenInfo();
+  if (Info.Type != Token::Identifier)
+    return;
+
+  if (auto Var = Scope.lookup(Info.Symbol))
+    return Literal.setVar(Var);
+
+  error(Literal.getPosition(), "unknown symbol `" + Info.toString() + "`");
+}
+
+void BodyResolver::visit(ast::RangeExpr &Range) {
+  Range.getBeginValue()->accept(*this);
+  Range.getEndValue()->accept(*this);
+}
+
+void BodyResolver::visit(ast::CallExpr &Callee) {
+  for (size_t I = 0; I < Callee.countOfArgs(); ++I)
+    Callee.getArg(I)->Arg->accept(*this);
+
+  auto Fn = Module->getFn(Callee, &Scope);
+  if (!Fn)
+    return error(Callee.getPosition(), "unknown function referenced");
+
+  // Bound once the instance is known, see IRBuilder::instantiateGenerics().
+  if (auto Generic = dyn_cast<ast::GenericFunctionDecl>(Fn))
+    return GenericCalls.push_back({Generic, &Callee});
+
+  Callee.setCallableFn(Fn, Module, &Diags);
+}
+
+void BodyResolver::visit(ast::ArrayIndexExpr &Idx) {
+  Idx.getIdentifier()->accept(*this);
+  Idx.getIdxExpr()->accept(*this);
+}
+
+void BodyResolver::visit(ast::QualifiedIdentifierExpr &Ident) {
+  auto FirstPart = Ident.getSymbol(0);
+
+  if (auto Var = Scope.lookup(FirstPart)) {
+    Ident.setVar(Var);
+
+    auto Struct = getStructOf(Var);
+    for (unsigned Part = 1; Part < Ident.getSize(); ++Part) {
+      auto FieldName = Ident.getSymbol(Part);
+
+      if (!Struct)
+        return error(Ident.getPosition(),
+                     "`" + Ident.getPart(Part - 1) + "` is not a structure");
+
+      auto Fields = Struct->getFieldList();
+      auto Field = llvm::find_if(
+          Fields, [&](ast::VarDecl *F) { return F->getSymbol() == FieldName; });
+
+      if (Field == Fields.end())
+        return error(Struct->getPosition(),
+                     "structure " + Struct->getIdentifier() +
+                         "doesn't has field `" +
+                         Module->getInterner().getName(FieldName) + "`");
+
+      Ident.addFieldIndex(Field - Fields.begin());
+      if (Part + 1 < Ident.getSize())
+        Struct = getStruct((*Field)->getType());
+    }
+    return;
+  }
+
+  if (auto Type = Module->getTypeOrNull(FirstPart)) {
+    auto T = static_cast<ast::TypeDef *>(Type->getDecl())->getTypeDecl();
+    if (auto Enum = dyn_cast<ast::EnumDecl>(T))
+      return Ident.setEnum(Enum);
+  }
+
+  error(Ident.getPosition(), "unknown symbol `" + Ident.getPart(0) + "`");
+}
+
+void BodyResolver::visit(ast::IfExpr &If) {
+  if (auto Cond = If.getExpr())
+    Cond->accept(*this);
+  if (auto Block = If.getBlock())
+    Block->accept(*this);
+  if (auto Else = If.getElseBranch())
+    Else->accept(*this);
+}
+
+void BodyResolver::visit(ast::ForExpr &For) {
+  For.getRange()->accept(*this);
+
+  Scope.enterBlock();
+  declare(For.getIterVar());
+  For.getBlock()->accept(*this);
+  Scope.leaveBlock();
+}
+
+void BodyResolver::visit(ast::WhileExpr &While) {
+  While.getExpr()->accept(*this);
+  While.getBlock()->accept(*this);
+}
+
+void BodyResolver::visit(ast::AssignExpr &Assign) {
+  Assign.getLHS()->accept(*this);
+  Assign.getRHS()->accept(*this);
+}
+
+void BodyResolver::visit(ast::OpenStmt &) {}
+
+void BodyResolver::visit(ast::BlockStmt &Block) {
+  Scope.enterBlock();
+
+  // Arguments are bound once, in the function's outermost block.
+  if (&Block == CurrentFn->getBlockStmt())
+    for (auto Arg : CurrentFn->getArgumentList())
+      declare(Arg);
+
+  for (auto &Node : *Block.getBody())
+    Node.accept(*this);
+
+  Scope.leaveBlock();
+}
+
+void BodyResolver::visit(ast::ReturnStmt &Return) {
+  if (auto Expr = Return.getReturnExpr())
+    Expr->accept(*this);
+}
+
+void BodyResolver::visit(ast::StructInitExpr &Struct) {
+  auto Ident = cast<ast::LiteralExpr>(Struct.getIdentifier());
+  auto Info = Ident->getTokenInfo();
+
+  auto Type = Module->getTypeOrNull(Info.Symbol);
+  if (!Type)
+    return error(Ident->getPosition(),
+                 "unknown symbol `" + Info.toString() + "`");
+
+  Struct.setStructType(Type);
+  Struct.setType(static_cast<ast::StructDecl *>(
+      static_cast<ast::TypeDef *>(Type->getDecl())->getTypeDecl()));
+
+  for (auto Value : Struct.getValues())
+    Value->accept(*this);
+}
+
+void BodyResolver::visit(ast::ArrayExpr &Array) {
+  for (auto Value : Array.getValues())
+    Value->accept(*this);
+}
+
+} // namespace north::sema
@@ -0,0 +1,68 @@
+//===--- Serialization/ASTCache.cpp - On-disk AST cache ---------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Serialization/ASTCache.h"
+#include "Serialization/ASTFile.h"
+#include "Type/Module.h"
+#include "Utils/FileSystem.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace north::serialization {
+
+using namespace llvm;
+
+std::string ASTCache::getPath(StringRef Source) const {
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, toHex(hashSource(Source), /*LowerCase=*/true) +
+                              ".ast");
+  return std::string(Path.str());
+}
+
+bool ASTCache::load(type::Module &Module) const {
+  auto Path = getPath(Module.getLineTable().getBuffer());
+
+  auto File = sys::fs::openNativeFileForRead(Path);
+  if (!File) {
+    consumeError(File.takeError());
+    return false;
+  }
+
+  sys::fs::file_status Status;
+  std::error_code EC = sys::fs::status(*File, Status);
+  if (EC || !Status.getSize()) {
+    sys::fs::closeFile(*File);
+    return false;
+  }
+
+  sys::fs::mapped_file_region Map(*File, sys::fs::mapped_file_region::readonly,
+                                  Status.getSize(), 0, EC);
+  sys::fs::closeFile(*File);
+  if (EC)
+    return false;
+
+  return readAST(StringRef(Map.const_data(), Map.size()), Module);
+}
+
+void ASTCache::store(type::Module &Module) const {
+  if (sys::fs::create_directories(Dir))
+    return;
+
+  // Written aside and renamed, so that a concurrent reader never maps a
+  // partial file.
+  utils::writeFileAtomically(
+      getPath(Module.getLineTable().getBuffer()),
+      [&](raw_ostream &OS) { return writeAST(Module, OS); });
+}
+
+} // namespace north::serialization
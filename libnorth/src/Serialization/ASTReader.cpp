@@ -0,0 +1,629 @@
+//===--- Serialization/ASTReader.cpp - Binary AST reader --------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Serialization/ASTFile.h"
+#include "Serialization/InterfaceFile.h"
+#include "AST/AST.h"
+#include "Type/Module.h"
+
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/StringSet.h>
+#include <llvm/Support/LEB128.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace north::serialization {
+
+using namespace llvm;
+
+namespace {
+
+constexpr uint64_t NodeKinds = 0
+#define NODE(Name) +1
+#include "AST/ASTNodes.def"
+    ;
+
+constexpr uint64_t TokenKinds = static_cast<uint8_t>(Token::Newline) + 1;
+
+/// Reads a file written by ASTWriter. Nothing in the file is trusted: every
+/// integer, string and reference is checked before it is used, and the first
+/// malformed one fails the whole read.
+class ASTReader {
+  const uint8_t *Ptr;
+  const uint8_t *End;
+  bool Failed = false;
+
+  type::Module &Module;
+  /// The source, or the strings of an interface.
+  StringRef Source;
+  /// Position of the `open` statement an interface is read for, which
+  /// stands for the positions an interface doesn't record.
+  Optional<Position> ImportPos;
+  /// The nodes are built here and handed to the module once the whole file
+  /// was read.
+  std::unique_ptr<type::NodeArena> Arena;
+  /// Node of every record; 0 stands for none.
+  std::vector<ast::Node *> Nodes;
+  /// Index of the record being read.
+  uint64_t Current = 0;
+  DenseSet<ast::Node *> Linked;
+  /// Names of the symbols from 1 on. Those of an AST file are interned once
+  /// the file is known to be well-formed, and keep their id.
+  std::vector<StringRef> Symbols;
+  /// The module's id of every symbol of an interface, from 0 on.
+  std::vector<SymbolId> SymbolIds;
+
+public:
+  ASTReader(StringRef Data, type::Module &Module)
+      : Ptr(Data.bytes_begin()), End(Data.bytes_end()), Module(Module),
+        Source(Module.getLineTable().getBuffer()),
+        Arena(std::make_unique<type::NodeArena>()), Nodes(1) {}
+
+  bool readAST();
+  bool readInterface(const Position &Pos,
+                     function_ref<bool(StringRef)> LoadImport);
+
+private:
+  bool fail() {
+    Failed = true;
+    return false;
+  }
+
+  uint64_t readInt(uint64_t Limit = UINT32_MAX);
+  StringRef readBytes(uint64_t Size);
+  StringRef readString();
+  Position readPosition();
+  Token readTokenKind();
+  SymbolId readSymbol();
+  TokenInfo readToken();
+  /// Reads a count, then as many strings.
+  bool readStrings(std::vector<StringRef> &Strings);
+
+  /// Reads the nodes, roots and parents common to both kinds of file.
+  bool readNodes(std::vector<ast::Node *> &Roots);
+  ast::Node *readNode();
+  ast::Node *readNode(ast::NodeKind Kind, const Position &Pos);
+  /// Records that \p N is put in a list: a node can be in one list only.
+  bool link(ast::Node *N);
+  ast::Node *readRef();
+  template <typename T> T *readRef();
+  template <typename T> T *readNonNullRef();
+  template <typename T, typename F> void readRefs(F Add);
+
+  void readDeclaration(ast::Declaration &Decl);
+  void readGenericDecl(ast::GenericDecl &Decl);
+  ast::FunctionDecl *readFunction(ast::FunctionDecl *Fn);
+  template <typename T> T *readBinary(const Position &Pos);
+
+  TokenInfo makeToken(const Position &Pos, Token Kind = Token::Identifier,
+                      SymbolId Symbol = InvalidSymbol) const {
+    // The positions standing in for an interface's are not in its strings.
+    if (ImportPos)
+      return TokenInfo{Position{0, 0}, Kind, Symbol, ""};
+    return TokenInfo{Pos, Kind, Symbol, Source.data()};
+  }
+};
+
+} // namespace
+
+uint64_t ASTReader::readInt(uint64_t Limit) {
+  if (Failed)
+    return 0;
+
+  unsigned Size;
+  const char *Error = nullptr;
+  auto Value = decodeULEB128(Ptr, &Size, End, &Error);
+  if (Error || Value > Limit) {
+    fail();
+    return 0;
+  }
+
+  Ptr += Size;
+  return Value;
+}
+
+StringRef ASTReader::readBytes(uint64_t Size) {
+  if (Failed || Size > uint64_t(End - Ptr)) {
+    fail();
+    return {};
+  }
+
+  StringRef Bytes(reinterpret_cast<const char *>(Ptr), Size);
+  Ptr += Size;
+  return Bytes;
+}
+
+StringRef ASTReader::readString() {
+  auto Size = readInt(Source.size());
+  if (!Size)
+    return "";
+
+  auto Offset = readInt(Source.size() - Size);
+  if (Failed)
+    return "";
+  return Source.substr(Offset, Size);
+}
+
+Position ASTReader::readPosition() {
+  if (ImportPos)
+    return *ImportPos;
+
+  auto Offset = readInt(Source.size());
+  auto Length = readInt(Source.size() - Offset);
+  return Position{uint32_t(Offset), uint32_t(Length)};
+}
+
+Token ASTReader::readTokenKind() {
+  return static_cast<Token>(readInt(TokenKinds - 1));
+}
+
+SymbolId ASTReader::readSymbol() {
+  auto Symbol = readInt(Symbols.size());
+  return ImportPos ? SymbolIds[Symbol] : Symbol;
+}
+
+TokenInfo ASTReader::readToken() {
+  // An interface has the spelling in place of the position.
+  TokenInfo Token;
+  if (ImportPos) {
+    auto Spelling = readString();
+    Token = Spelling.empty()
+                ? makeToken(*ImportPos)
+                : TokenInfo{Position{uint32_t(Spelling.data() - Source.data()),
+                                     uint32_t(Spelling.size())},
+                            Token::Identifier, InvalidSymbol, Source.data()};
+  } else {
+    Token = makeToken(readPosition());
+  }
+  Token.Type = readTokenKind();
+  Token.Symbol = readSymbol();
+
+  // TokenInfo::toString() strips the quotes of a literal, which must have
+  // both of them.
+  auto First = Token.Pos.Offset < Source.size() ? Source[Token.Pos.Offset] : 0;
+  if (Token.Buffer == Source.data() && Token.Pos.Length < 2 &&
+      (First == '\'' || First == '"'))
+    fail();
+  return Token;
+}
+
+bool ASTReader::readStrings(std::vector<StringRef> &Strings) {
+  auto Count = readInt();
+  for (uint64_t I = 0; I < Count && !Failed; ++I) {
+    auto String = readString();
+    if (String.empty())
+      return fail();
+    Strings.push_back(String);
+  }
+  return !Failed;
+}
+
+ast::Node *ASTReader::readRef() {
+  auto Distance = readInt(Current - 1);
+  return Distance ? Nodes[Current - Distance] : nullptr;
+}
+
+template <typename T> T *ASTReader::readRef() {
+  auto N = readRef();
+  if (N && !isa<T>(N)) {
+    fail();
+    return nullptr;
+  }
+  return cast_or_null<T>(N);
+}
+
+template <typename T> T *ASTReader::readNonNullRef() {
+  auto N = readRef<T>();
+  if (!N)
+    fail();
+  return N;
+}
+
+template <typename T, typename F> void ASTReader::readRefs(F Add) {
+  auto Count = readInt(Current - 1);
+  for (uint64_t I = 0; I < Count && !Failed; ++I)
+    if (auto N = readNonNullRef<T>())
+      Add(N);
+}
+
+void ASTReader::readDeclaration(ast::Declaration &Decl) {
+  auto Identifier = readString();
+  auto Symbol = readSymbol();
+  Decl.setIdentifier(Identifier, Symbol);
+}
+
+void ASTReader::readGenericDecl(ast::GenericDecl &Decl) {
+  readDeclaration(Decl);
+
+  if (auto Modifiers = readInt(ast::GenericDecl::Ptr | ast::GenericDecl::Ref |
+                               ast::GenericDecl::Out | ast::GenericDecl::In))
+    Decl.setModifier(static_cast<ast::GenericDecl::Modifier>(Modifiers));
+
+  auto Count = readInt();
+  auto &Generics = Decl.getGenericsList();
+  for (uint64_t I = 0; I < Count && !Failed; ++I) {
+    auto Pos = readPosition();
+    auto Name = readString();
+    auto Symbol = readSymbol();
+    Generics.emplace_back(Pos, Name, Symbol);
+    Generics.back().BoundName = readString();
+    Generics.back().Bound = readSymbol();
+  }
+}
+
+ast::FunctionDecl *ASTReader::readFunction(ast::FunctionDecl *Fn) {
+  readGenericDecl(*Fn);
+  readRefs<ast::VarDecl>([&](ast::VarDecl *Arg) { Fn->addArgument(Arg); });
+  Fn->setTypeDecl(readRef<ast::GenericDecl>());
+  if (auto Block = readRef<ast::BlockStmt>()) {
+    Block->setOwner(Fn);
+    Fn->setBlockStmt(Block);
+  }
+  Fn->setVarArg(readInt(1));
+  return Fn;
+}
+
+template <typename T> T *ASTReader::readBinary(const Position &Pos) {
+  auto LHS = readRef();
+  auto Op = readTokenKind();
+  auto RHS = readRef();
+  return Arena->create<T>(makeToken(Pos), LHS, Op, RHS);
+}
+
+bool ASTReader::link(ast::Node *N) {
+  if (!Linked.insert(N).second)
+    return fail();
+  return true;
+}
+
+ast::Node *ASTReader::readNode() {
+  auto Kind = static_cast<ast::NodeKind>(readInt(NodeKinds - 1));
+  auto Pos = readPosition();
+  if (Failed)
+    return nullptr;
+
+  // Constructors take the position of a child or token, if any.
+  auto N = readNode(Kind, Pos);
+  if (N)
+    N->setPosition(Pos);
+  return N;
+}
+
+ast::Node *ASTReader::readNode(ast::NodeKind Kind, const Position &Pos) {
+  auto Token = makeToken(Pos);
+
+  switch (Kind) {
+  case ast::AST_TypeDef: {
+    auto Def = Arena->create<ast::TypeDef>(Token);
+    readGenericDecl(*Def);
+    Def->setTypeDecl(readRef<ast::GenericDecl>());
+    return Def;
+  }
+
+  case ast::AST_AliasDecl: {
+    auto Alias = Arena->create<ast::AliasDecl>(Token);
+    readGenericDecl(*Alias);
+    Alias->setAlias(readString());
+    return Alias;
+  }
+
+  case ast::AST_StructDecl: {
+    auto Struct = Arena->create<ast::StructDecl>(Pos);
+    readGenericDecl(*Struct);
+    readRefs<ast::VarDecl>([&](ast::VarDecl *F) { Struct->addField(F); });
+    return Struct;
+  }
+
+  case ast::AST_UnionDecl: {
+    auto Union = Arena->create<ast::UnionDecl>(Token);
+    readGenericDecl(*Union);
+    readRefs<ast::GenericDecl>([&](ast::GenericDecl *F) { Union->addField(F); });
+    return Union;
+  }
+
+  case ast::AST_EnumDecl: {
+    auto Count = readInt();
+    if (!Count) {
+      fail();
+      return nullptr;
+    }
+
+    auto Enum = Arena->create<ast::EnumDecl>(readToken());
+    for (uint64_t I = 1; I < Count && !Failed; ++I)
+      Enum->addMember(readToken());
+    readGenericDecl(*Enum);
+    return Enum;
+  }
+
+  case ast::AST_TupleDecl: {
+    auto Tuple = Arena->create<ast::TupleDecl>(Token);
+    readGenericDecl(*Tuple);
+    readRefs<ast::VarDecl>([&](ast::VarDecl *M) { Tuple->addMember(M); });
+    return Tuple;
+  }
+
+  case ast::AST_RangeDecl: {
+    auto Range = Arena->create<ast::RangeDecl>(Token);
+    readGenericDecl(*Range);
+    readRefs<ast::RangeExpr>([&](ast::RangeExpr *R) { Range->addRange(R); });
+    return Range;
+  }
+
+  case ast::AST_InterfaceDecl: {
+    auto Interface = Arena->create<ast::InterfaceDecl>(Token);
+    readGenericDecl(*Interface);
+    readRefs<ast::FunctionDecl>(
+        [&](ast::FunctionDecl *Fn) { Interface->addFunction(Fn); });
+    Interface->setParent(readRef<ast::InterfaceDecl>());
+    return Interface;
+  }
+
+  case ast::AST_GenericFunctionDecl:
+    return readFunction(Arena->create<ast::GenericFunctionDecl>(Token));
+
+  case ast::AST_FunctionDecl:
+    return readFunction(Arena->create<ast::FunctionDecl>(Token));
+
+  case ast::AST_VarDecl: {
+    auto Var = Arena->create<ast::VarDecl>(Token, readInt(1));
+    readDeclaration(*Var);
+    Var->setType(readRef<ast::GenericDecl>());
+    Var->setValue(readRef());
+    Var->setNamedArg(readString());
+    return Var;
+  }
+
+  case ast::AST_BinaryExpr:
+    return readBinary<ast::BinaryExpr>(Pos);
+
+  case ast::AST_AssignExpr:
+    return readBinary<ast::AssignExpr>(Pos);
+
+  case ast::AST_UnaryExpr: {
+    auto Op = readTokenKind();
+    return Arena->create<ast::UnaryExpr>(Token, Op, readRef());
+  }
+
+  case ast::AST_LiteralExpr:
+    return Arena->create<ast::LiteralExpr>(readToken());
+
+  case ast::AST_RangeExpr: {
+    auto Begin = readNonNullRef<ast::LiteralExpr>();
+    auto EndValue = readRef<ast::LiteralExpr>();
+    if (Failed)
+      return nullptr;
+
+    auto Range = Arena->create<ast::RangeExpr>(Begin);
+    Range->setEndValue(EndValue);
+    return Range;
+  }
+
+  case ast::AST_CallExpr: {
+    auto Ident = readNonNullRef<ast::QualifiedIdentifierExpr>();
+    if (Failed)
+      return nullptr;
+
+    auto Call = Arena->create<ast::CallExpr>(Ident);
+    auto Count = readInt(Current - 1);
+    for (uint64_t I = 0; I < Count && !Failed; ++I) {
+      auto Arg = readNonNullRef<ast::Node>();
+      auto Name = readString();
+      if (Arg)
+        Call->addArgument(Arg, Name);
+    }
+    return Call;
+  }
+
+  case ast::AST_ArrayIndexExpr: {
+    auto Ident = readNonNullRef<ast::Node>();
+    auto IdxExpr = readRef();
+    if (Failed)
+      return nullptr;
+
+    auto Idx = Arena->create<ast::ArrayIndexExpr>(Ident);
+    Idx->setIdxExpr(IdxExpr);
+    return Idx;
+  }
+
+  case ast::AST_QualifiedIdentifierExpr: {
+    auto Count = readInt();
+    if (!Count) {
+      fail();
+      return nullptr;
+    }
+
+    auto Ident = Arena->create<ast::QualifiedIdentifierExpr>(readToken());
+    for (uint64_t I = 1; I < Count && !Failed; ++I)
+      Ident->AddPart(readToken());
+    return Ident;
+  }
+
+  case ast::AST_IfExpr: {
+    auto If = Arena->create<ast::IfExpr>(Token, readRef());
+    If->setBlock(readRef<ast::BlockStmt>());
+    If->setElseBranch(readRef<ast::IfExpr>());
+    return If;
+  }
+
+  case ast::AST_ForExpr: {
+    auto For = Arena->create<ast::ForExpr>(Token);
+    For->setIter(readRef<ast::LiteralExpr>());
+    For->setRange(readRef());
+    For->setBlock(readRef<ast::BlockStmt>());
+    For->setIterVar(readRef<ast::VarDecl>());
+    return For;
+  }
+
+  case ast::AST_WhileExpr: {
+    auto While = Arena->create<ast::WhileExpr>(Token, readRef());
+    While->setBlock(readRef<ast::BlockStmt>());
+    return While;
+  }
+
+  case ast::AST_StructInitExpr: {
+    auto Ident = readNonNullRef<ast::Node>();
+    if (Failed)
+      return nullptr;
+
+    auto Struct = Arena->create<ast::StructInitExpr>(Ident);
+    readRefs<ast::Node>([&](ast::Node *V) { Struct->addValue(V); });
+    return Struct;
+  }
+
+  case ast::AST_ArrayExpr: {
+    auto Array = Arena->create<ast::ArrayExpr>(Token);
+    readRefs<ast::Node>([&](ast::Node *V) { Array->addValue(V); });
+    return Array;
+  }
+
+  case ast::AST_OpenStmt:
+    return Arena->create<ast::OpenStmt>(Pos, readString());
+
+  case ast::AST_BlockStmt: {
+    auto Block = Arena->create<ast::BlockStmt>(Pos);
+    readRefs<ast::Node>([&](ast::Node *N) {
+      if (link(N))
+        Block->addNode(N);
+    });
+    return Block;
+  }
+
+  case ast::AST_ReturnStmt:
+    return Arena->create<ast::ReturnStmt>(Pos, readRef());
+  }
+
+  fail();
+  return nullptr;
+}
+
+bool ASTReader::readNodes(std::vector<ast::Node *> &Roots) {
+  auto NodeCount = readInt();
+  // Every record takes at least two bytes.
+  if (Failed || NodeCount > uint64_t(End - Ptr) / 2)
+    return fail();
+
+  Nodes.reserve(NodeCount + 1);
+  for (Current = 1; Current <= NodeCount && !Failed; ++Current) {
+    auto N = readNode();
+    if (!N)
+      return fail();
+    Nodes.push_back(N);
+  }
+
+  auto RootCount = readInt(NodeCount);
+  for (uint64_t I = 0; I < RootCount && !Failed; ++I) {
+    auto Root = Nodes[readInt(NodeCount)];
+    if (!Root || !link(Root))
+      return fail();
+    Roots.push_back(Root);
+  }
+
+  auto ParentCount = readInt(NodeCount);
+  for (uint64_t I = 0; I < ParentCount && !Failed; ++I) {
+    auto Block = dyn_cast_or_null<ast::BlockStmt>(Nodes[readInt(NodeCount)]);
+    auto Parent = dyn_cast_or_null<ast::BlockStmt>(Nodes[readInt(NodeCount)]);
+    if (!Block)
+      return fail();
+    Block->setParent(Parent);
+  }
+
+  return !Failed && Ptr == End;
+}
+
+bool ASTReader::readAST() {
+  if (!Module.getAST()->empty() || readBytes(4) != "NAST" ||
+      readInt() != ASTFileVersion || readInt(UINT64_MAX) != Source.size())
+    return false;
+
+  auto Hash = hashSource(Source);
+  auto Recorded = readBytes(Hash.size());
+  if (Failed || std::memcmp(Recorded.data(), Hash.data(), Hash.size()))
+    return false;
+
+  // Ids are handed out in order, so interning the names in the same order
+  // gives them back their ids. The module has interned a few names already,
+  // which must be the first ones.
+  auto &Interner = Module.getInterner();
+  StringSet<> Seen;
+  auto SymbolCount = readInt();
+  for (SymbolId Id = 1; Id <= SymbolCount && !Failed; ++Id) {
+    auto Name = readBytes(readInt());
+    if (Failed || !Seen.insert(Name).second)
+      return fail();
+
+    auto Existing = Interner.lookup(Name);
+    if (Id < Interner.size() ? Existing != Id : Existing != InvalidSymbol)
+      return fail();
+    Symbols.push_back(Name);
+  }
+  if (Symbols.size() + 1 < Interner.size())
+    return fail();
+
+  std::vector<ast::Node *> Roots;
+  if (!readNodes(Roots))
+    return false;
+
+  for (auto Name : makeArrayRef(Symbols).drop_front(Interner.size() - 1))
+    Interner.intern(Name);
+  for (auto Root : Roots)
+    Module.addDeclaration(Root);
+  Module.adoptArena(std::move(Arena));
+  return true;
+}
+
+bool ASTReader::readInterface(const Position &Pos,
+                              function_ref<bool(StringRef)> LoadImport) {
+  ImportPos = Pos;
+  if (readBytes(4) != "NINT" || readInt() != InterfaceFileVersion)
+    return false;
+  Source = readBytes(readInt());
+
+  std::vector<StringRef> Imports;
+  if (!readStrings(Imports) || !readStrings(Symbols))
+    return false;
+
+  // The records use the interface's numbering, so the names are interned
+  // before any of them is read.
+  auto &Interner = Module.getInterner();
+  SymbolIds.push_back(InvalidSymbol);
+  for (auto Name : Symbols)
+    SymbolIds.push_back(Interner.intern(Name));
+
+  std::vector<ast::Node *> Roots;
+  if (!readNodes(Roots))
+    return false;
+
+  for (auto Root : Roots)
+    if (!isa<ast::TypeDef>(Root) && !isa<ast::InterfaceDecl>(Root) &&
+        !isa<ast::FunctionDecl>(Root))
+      return false;
+
+  for (auto Import : Imports)
+    if (!LoadImport(Import))
+      return false;
+
+  for (auto Root : Roots)
+    Module.addImportedDeclaration(Root);
+  Module.adoptArena(std::move(Arena));
+  return true;
+}
+
+bool readAST(StringRef Data, type::Module &Module) {
+  return ASTReader(Data, Module).readAST();
+}
+
+bool readInterface(StringRef Data, type::Module &Module, const Position &Pos,
+                   function_ref<bool(StringRef)> LoadImport) {
+  return ASTReader(Data, Module).readInterface(Pos, LoadImport);
+}
+
+} // namespace north::serialization
@@ -0,0 +1,594 @@
+//===--- Serialization/ASTWriter.cpp - Binary AST writer --------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Serialization/ASTFile.h"
+#include "Serialization/InterfaceFile.h"
+#include "AST/ASTVisitor.h"
+#include "Type/Module.h"
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/LEB128.h>
+#include <llvm/Support/SHA1.h>
+
+#include <string>
+#include <vector>
+
+namespace north::serialization {
+
+using namespace llvm;
+
+SourceHash hashSource(StringRef Source) {
+  return SHA1::hash(arrayRefFromStringRef(Source));
+}
+
+namespace {
+
+/// Writes a node only after its children, so that a record refers back to
+/// them by distance and the reader can construct every node in one pass.
+class ASTWriter : public ast::ASTVisitor<ASTWriter> {
+  type::Module &Module;
+  StringRef Source;
+  std::string Records;
+  raw_string_ostream OS;
+  /// Whether an interface is written rather than an AST file.
+  bool Interface;
+
+  DenseMap<const ast::Node *, uint32_t> Indices;
+  uint32_t Count = 0;
+  /// Index of the record being written.
+  uint32_t Current = 0;
+  std::vector<std::pair<uint32_t, ast::BlockStmt *>> Parents;
+  bool Valid = true;
+  /// Top-level variables stay with the module, exported generic bodies
+  /// can't use them.
+  SmallPtrSet<const ast::VarDecl *, 8> Globals;
+
+  /// The strings and symbols of an interface, see InterfaceFile.h.
+  std::string Strings;
+  StringMap<uint32_t> StringOffsets;
+  DenseMap<SymbolId, uint32_t> SymbolIndices;
+  std::vector<SymbolId> SymbolList;
+
+public:
+  ASTWriter(type::Module &Module, bool Interface)
+      : Module(Module), Source(Module.getLineTable().getBuffer()),
+        OS(Records), Interface(Interface) {}
+
+  bool writeAST(raw_ostream &Out);
+  bool writeInterface(raw_ostream &Out);
+
+  AST_WALKER_METHODS(void)
+
+private:
+  void add(ast::Node *N) {
+    if (N && !Indices.count(N))
+      N->accept(*this);
+  }
+  template <typename T> void add(ArrayRef<T *> Nodes) {
+    for (auto N : Nodes)
+      add(N);
+  }
+
+  void begin(ast::Node &N);
+  /// Reports that an exported generic body refers to \p N, which the
+  /// importers won't see.
+  void reject(ast::Node &N, const Twine &Message);
+  void writeNodes(ArrayRef<ast::Node *> Roots, raw_ostream &Out);
+
+  /// Returns the offset of \p String in the strings of an interface.
+  uint32_t addString(StringRef String);
+
+  void writeInt(uint64_t Value) { encodeULEB128(Value, OS); }
+  void writeString(StringRef String);
+  void writeSymbol(SymbolId Symbol);
+  void writePosition(const Position &Pos);
+  void writeToken(const TokenInfo &Token);
+  void writeRef(ast::Node *N);
+  template <typename T> void writeRefs(ArrayRef<T *> Nodes) {
+    writeInt(Nodes.size());
+    for (auto N : Nodes)
+      writeRef(N);
+  }
+
+  void writeDeclaration(ast::Declaration &Decl);
+  void writeGenericDecl(ast::GenericDecl &Decl);
+  void writeFunction(ast::FunctionDecl &Fn);
+};
+
+} // namespace
+
+bool ASTWriter::writeAST(raw_ostream &Out) {
+  // Imported declarations are loaded again by the `open` statements.
+  std::vector<ast::Node *> Roots;
+  for (auto &Node : *Module.getAST()) {
+    if (Module.isImported(&Node))
+      continue;
+    add(&Node);
+    Roots.push_back(&Node);
+  }
+  OS.flush();
+
+  auto Hash = hashSource(Source);
+  Out << "NAST";
+  encodeULEB128(ASTFileVersion, Out);
+  encodeULEB128(Source.size(), Out);
+  Out.write(reinterpret_cast<const char *>(Hash.data()), Hash.size());
+
+  // The names of the primitive types are interned by the module itself, but
+  // recording them too keeps the reader independent of that.
+  auto &Symbols = Module.getInterner();
+  encodeULEB128(Symbols.size() - 1, Out);
+  for (SymbolId Id = 1; Id < Symbols.size(); ++Id) {
+    auto Name = Symbols.getName(Id);
+    encodeULEB128(Name.size(), Out);
+    Out << Name;
+  }
+
+  writeNodes(Roots, Out);
+  return Valid;
+}
+
+bool ASTWriter::writeInterface(raw_ostream &Out) {
+  std::vector<ast::Node *> Roots;
+  std::vector<StringRef> Imports;
+  for (auto &Node : *Module.getAST())
+    if (auto Var = dyn_cast<ast::VarDecl>(&Node))
+      Globals.insert(Var);
+
+  for (auto &Node : *Module.getAST()) {
+    if (Module.isImported(&Node))
+      continue;
+
+    if (auto Open = dyn_cast<ast::OpenStmt>(&Node)) {
+      Imports.push_back(Open->getModuleName());
+      continue;
+    }
+
+    // Functions only declared here are someone else's to export.
+    if (auto Fn = dyn_cast<ast::FunctionDecl>(&Node)) {
+      if (Fn->getIdentifier().startswith("_") || !Fn->getBlockStmt())
+        continue;
+    } else if (!isa<ast::TypeDef>(&Node) && !isa<ast::InterfaceDecl>(&Node)) {
+      continue;
+    }
+
+    add(&Node);
+    Roots.push_back(&Node);
+  }
+  if (!Valid)
+    return false;
+
+  auto &Symbols = Module.getInterner();
+  std::vector<StringRef> Names;
+  for (auto Symbol : SymbolList)
+    Names.push_back(Symbols.getName(Symbol));
+
+  // Every string goes in before the strings are written out.
+  for (auto Name : llvm::concat<StringRef>(Imports, Names))
+    addString(Name);
+  OS.flush();
+
+  Out << "NINT";
+  encodeULEB128(InterfaceFileVersion, Out);
+  encodeULEB128(Strings.size(), Out);
+  Out << Strings;
+
+  auto WriteStrings = [&](ArrayRef<StringRef> List) {
+    encodeULEB128(List.size(), Out);
+    for (auto String : List) {
+      encodeULEB128(String.size(), Out);
+      encodeULEB128(addString(String), Out);
+    }
+  };
+  WriteStrings(Imports);
+  WriteStrings(Names);
+
+  writeNodes(Roots, Out);
+  return true;
+}
+
+void ASTWriter::reject(ast::Node &N, const Twine &Message) {
+  auto Range = Module.getRange(N.getPosition());
+  Module.getSourceManager().PrintMessage(
+      Range.Start, SourceMgr::DiagKind::DK_Error,
+      Message + ", which an exported generic function can't use", Range);
+  Valid = false;
+}
+
+void ASTWriter::writeNodes(ArrayRef<ast::Node *> Roots, raw_ostream &Out) {
+  encodeULEB128(Count, Out);
+  Out << Records;
+
+  encodeULEB128(Roots.size(), Out);
+  for (auto Root : Roots)
+    encodeULEB128(Indices.lookup(Root), Out);
+
+  encodeULEB128(Parents.size(), Out);
+  for (auto &Parent : Parents) {
+    encodeULEB128(Parent.first, Out);
+    encodeULEB128(Indices.lookup(Parent.second), Out);
+  }
+}
+
+uint32_t ASTWriter::addString(StringRef String) {
+  auto [Entry, Inserted] = StringOffsets.try_emplace(String, Strings.size());
+  if (Inserted) {
+    Strings += String;
+    Strings += '\n';
+  }
+  return Entry->second;
+}
+
+void ASTWriter::begin(ast::Node &N) {
+  Current = ++Count;
+  Indices[&N] = Current;
+  writeInt(N.getKind());
+  writePosition(N.getPosition());
+}
+
+void ASTWriter::writeString(StringRef String) {
+  writeInt(String.size());
+  if (String.empty())
+    return;
+
+  if (Interface)
+    return writeInt(addString(String));
+
+  if (String.begin() < Source.begin() || String.end() > Source.end()) {
+    Valid = false;
+    return writeInt(0);
+  }
+  writeInt(String.begin() - Source.begin());
+}
+
+void ASTWriter::writeSymbol(SymbolId Symbol) {
+  if (!Interface || Symbol == InvalidSymbol)
+    return writeInt(Symbol);
+
+  auto [Entry, Inserted] =
+      SymbolIndices.try_emplace(Symbol, SymbolList.size() + 1);
+  if (Inserted)
+    SymbolList.push_back(Symbol);
+  writeInt(Entry->second);
+}
+
+void ASTWriter::writePosition(const Position &Pos) {
+  if (Interface)
+    return;
+  writeInt(Pos.Offset);
+  writeInt(Pos.Length);
+}
+
+void ASTWriter::writeToken(const TokenInfo &Token) {
+  // An interface keeps the spelling, quotes included, in place of the
+  // position.
+  if (Interface)
+    writeString(Token.Buffer ? StringRef(Token.getPointer(), Token.Pos.Length)
+                             : StringRef());
+  else
+    writePosition(Token.Pos);
+  writeInt(static_cast<uint8_t>(Token.Type));
+  writeSymbol(Token.Symbol);
+}
+
+void ASTWriter::writeRef(ast::Node *N) {
+  writeInt(N ? Current - Indices.lookup(N) : 0);
+}
+
+void ASTWriter::writeDeclaration(ast::Declaration &Decl) {
+  writeString(Decl.getIdentifier());
+  writeSymbol(Decl.getSymbol());
+}
+
+void ASTWriter::writeGenericDecl(ast::GenericDecl &Decl) {
+  writeDeclaration(Decl);
+
+  uint8_t Modifiers = 0;
+  if (Decl.isPtr())
+    Modifiers |= ast::GenericDecl::Ptr;
+  if (Decl.isRef())
+    Modifiers |= ast::GenericDecl::Ref;
+  if (Decl.isOut())
+    Modifiers |= ast::GenericDecl::Out;
+  if (Decl.isIn())
+    Modifiers |= ast::GenericDecl::In;
+  writeInt(Modifiers);
+
+  writeInt(Decl.countOfGenerics());
+  for (auto &Generic : Decl.getGenericsList()) {
+    writePosition(Generic.Pos);
+    writeString(Generic.Name);
+    writeSymbol(Generic.Symbol);
+    writeString(Generic.BoundName);
+    writeSymbol(Generic.Bound);
+  }
+}
+
+void ASTWriter::writeFunction(ast::FunctionDecl &Fn) {
+  // Importers only call the functions they don't instantiate.
+  auto Block = Fn.getBlockStmt();
+  if (Interface && !Fn.hasGenerics())
+    Block = nullptr;
+
+  add(Fn.getArgumentList());
+  add(Fn.getTypeDecl());
+  add(Block);
+
+  begin(Fn);
+  writeGenericDecl(Fn);
+  writeRefs(Fn.getArgumentList());
+  writeRef(Fn.getTypeDecl());
+  writeRef(Block);
+  writeInt(Fn.isVarArg());
+}
+
+void ASTWriter::visit(ast::FunctionDecl &Fn) { writeFunction(Fn); }
+void ASTWriter::visit(ast::GenericFunctionDecl &Fn) { writeFunction(Fn); }
+
+void ASTWriter::visit(ast::InterfaceDecl &Interface) {
+  ArrayRef<ast::FunctionDecl *> Demands = Interface.getDemands();
+  add(Demands);
+  add(Interface.getParent());
+
+  begin(Interface);
+  writeGenericDecl(Interface);
+  writeRefs(Demands);
+  writeRef(Interface.getParent());
+}
+
+void ASTWriter::visit(ast::VarDecl &Var) {
+  add(Var.getType());
+  add(Var.getValue());
+
+  // Arguments are told apart by the constructor.
+  begin(Var);
+  writeInt(Var.isArg());
+  writeDeclaration(Var);
+  writeRef(Var.getType());
+  writeRef(Var.getValue());
+  writeString(Var.getNamedArg());
+}
+
+void ASTWriter::visit(ast::AliasDecl &Alias) {
+  begin(Alias);
+  writeGenericDecl(Alias);
+  writeString(Alias.getAlias());
+}
+
+void ASTWriter::visit(ast::StructDecl &Struct) {
+  add(Struct.getFieldList());
+
+  begin(Struct);
+  writeGenericDecl(Struct);
+  writeRefs(Struct.getFieldList());
+}
+
+void ASTWriter::visit(ast::EnumDecl &Enum) {
+  // The constructor takes the first member.
+  begin(Enum);
+  auto Members = Enum.getMemberList();
+  writeInt(Members.size());
+  for (auto &Member : Members)
+    writeToken(Member.getTokenInfo());
+
+  writeGenericDecl(Enum);
+}
+
+void ASTWriter::visit(ast::UnionDecl &Union) {
+  ArrayRef<ast::GenericDecl *> Fields = Union.getFieldList();
+  add(Fields);
+
+  begin(Union);
+  writeGenericDecl(Union);
+  writeRefs(Fields);
+}
+
+void ASTWriter::visit(ast::TupleDecl &Tuple) {
+  ArrayRef<ast::VarDecl *> Members = Tuple.getMemberList();
+  add(Members);
+
+  begin(Tuple);
+  writeGenericDecl(Tuple);
+  writeRefs(Members);
+}
+
+void ASTWriter::visit(ast::RangeDecl &Range) {
+  ArrayRef<ast::RangeExpr *> Ranges = Range.getRangeList();
+  add(Ranges);
+
+  begin(Range);
+  writeGenericDecl(Range);
+  writeRefs(Ranges);
+}
+
+void ASTWriter::visit(ast::TypeDef &Def) {
+  add(Def.getTypeDecl());
+
+  begin(Def);
+  writeGenericDecl(Def);
+  writeRef(Def.getTypeDecl());
+}
+
+void ASTWriter::visit(ast::UnaryExpr &Unary) {
+  add(Unary.getOperand());
+
+  begin(Unary);
+  writeInt(static_cast<uint8_t>(Unary.getOperator()));
+  writeRef(Unary.getOperand());
+}
+
+void ASTWriter::visit(ast::BinaryExpr &Binary) {
+  add(Binary.getLHS());
+  add(Binary.getRHS());
+
+  begin(Binary);
+  writeRef(Binary.getLHS());
+  writeInt(static_cast<uint8_t>(Binary.getOperator()));
+  writeRef(Binary.getRHS());
+}
+
+void ASTWriter::visit(ast::LiteralExpr &Literal) {
+  // Only generic bodies are written to an interface.
+  if (Interface && Globals.count(Literal.getVar()))
+    reject(Literal, "`" + Literal.getTokenInfo().toString() +
+                        "` is a top-level variable");
+
+  begin(Literal);
+  writeToken(Literal.getTokenInfo());
+}
+
+void ASTWriter::visit(ast::RangeExpr &Range) {
+  add(Range.getBeginValue());
+  add(Range.getEndValue());
+
+  begin(Range);
+  writeRef(Range.getBeginValue());
+  writeRef(Range.getEndValue());
+}
+
+void ASTWriter::visit(ast::CallExpr &Call) {
+  // Functions only declared here are declared by the importers as well, a
+  // private one isn't there to call.
+  if (Interface) {
+    auto Fn = Module.lookupFunction(Call.getIdentifier()->getSymbol(0));
+    if (Fn && !Module.isImported(Fn) && Fn->getBlockStmt() &&
+        Fn->getIdentifier().startswith("_"))
+      reject(Call, "`" + Fn->getIdentifier() + "` is a private function");
+  }
+
+  add(Call.getIdentifier());
+  for (auto Arg : Call.getArgumentList())
+    add(Arg->Arg);
+
+  begin(Call);
+  writeRef(Call.getIdentifier());
+  writeInt(Call.countOfArgs());
+  for (auto Arg : Call.getArgumentList()) {
+    writeRef(Arg->Arg);
+    writeString(Arg->ArgName);
+  }
+}
+
+void ASTWriter::visit(ast::ArrayIndexExpr &Idx) {
+  add(Idx.getIdentifier());
+  add(Idx.getIdxExpr());
+
+  begin(Idx);
+  writeRef(Idx.getIdentifier());
+  writeRef(Idx.getIdxExpr());
+}
+
+void ASTWriter::visit(ast::QualifiedIdentifierExpr &Ident) {
+  if (Interface && Globals.count(Ident.getVar()))
+    reject(Ident, "`" + Ident.getPart(0) + "` is a top-level variable");
+
+  begin(Ident);
+  writeInt(Ident.getSize());
+  for (auto &Part : Ident.getIdentifier())
+    writeToken(Part);
+}
+
+void ASTWriter::visit(ast::IfExpr &If) {
+  add(If.getExpr());
+  add(If.getBlock());
+  add(If.getElseBranch());
+
+  begin(If);
+  writeRef(If.getExpr());
+  writeRef(If.getBlock());
+  writeRef(If.getElseBranch());
+}
+
+void ASTWriter::visit(ast::ForExpr &For) {
+  add(For.getIter());
+  add(For.getRange());
+  add(For.getBlock());
+  add(For.getIterVar());
+
+  begin(For);
+  writeRef(For.getIter());
+  writeRef(For.getRange());
+  writeRef(For.getBlock());
+  writeRef(For.getIterVar());
+}
+
+void ASTWriter::visit(ast::WhileExpr &While) {
+  add(While.getExpr());
+  add(While.getBlock());
+
+  begin(While);
+  writeRef(While.getExpr());
+  writeRef(While.getBlock());
+}
+
+void ASTWriter::visit(ast::AssignExpr &Assign) {
+  add(Assign.getLHS());
+  add(Assign.getRHS());
+
+  begin(Assign);
+  writeRef(Assign.getLHS());
+  writeInt(static_cast<uint8_t>(Assign.getOperator()));
+  writeRef(Assign.getRHS());
+}
+
+void ASTWriter::visit(ast::OpenStmt &Open) {
+  begin(Open);
+  writeString(Open.getModuleName());
+}
+
+void ASTWriter::visit(ast::BlockStmt &Block) {
+  for (auto &Node : *Block.getBody())
+    add(&Node);
+
+  begin(Block);
+  writeInt(Block.getBody()->size());
+  for (auto &Node : *Block.getBody())
+    writeRef(&Node);
+
+  // The owner is the function the reader finds the block in. The parent may
+  // still be in progress, so it is only looked up once every node is known.
+  if (auto Parent = Block.getParent())
+    Parents.emplace_back(Current, Parent);
+}
+
+void ASTWriter::visit(ast::ReturnStmt &Return) {
+  add(Return.getReturnExpr());
+
+  begin(Return);
+  writeRef(Return.getReturnExpr());
+}
+
+void ASTWriter::visit(ast::StructInitExpr &Struct) {
+  add(Struct.getIdentifier());
+  add(Struct.getValues());
+
+  begin(Struct);
+  writeRef(Struct.getIdentifier());
+  writeRefs(Struct.getValues());
+}
+
+void ASTWriter::visit(ast::ArrayExpr &Array) {
+  add(Array.getValues());
+
+  begin(Array);
+  writeRefs(Array.getValues());
+}
+
+bool writeAST(type::Module &Module, raw_ostream &OS) {
+  return ASTWriter(Module, /*Interface=*/false).writeAST(OS);
+}
+
+bool writeInterface(type::Module &Module, raw_ostream &OS) {
+  return ASTWriter(Module, /*Interface=*/true).writeInterface(OS);
+}
+
+} // namespace north::serialization
@@ -0,0 +1,99 @@
+//===--- Serialization/InterfaceLoader.cpp - Loads interfaces ---*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Serialization/InterfaceLoader.h"
+#include "Serialization/InterfaceFile.h"
+#include "Utils/FileSystem.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+
+namespace north::serialization {
+
+using namespace llvm;
+
+std::string InterfaceLoader::getPath(StringRef Dir, StringRef Name) {
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, Name + InterfaceFileExtension);
+  return std::string(Path.str());
+}
+
+bool InterfaceLoader::store(type::Module &Module, StringRef Dir) {
+  if (sys::fs::create_directories(Dir))
+    return false;
+
+  auto Name = sys::path::stem(Module.getModuleIdentifier());
+  return utils::writeFileAtomically(getPath(Dir, Name), [&](raw_ostream &OS) {
+    return writeInterface(Module, OS);
+  });
+}
+
+bool InterfaceLoader::store(StringRef Name, StringRef Interface,
+                            StringRef Dir) {
+  if (sys::fs::create_directories(Dir))
+    return false;
+
+  return utils::writeFileAtomically(getPath(Dir, Name), [&](raw_ostream &OS) {
+    OS << Interface;
+    return true;
+  });
+}
+
+bool InterfaceLoader::load(type::Module &Importer, ast::OpenStmt &Import) {
+  // A module opening itself would meet its own declarations again.
+  Loaded.insert(sys::path::stem(Importer.getModuleIdentifier()));
+  return load(Importer, Import.getModuleName(), Import.getPosition());
+}
+
+bool InterfaceLoader::load(type::Module &Importer, StringRef Name,
+                           const Position &Pos) {
+  if (!Loaded.insert(Name).second)
+    return true;
+
+  auto &SourceManager = Importer.getSourceManager();
+  auto Range = Importer.getRange(Pos);
+
+  auto Path = getPath(Dir, Name);
+  auto InMemory = Interfaces.find(Name);
+  ErrorOr<std::unique_ptr<MemoryBuffer>> Buffer =
+      InMemory == Interfaces.end()
+          ? MemoryBuffer::getFile(Path)
+          : MemoryBuffer::getMemBuffer(InMemory->second, Path, false);
+  if (!Buffer) {
+    SourceManager.PrintMessage(Range.Start, SourceMgr::DK_Error,
+                               "can't load module '" + Name + "': " + Path +
+                                   ": " + Buffer.getError().message(),
+                               Range);
+    return false;
+  }
+
+  auto Data = (*Buffer)->getBuffer();
+  SourceManager.AddNewSourceBuffer(std::move(*Buffer), SMLoc());
+
+  // Modules it opens are reported where they failed.
+  bool ImportFailed = false;
+  auto LoadImport = [&](StringRef Import) {
+    ImportFailed = !load(Importer, Import, Pos);
+    return !ImportFailed;
+  };
+  if (readInterface(Data, Importer, Pos, LoadImport))
+    return true;
+
+  if (!ImportFailed)
+    SourceManager.PrintMessage(Range.Start, SourceMgr::DK_Error,
+                               "can't load module '" + Name + "': " + Path +
+                                   " is not a valid interface",
+                               Range);
+  return false;
+}
+
+} // namespace north::serialization
@@ -0,0 +1,90 @@
+//===--- Serialization/ObjectCache.cpp - On-disk object cache ---*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Serialization/ObjectCache.h"
+#include "Serialization/InterfaceFile.h"
+#include "Utils/FileSystem.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SHA1.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace north::serialization {
+
+using namespace llvm;
+
+ObjectCache::Key ObjectCache::getKey(StringRef Options, StringRef Source,
+                                     ArrayRef<Import> Imports) {
+  std::string Data;
+  raw_string_ostream OS(Data);
+
+  // Every part is prefixed by its size, so that no two lists of parts hash
+  // the same bytes.
+  auto Add = [&](StringRef Part) { OS << Part.size() << ':' << Part; };
+  Add("north " + std::to_string(ObjectCacheVersion) + " llvm " +
+      LLVM_VERSION_STRING);
+  Add(Options);
+  Add(Source);
+
+  std::vector<Import> Sorted(Imports.begin(), Imports.end());
+  std::sort(Sorted.begin(), Sorted.end());
+  for (auto &[Name, Interface] : Sorted) {
+    Add(Name);
+    Add(Interface);
+  }
+
+  return SHA1::hash(arrayRefFromStringRef(OS.str()));
+}
+
+std::string ObjectCache::getPath(const Key &K, StringRef Extension) const {
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, toHex(K, /*LowerCase=*/true) + Extension);
+  return std::string(Path.str());
+}
+
+bool ObjectCache::load(const Key &K, StringRef ObjectPath,
+                       std::string &Interface) {
+  auto Cached = MemoryBuffer::getFile(getPath(K, InterfaceFileExtension));
+  if (!Cached || sys::fs::copy_file(getPath(K, ".o"), ObjectPath)) {
+    ++Misses;
+    return false;
+  }
+
+  Interface = std::string((*Cached)->getBuffer());
+  ++Hits;
+  return true;
+}
+
+void ObjectCache::store(const Key &K, StringRef ObjectPath,
+                        StringRef Interface) const {
+  auto Object = MemoryBuffer::getFile(ObjectPath);
+  if (!Object || sys::fs::create_directories(Dir))
+    return;
+
+  // The object goes last, a hit needs both files.
+  auto Write = [](StringRef Data) {
+    return [Data](raw_ostream &OS) {
+      OS << Data;
+      return true;
+    };
+  };
+  if (utils::writeFileAtomically(getPath(K, InterfaceFileExtension),
+                                 Write(Interface)))
+    utils::writeFileAtomically(getPath(K, ".o"), Write((*Object)->getBuffer()));
+}
+
+} // namespace north::serialization
@@ -11,7 +11,7 @@
 
 namespace north::targets {
 
-llvm::Value *CBuilder::visit(ast::FunctionDecl &Fn) {
+void CBuilder::visit(ast::FunctionDecl &Fn) {
   outs << (Fn.getTypeDecl() ? Fn.getTypeDecl()->getIdentifier() : "void") << " "
        << Fn.getIdentifier() << "(";
 
@@ -30,22 +30,19 @@ llvm::Value *CBuilder::visit(ast::FunctionDecl &Fn) {
 
   if (auto Block = Fn.getBlockStmt())
     Block->accept(*this);
-
-  return nullptr;
 }
   
-llvm::Value *CBuilder::visit(ast::GenericFunctionDecl &Fn) {
-  return nullptr;
+void CBuilder::visit(ast::GenericFunctionDecl &Fn) {
 }
 
-llvm::Value *CBuilder::visit(ast::InterfaceDecl &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::VarDecl &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::AliasDecl &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::StructDecl &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::EnumDecl &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::UnionDecl &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::TupleDecl &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::RangeDecl &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::TypeDef &) { return nullptr; }
+void CBuilder::visit(ast::InterfaceDecl &) {}
+void CBuilder::visit(ast::VarDecl &) {}
+void CBuilder::visit(ast::AliasDecl &) {}
+void CBuilder::visit(ast::StructDecl &) {}
+void CBuilder::visit(ast::EnumDecl &) {}
+void CBuilder::visit(ast::UnionDecl &) {}
+void CBuilder::visit(ast::TupleDecl &) {}
+void CBuilder::visit(ast::RangeDecl &) {}
+void CBuilder::visit(ast::TypeDef &) {}
 
 } // namespace north::targets
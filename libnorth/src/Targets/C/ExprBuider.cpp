@@ -11,24 +11,24 @@
 
 namespace north::targets {
 
-llvm::Value *CBuilder::visit(ast::UnaryExpr &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::BinaryExpr &) { return nullptr; }
+void CBuilder::visit(ast::UnaryExpr &) {}
+void CBuilder::visit(ast::BinaryExpr &) {}
 
-llvm::Value *CBuilder::visit(ast::LiteralExpr &Literal) {
+void CBuilder::visit(ast::LiteralExpr &Literal) {
   auto Token = Literal.getTokenInfo();
   switch (Token.Type) {
   case Token::String:
     outs << "\"" << Token.toString() << "\"";
-    return nullptr;
+    return;
 
   default:
-    return nullptr;
+    return;
   }
 }
 
-llvm::Value *CBuilder::visit(ast::RangeExpr &) { return nullptr; }
+void CBuilder::visit(ast::RangeExpr &) {}
 
-llvm::Value *CBuilder::visit(ast::CallExpr &Callee) {
+void CBuilder::visit(ast::CallExpr &Callee) {
   Callee.getIdentifier()->accept(*this);
   outs << "(";
 
@@ -39,23 +39,19 @@ llvm::Value *CBuilder::visit(ast::CallExpr &Callee) {
   }
 
   outs << ");\n";
-
-  return nullptr;
 }
 
-llvm::Value *CBuilder::visit(ast::ArrayIndexExpr &) { return nullptr; }
+void CBuilder::visit(ast::ArrayIndexExpr &) {}
 
-llvm::Value *CBuilder::visit(ast::QualifiedIdentifierExpr &Identifier) {
+void CBuilder::visit(ast::QualifiedIdentifierExpr &Identifier) {
   outs << Identifier.getIdentifier()[0].toString();
-
-  return nullptr;
 }
 
-llvm::Value *CBuilder::visit(ast::IfExpr &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::ForExpr &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::WhileExpr &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::AssignExpr &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::StructInitExpr &) { return nullptr; }
-llvm::Value *CBuilder::visit(ast::ArrayExpr &) { return nullptr; }
+void CBuilder::visit(ast::IfExpr &) {}
+void CBuilder::visit(ast::ForExpr &) {}
+void CBuilder::visit(ast::WhileExpr &) {}
+void CBuilder::visit(ast::AssignExpr &) {}
+void CBuilder::visit(ast::StructInitExpr &) {}
+void CBuilder::visit(ast::ArrayExpr &) {}
 
 } // namespace north::targets
\ No newline at end of file
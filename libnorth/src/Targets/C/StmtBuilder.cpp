@@ -11,12 +11,10 @@
 
 namespace north::targets {
 
-llvm::Value *CBuilder::visit(ast::OpenStmt &) {
-
-  return nullptr;
+void CBuilder::visit(ast::OpenStmt &) {
 }
 
-llvm::Value *CBuilder::visit(ast::BlockStmt &Block) {
+void CBuilder::visit(ast::BlockStmt &Block) {
   outs << "{\n";
 
   if (auto Body = Block.getBody()) {
@@ -25,15 +23,11 @@ llvm::Value *CBuilder::visit(ast::BlockStmt &Block) {
   }
 
   outs << "\n}\n";
-
-  return nullptr;
 }
 
-llvm::Value *CBuilder::visit(ast::ReturnStmt &Return) {
+void CBuilder::visit(ast::ReturnStmt &Return) {
   outs << "return ";
   Return.getReturnExpr()->accept(*this);
-
-  return nullptr;
 }
 
 } // namespace north::targets
\ No newline at end of file
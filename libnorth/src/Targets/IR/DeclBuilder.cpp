@@ -12,13 +12,21 @@
 #include "Type/TypeInference.h"
 
 #include <llvm/ADT/APFloat.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/Type.h>
+#include <llvm/Linker/Linker.h>
 
 #include <llvm/ADT/Twine.h>
 #include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/Parallel.h>
 #include <llvm/Support/SourceMgr.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
 namespace north::targets {
 
 using namespace llvm;
@@ -27,25 +35,348 @@ Value *IRBuilder::visit(ast::FunctionDecl &Fn) {
   if (!Fn.getBlockStmt())
     return nullptr;
   
-  auto BB = BasicBlock::Create(Context, "entry", Fn.getIR());
+  auto BB = BasicBlock::Create(Context, "entry", getFunction(Fn));
   Builder.SetInsertPoint(BB);
   CurrentFn = &Fn;
 
   return Fn.getBlockStmt()->accept(*this);
 }
   
-llvm::Value *IRBuilder::visit(ast::GenericFunctionDecl &GenericFn) {
-  for (auto Callee : GenericFn.getCalls()) {
-    auto Fn = GenericFn.instantiate(Callee, Module);
-    if (!Fn->maybeGetIR()) {
-      Fn->createIR(Module);
-      Callee->setCallableFn(Fn, Module);
-      Fn->accept(*this);
-    } else {
+// Instances are emitted by instantiateGenerics().
+llvm::Value *IRBuilder::visit(ast::GenericFunctionDecl &) { return nullptr; }
+
+namespace {
+
+/// Instances emitted into one module by instantiateGenerics() at least,
+/// enough to outweigh setting up its context and linking it back.
+constexpr size_t MinInstancesPerChunk = 32;
+
+/// Chunks made per thread, so that a thread left with slow ones is made up
+/// for by the others.
+constexpr size_t ChunksPerJob = 4;
+
+} // namespace
+
+std::vector<ast::FunctionDecl *> IRBuilder::declareInstances() {
+  std::vector<ast::FunctionDecl *> Instances;
+
+  // Collect the distinct instances of the whole module first. An instance
+  // is declared as soon as it is found, while its arguments are bound.
+  for (auto &Node : *Module->getAST()) {
+    auto GenericFn = dyn_cast<ast::GenericFunctionDecl>(&Node);
+    if (!GenericFn)
+      continue;
+
+    type::checkGenericFunction(*GenericFn, Module);
+
+    for (auto Callee : GenericFn->getCalls()) {
+      // Failures were reported, the call is left unbound.
+      auto Fn = GenericFn->instantiate(Callee, Module);
+      if (!Fn)
+        continue;
+
+      if (!Fn->maybeGetIR()) {
+        Fn->createIR(Module);
+        // The module exporting the function may have the same instance.
+        if (Module->isImported(GenericFn))
+          Fn->getIR()->setLinkage(GlobalValue::InternalLinkage);
+        Instances.push_back(Fn);
+      }
       Callee->setCallableFn(Fn, Module);
     }
   }
-  return nullptr;
+
+  return Instances;
+}
+
+IRBuilder::InstanceTypes IRBuilder::typeInstance(ast::FunctionDecl &Fn) {
+  InstanceTypes Result;
+  bool Checked = Fn.isBodyChecked();
+
+  // Reports a return value of another type than the function's, as many
+  // times as emitting the instance used to: once per block.
+  auto CheckReturn = [&] {
+    llvm::Type *Declared = Fn.getTypeIR();
+    if (!Declared && Fn.getTypeDecl())
+      Declared = Module->getType(Fn.getTypeDecl()->getSymbol())->getIR();
+    if (Checked || !Declared ||
+        type::inferFunctionType(Fn, Module)->getIR() == Declared)
+      return;
+
+    auto Range = Module->getRange(Fn.getTypeDecl()->getPosition());
+    SourceManager.PrintMessage(Range.Start, SourceMgr::DiagKind::DK_Error,
+        "return value type of `" + Fn.getIdentifier() +
+            "` does't match the function type", Range);
+  };
+
+  // The variables get their type in the order the body declares them, since
+  // the inference of a variable's value reads those of the variables it uses.
+  std::function<void(ast::Node *)> Walk = [&](ast::Node *N) {
+    if (!N)
+      return;
+
+    if (auto Block = dyn_cast<ast::BlockStmt>(N)) {
+      if (auto Body = Block->getBody())
+        for (auto &Stmt : *Body)
+          Walk(&Stmt);
+      CheckReturn();
+    } else if (auto Var = dyn_cast<ast::VarDecl>(N)) {
+      auto Value = Var->getValue();
+      auto Inferred = Value ? type::inferVarType(*Var, Module) : nullptr;
+      if (Checked && Value) {
+        // Typed off the value's IR once emitted, see visit(VarDecl &).
+        if (Inferred)
+          Var->setIRType(Inferred->getIR());
+      } else if (auto TypeDecl = Var->getType()) {
+        auto Type = Module->getType(TypeDecl->getSymbol())->getIR();
+        if (TypeDecl->isPtr())
+          Type = Type->getPointerTo(0);
+        Result[Var] = Type;
+
+        if (Inferred && Inferred->getIR() != Type) {
+          auto Range = Module->getRange(Var->getPosition());
+          SourceManager.PrintMessage(Range.Start, SourceMgr::DiagKind::DK_Error,
+              "type of value `" + Var->getIdentifier() +
+                  "` type does't match the variable type", Range);
+        }
+      } else if (Inferred) {
+        Result[Var] = Inferred->getIR();
+        Var->setIRType(Inferred->getIR());
+      }
+      Walk(Value);
+    } else if (auto Return = dyn_cast<ast::ReturnStmt>(N)) {
+      Walk(Return->getReturnExpr());
+    } else if (auto If = dyn_cast<ast::IfExpr>(N)) {
+      Walk(If->getExpr());
+      Walk(If->getBlock());
+      if (auto Else = If->getElseBranch())
+        Walk(Else->getBlock());
+    } else if (auto For = dyn_cast<ast::ForExpr>(N)) {
+      Walk(For->getRange());
+      Walk(For->getBlock());
+    } else if (auto While = dyn_cast<ast::WhileExpr>(N)) {
+      Walk(While->getExpr());
+      Walk(While->getBlock());
+    } else if (auto Range = dyn_cast<ast::RangeExpr>(N)) {
+      Walk(Range->getBeginValue());
+      Walk(Range->getEndValue());
+    } else if (auto Unary = dyn_cast<ast::UnaryExpr>(N)) {
+      Walk(Unary->getOperand());
+    } else if (auto Binary = dyn_cast<ast::BinaryExpr>(N)) {
+      Walk(Binary->getLHS());
+      Walk(Binary->getRHS());
+    } else if (auto Assign = dyn_cast<ast::AssignExpr>(N)) {
+      Walk(Assign->getLHS());
+      Walk(Assign->getRHS());
+    } else if (auto Call = dyn_cast<ast::CallExpr>(N)) {
+      for (auto Arg : Call->getArgumentList())
+        Walk(Arg->Arg);
+    } else if (auto Idx = dyn_cast<ast::ArrayIndexExpr>(N)) {
+      Walk(Idx->getIdentifier());
+      Walk(Idx->getIdxExpr());
+    } else if (auto Struct = dyn_cast<ast::StructInitExpr>(N)) {
+      Result[Struct] = Struct->getStructType()->getIR();
+      for (auto Value : Struct->getValues())
+        Walk(Value);
+    } else if (auto Array = dyn_cast<ast::ArrayExpr>(N)) {
+      Result[Array] = type::inferExprType(Array->getValue(0), Module)->getIR();
+      for (auto Value : Array->getValues())
+        Walk(Value);
+    }
+  };
+
+  Module->enterGenericBody();
+  Fn.bindArguments();
+  Walk(Fn.getBlockStmt());
+  Module->leaveGenericBody();
+  return Result;
+}
+
+void IRBuilder::emitInstance(ast::FunctionDecl &Fn,
+                             const InstanceTypes &FnTypes) {
+  Types = &FnTypes;
+  for (auto &Arg : getFunction(Fn)->args())
+    Locals[Fn.getArg(Arg.getArgNo())] = {&Arg, Arg.getType()};
+
+  Fn.accept(*this);
+
+  Types = nullptr;
+  Locals.clear();
+}
+
+bool IRBuilder::instantiateGenerics(unsigned Jobs) {
+  auto Instances = declareInstances();
+
+  std::vector<InstanceTypes> InstancesTypes;
+  InstancesTypes.reserve(Instances.size());
+  for (auto Fn : Instances)
+    InstancesTypes.push_back(typeInstance(*Fn));
+
+  size_t Chunks = std::min<size_t>(Jobs * ChunksPerJob,
+                                   Instances.size() / MinInstancesPerChunk);
+  if (Jobs < 2 || Chunks < 2) {
+    for (size_t I = 0; I < Instances.size(); ++I)
+      emitInstance(*Instances[I], InstancesTypes[I]);
+    return true;
+  }
+
+  // Each chunk goes to a module of its own, written as bitcode to leave its
+  // context. Everything there is external, so that it links by name to
+  // what this module defines. Up to Jobs chunks are emitted at once, each
+  // thread taking the next chunk left once done with one.
+  std::vector<SmallVector<char, 0>> Bitcode(Chunks);
+  std::atomic<size_t> Next(0);
+  parallelForEachN(size_t(0), std::min<size_t>(Jobs, Chunks), [&](size_t) {
+    for (size_t Chunk; (Chunk = Next++) < Chunks;) {
+      LLVMContext ChunkContext;
+      llvm::Module ChunkModule(Module->getModuleIdentifier(), ChunkContext);
+      IRBuilder ChunkBuilder(Module, ChunkModule);
+
+      size_t End = (Chunk + 1) * Instances.size() / Chunks;
+      for (size_t I = Chunk * Instances.size() / Chunks; I < End; ++I)
+        ChunkBuilder.emitInstance(*Instances[I], InstancesTypes[I]);
+
+      raw_svector_ostream OS(Bitcode[Chunk]);
+      WriteBitcodeToFile(ChunkModule, OS);
+    }
+  });
+
+  // Local functions are made external while linking, and local again once
+  // the chunks' references were resolved to them. Linking replaces the
+  // declarations the chunks define, so functions are found by name after.
+  std::vector<std::pair<std::string, GlobalValue::LinkageTypes>> Local;
+  for (auto &Fn : *Module)
+    if (Fn.hasLocalLinkage()) {
+      Local.emplace_back(Fn.getName().str(), Fn.getLinkage());
+      Fn.setLinkage(GlobalValue::ExternalLinkage);
+    }
+
+  std::vector<std::string> Names;
+  for (auto Fn : Instances)
+    Names.push_back(Fn->getIR()->getName().str());
+
+  // A chunk partly linked can't be emitted again, so any failure is final.
+  // One linker for all of them, as each would walk the whole module again.
+  Linker ModuleLinker(*Module);
+  for (auto &Chunk : Bitcode) {
+    auto Buffer = MemoryBufferRef(StringRef(Chunk.data(), Chunk.size()),
+                                  Module->getModuleIdentifier());
+    auto Parsed = parseBitcodeFile(Buffer, Context);
+    if (!Parsed) {
+      consumeError(Parsed.takeError());
+      return false;
+    }
+    if (ModuleLinker.linkInModule(std::move(*Parsed)))
+      return false;
+  }
+
+  for (size_t I = 0; I < Instances.size(); ++I)
+    Instances[I]->setIR(Module->getFunction(Names[I]));
+  for (auto &[Name, Linkage] : Local)
+    Module->getFunction(Name)->setLinkage(Linkage);
+  return true;
+}
+
+llvm::Type *IRBuilder::mapType(llvm::Type *T) {
+  if (!T || &T->getContext() == &Context)
+    return T;
+  if (auto Mapped = MappedTypes.lookup(T))
+    return Mapped;
+
+  llvm::Type *Result = nullptr;
+  if (auto Struct = dyn_cast<StructType>(T); Struct && !Struct->isLiteral()) {
+    // Named first, so that the struct may contain pointers to itself.
+    auto Created = StructType::create(Context, Struct->getName());
+    MappedTypes[T] = Created;
+    SmallVector<llvm::Type *, 8> Fields;
+    for (auto Field : Struct->elements())
+      Fields.push_back(mapType(Field));
+    if (!Struct->isOpaque())
+      Created->setBody(Fields, Struct->isPacked());
+    return Created;
+  }
+
+  switch (T->getTypeID()) {
+  case llvm::Type::VoidTyID:
+    Result = llvm::Type::getVoidTy(Context);
+    break;
+  case llvm::Type::HalfTyID:
+    Result = llvm::Type::getHalfTy(Context);
+    break;
+  case llvm::Type::FloatTyID:
+    Result = llvm::Type::getFloatTy(Context);
+    break;
+  case llvm::Type::DoubleTyID:
+    Result = llvm::Type::getDoubleTy(Context);
+    break;
+  case llvm::Type::IntegerTyID:
+    Result = IntegerType::get(Context, T->getIntegerBitWidth());
+    break;
+  case llvm::Type::PointerTyID:
+    Result = mapType(T->getPointerElementType())
+                 ->getPointerTo(T->getPointerAddressSpace());
+    break;
+  case llvm::Type::ArrayTyID:
+    Result = ArrayType::get(mapType(T->getArrayElementType()),
+                            T->getArrayNumElements());
+    break;
+  case llvm::Type::StructTyID: {
+    SmallVector<llvm::Type *, 8> Fields;
+    for (auto Field : cast<StructType>(T)->elements())
+      Fields.push_back(mapType(Field));
+    Result = StructType::get(Context, Fields, cast<StructType>(T)->isPacked());
+    break;
+  }
+  case llvm::Type::FunctionTyID: {
+    auto Fn = cast<FunctionType>(T);
+    SmallVector<llvm::Type *, 8> Params;
+    for (auto Param : Fn->params())
+      Params.push_back(mapType(Param));
+    Result = FunctionType::get(mapType(Fn->getReturnType()), Params,
+                               Fn->isVarArg());
+    break;
+  }
+  default:
+    llvm_unreachable("type the language can't express");
+  }
+
+  MappedTypes[T] = Result;
+  return Result;
+}
+
+llvm::Function *IRBuilder::getFunction(ast::FunctionDecl &Fn) {
+  auto IR = Fn.getIR();
+  if (&IR->getContext() == &Context)
+    return IR;
+
+  if (auto Declared = Target.getFunction(IR->getName()))
+    return Declared;
+  return Function::Create(
+      cast<FunctionType>(mapType(IR->getFunctionType())),
+      GlobalValue::ExternalLinkage, IR->getName(), Target);
+}
+
+std::pair<llvm::Value *, llvm::Type *> IRBuilder::getVar(ast::VarDecl &Var) {
+  if (Types) {
+    auto Local = Locals.find(&Var);
+    if (Local != Locals.end())
+      return {Local->second.first, Local->second.second
+                                       ? Local->second.second
+                                       : mapType(Var.getIRType())};
+  }
+  assert(&Target == Module && "variable of the module in another context");
+  return {Var.getIRValue(), Var.getIRType()};
+}
+
+void IRBuilder::setVar(ast::VarDecl &Var, llvm::Value *Value,
+                       llvm::Type *Type) {
+  if (Types) {
+    Locals[&Var] = {Value, Type};
+    return;
+  }
+  Var.setIRValue(Value);
+  if (Type)
+    Var.setIRType(Type);
 }
 
 Value *IRBuilder::visit(ast::InterfaceDecl &) { return nullptr; }
@@ -53,33 +384,47 @@ Value *IRBuilder::visit(ast::InterfaceDecl &) { return nullptr; }
 Value *IRBuilder::visit(ast::VarDecl &Var) {
   llvm::Type *Type = nullptr;
 
-  if (auto TypeDecl = Var.getType()) {
-    Type = Module->getType(Var.getType()->getIdentifier())->getIR();
+  // Within an instance of a checked generic body the value's type is
+  // already known to fit, and is read off its IR instead of inferred.
+  if (CurrentFn && CurrentFn->isBodyChecked() && Var.getValue()) {
+    auto Val = Var.getValue()->accept(*this);
+    if (!Val)
+      return nullptr;
+    auto IR = Builder.CreateAlloca(Val->getType(), nullptr, Var.getIdentifier());
+    setVar(Var, IR, Val->getType());
+    Builder.CreateStore(Val, IR);
+    return IR;
+  }
+
+  if (Types) {
+    // Typed, and checked, by typeInstance().
+    Type = mapType(Types->lookup(&Var));
+  } else if (auto TypeDecl = Var.getType()) {
+    Type = Module->getType(Var.getType()->getSymbol())->getIR();
     if (TypeDecl->isPtr())
       Type = Type->getPointerTo(0);
 
-    auto InferredType = inferVarType(Var, Module, CurrentScope)->getIR();
+    auto InferredType = inferVarType(Var, Module)->getIR();
     if (InferredType != Type) {
       auto Pos = Var.getPosition();
 
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+      auto Range = Module->getRange(Pos);
 
       SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
           "type of value `" + Var.getIdentifier() +  "` type does't match the variable type", Range);
     }
   } else {
-    Type = inferVarType(Var, Module, CurrentScope)->getIR();
+    Type = inferVarType(Var, Module)->getIR();
     Var.setIRType(Type);
   }
 
   auto IR = Builder.CreateAlloca(Type, nullptr, Var.getIdentifier());
-  Var.setIRValue(IR);
-  CurrentScope->addElement(&Var);
+  setVar(Var, IR, Types || !Var.getType() ? Type : nullptr);
 
+  // A value found invalid was reported, and leaves the variable unset.
   if (auto Val = Var.getValue())
-    Builder.CreateStore(Val->accept(*this), IR);
+    if (auto IRVal = Val->accept(*this))
+      Builder.CreateStore(IRVal, IR);
 
   return IR;
 }
@@ -91,11 +436,11 @@ Value *IRBuilder::visit(ast::StructDecl &Struct) {
   Args.reserve(Struct.getFieldList().size());
 
   for (auto Field : Struct.getFieldList()) {
-    auto Ident = Field->getType()->getIdentifier();
+    auto Ident = Field->getType()->getSymbol();
     Args.push_back(Module->getType(Ident)->getIR());
   }
   
-  auto IR = StructType::create(targets::IRBuilder::getContext(), Args, "lol");
+  auto IR = StructType::create(Context, Args, "lol");
   Struct.setIR(IR);
   outs() << *IR << '\n';
   return nullptr;
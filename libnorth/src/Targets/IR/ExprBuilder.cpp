@@ -32,12 +32,11 @@ Value *IRBuilder::visit(ast::UnaryExpr &Unary) {
   if (!Expr) {
     auto Pos = Unary.getPosition();
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+    auto Range = Module->getRange(Pos);
 
     SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
                                "invalid expression", Range);
+  return nullptr;
   }
 
   switch (Unary.getOperator()) {
@@ -80,12 +79,12 @@ Value *IRBuilder::visit(ast::BinaryExpr &Expr) {
     auto LPos = Expr.getLHS()->getPosition();
     auto RPos = Expr.getRHS()->getPosition();
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(LPos.Offset),
-        llvm::SMLoc::getFromPointer(RPos.Offset + RPos.Length));
+    auto Range = llvm::SMRange(Module->getRange(LPos).Start,
+                               Module->getRange(RPos).End);
 
     SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
                                "invalid expression", Range);
+  return nullptr;
   }
 
   switch (Expr.getOperator()) {
@@ -187,7 +186,6 @@ Constant *IRBuilder::createEscapedString(ast::LiteralExpr &Literal) {
 
 Value *IRBuilder::visit(ast::LiteralExpr &Literal) {
   auto Token = Literal.getTokenInfo();
-  llvm::SMRange Range;
 
   switch (Token.Type) {
   case Token::Nil:
@@ -204,23 +202,17 @@ Value *IRBuilder::visit(ast::LiteralExpr &Literal) {
     return ConstantInt::get(Context, APInt(32, Token.toString(), 10));
 
   case Token::Identifier:
-    if (auto Var = CurrentScope->lookup(Token.toString())) {
-      auto IRType = Var->getIRType();
+    if (auto Var = Literal.getVar()) {
+      auto [IRValue, IRType] = getVar(*Var);
       
       assert(IRType);
-      assert(Var->getIRValue());
+      assert(IRValue);
       
       return GetVal && !Var->isArg() && (LoadArg && !isa<StructType>(IRType) && !isa<ArrayType>(IRType))
-               ? Builder.CreateLoad(Var->getIRValue())
-               : Var->getIRValue();
+               ? Builder.CreateLoad(IRValue)
+               : IRValue;
     }
-
-    Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Literal.getPosition().Offset),
-        llvm::SMLoc::getFromPointer(Literal.getPosition().Offset + Literal.getPosition().Length));
-
-    SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                               "unknown symbol `" + Token.toString() + "`", Range);
+    llvm_unreachable("identifier must be resolved by Sema");
 
   default:
     assert(0 && "unknown literal");
@@ -254,9 +246,11 @@ Value *IRBuilder::visit(ast::CallExpr &Callee) {
     GetVal = false;
   }
   
-  auto FnIR = Fn->getIR();
+  auto FnIR = getFunction(*Fn);
   auto IR = Builder.CreateCall(FnIR->getFunctionType(), FnIR, Args);
-  Callee.setIR(IR);
+  // Instances share the call.
+  if (!Types)
+    Callee.setIR(IR);
 
   return IR;
 }
@@ -279,16 +273,15 @@ llvm::Value *IRBuilder::visit(ast::ArrayIndexExpr &Idx) {
 }
 
 llvm::Value *IRBuilder::visit(ast::QualifiedIdentifierExpr &Ident) {
-  auto FirstPart = Ident.getPart(0);
-
-  if (auto Var = CurrentScope->lookup(FirstPart))
-    return getStructField(Var->getValue() ? Var->getValue() : Var,
-                          Var->getIRValue(), Ident);
-
-  if (auto Type = Module->getTypeOrNull(FirstPart)) {
-    auto T = static_cast<ast::TypeDef *>(Type->getDecl())->getTypeDecl();
-    if (auto Enum = dyn_cast<ast::EnumDecl>(T))
-      return Enum->getValue(Ident.getPart(1));
+  if (auto Var = Ident.getVar())
+    return getStructField(getVar(*Var).first, Ident);
+
+  if (auto Enum = Ident.getEnum()) {
+    auto Value = Enum->getValue(Ident.getSymbol(1));
+    if (auto Int = dyn_cast<ConstantInt>(Value);
+        Int && &Int->getContext() != &Context)
+      return ConstantInt::get(mapType(Int->getType()), Int->getValue());
+    return Value;
   }
 
   llvm_unreachable("invalid qualified expr");
@@ -303,12 +296,11 @@ Value *IRBuilder::visit(ast::IfExpr &If) {
   if (!Cond) {
     auto Pos = If.getPosition();
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+    auto Range = Module->getRange(Pos);
 
     SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
                                "empty if condition", Range);
+  return nullptr;
   }
 
   Cond = cmpWithTrue(Cond);
@@ -325,12 +317,11 @@ Value *IRBuilder::visit(ast::IfExpr &If) {
   if (!If.getBlock()) {
     auto Pos = If.getPosition();
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+    auto Range = Module->getRange(Pos);
 
     SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
                                "empty if block", Range);
+  return nullptr;
   }
   auto Then = If.getBlock()->accept(*this);
 
@@ -350,9 +341,7 @@ Value *IRBuilder::visit(ast::IfExpr &If) {
     } else {
       auto Pos = If.getPosition();
 
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+      auto Range = Module->getRange(Pos);
 
       SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
                                  "empty else block", Range);
@@ -375,8 +364,6 @@ Value *IRBuilder::visit(ast::IfExpr &If) {
 }
 
 Value *IRBuilder::visit(ast::ForExpr &For) {
-  auto Iter = static_cast<ast::LiteralExpr *>(For.getIter());
-
   Value *StartVal = nullptr;
   Value *EndVal = nullptr;
 
@@ -395,12 +382,11 @@ Value *IRBuilder::visit(ast::ForExpr &For) {
   if (!StartVal || !EndVal) {
     auto Pos = For.getPosition();
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+    auto Range = Module->getRange(Pos);
 
     SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
                                "invalid range", Range);
+  return nullptr;
   }
 
   auto Fn = Builder.GetInsertBlock()->getParent();
@@ -410,13 +396,12 @@ Value *IRBuilder::visit(ast::ForExpr &For) {
   Builder.CreateBr(LoopBB);
   Builder.SetInsertPoint(LoopBB);
 
-  auto ASTVar = new ast::VarDecl(Iter->getTokenInfo(), true);
+  auto ASTVar = For.getIterVar();
   auto IRVar =
       Builder.CreatePHI(Type::getInt32Ty(Context), 2, ASTVar->getIdentifier());
   IRVar->addIncoming(StartVal, PreheaderBB);
 
-  ASTVar->setIRValue(IRVar);
-  CurrentScope->addElement(ASTVar);
+  setVar(*ASTVar, IRVar, nullptr);
 
   auto Body = For.getBlock()->accept(*this);
   auto StepVal = ConstantInt::get(Context, APInt(32, 1));
@@ -439,12 +424,11 @@ Value *IRBuilder::visit(ast::WhileExpr &While) {
   if (!Cond) {
     auto Pos = While.getExpr()->getPosition();
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+    auto Range = Module->getRange(Pos);
 
     SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
                                "invalid while expression", Range);
+  return nullptr;
   }
 
   auto Fn = Builder.GetInsertBlock()->getParent();
@@ -485,12 +469,11 @@ Value *IRBuilder::visit(ast::AssignExpr &Assign) {
   if (!LHS || !RHS) {
     auto Pos = Assign.getPosition();
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+    auto Range = Module->getRange(Pos);
 
     SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
                                "invalid assign expression", Range);
+  return nullptr;
   }
 
   switch (Assign.getOperator()) {
@@ -527,9 +510,7 @@ Value *IRBuilder::visit(ast::AssignExpr &Assign) {
 }
 
 Value *IRBuilder::visit(ast::StructInitExpr &Struct) {
-  auto Ty = getTypeFromIdent(Struct.getIdentifier());
-  auto TypeDef = static_cast<ast::TypeDef *>(Ty->getDecl());
-  Struct.setType(static_cast<ast::StructDecl *>(TypeDef->getTypeDecl()));
+  auto Ty = Struct.getStructType();
 
   std::vector<Constant *> Fields;
   GetVal = true;
@@ -537,14 +518,17 @@ Value *IRBuilder::visit(ast::StructInitExpr &Struct) {
     Fields.push_back(static_cast<Constant *>(Field->accept(*this)));
   GetVal = false;
 
-  auto IR = ConstantStruct::get(static_cast<StructType *>(Ty->getIR()), Fields);
-  Struct.setIRValue(IR);
+  auto IRType = Types ? mapType(Types->lookup(&Struct)) : Ty->getIR();
+  auto IR = ConstantStruct::get(static_cast<StructType *>(IRType), Fields);
+  if (!Types)
+    Struct.setIRValue(IR);
   return IR;
 }
 
 Value *IRBuilder::visit(ast::ArrayExpr &Array) {
   auto FirstElemTy =
-      type::inferExprType(Array.getValue(0), Module, CurrentScope)->getIR();
+      Types ? mapType(Types->lookup(&Array))
+            : type::inferExprType(Array.getValue(0), Module)->getIR();
   auto Ty = ArrayType::get(FirstElemTy, Array.getCap());
 
   std::vector<Constant *> Values;
@@ -555,12 +539,11 @@ Value *IRBuilder::visit(ast::ArrayExpr &Array) {
     if (Elem->getType() != FirstElemTy && !CastInst::isCastable(Elem->getType(), FirstElemTy)) {
       auto Pos = Array.getPosition();
 
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+      auto Range = Module->getRange(Pos);
 
       SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
                                  "array elements can't has different types", Range);
+  return nullptr;
     }
 
     Values.push_back(static_cast<Constant *>(Elem));
@@ -19,21 +19,10 @@ namespace north::targets {
 
 using namespace llvm;
 
-llvm::LLVMContext IRBuilder::Context;
-
-Value *IRBuilder::visit(ast::OpenStmt &O) {
-  Module->addImport(&O);
-
-  return nullptr;
-}
+// Imports are loaded as the module is built, see Module::addImport().
+Value *IRBuilder::visit(ast::OpenStmt &) { return nullptr; }
 
 Value *IRBuilder::visit(ast::BlockStmt &Block) {
-  type::Scope Scope(CurrentScope, Module);
-  CurrentScope = &Scope;
-
-  for (auto Arg : CurrentFn->getArgumentList())
-    CurrentScope->addElement(Arg);
-  
   Value *Result = nullptr;
 
   if (auto Body = Block.getBody()) {
@@ -41,29 +30,31 @@ Value *IRBuilder::visit(ast::BlockStmt &Block) {
       Result = I->accept(*this);
   }
 
-  if (auto Type = CurrentFn->getTypeIR()) {
-    auto InferredType = type::inferFunctionType(*CurrentFn, Module, CurrentScope)->getIR();
+  // An instance of a body checked with its generic parameters, see
+  // type::checkGenericFunction(), isn't checked again, and the others were
+  // by typeInstance().
+  if (CurrentFn->isBodyChecked() || Types) {
+    if (!CurrentFn->getTypeDecl() && !isa<ReturnInst>(Result))
+      Builder.CreateRetVoid();
+  } else if (auto Type = CurrentFn->getTypeIR()) {
+    auto InferredType = type::inferFunctionType(*CurrentFn, Module)->getIR();
     assert(Type);
     
     if (InferredType != Type) {
       auto Pos = CurrentFn->getTypeDecl()->getPosition();
 
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+      auto Range = Module->getRange(Pos);
 
       SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
           "return value type of `" + CurrentFn->getIdentifier() +  "` does't match the function type", Range);
     }
   } else if (auto TypeDecl = CurrentFn->getTypeDecl()) {
-    auto InferredType = type::inferFunctionType(*CurrentFn, Module, CurrentScope)->getIR();
-    auto DeclaredType = Module->getType(TypeDecl->getIdentifier())->getIR();
+    auto InferredType = type::inferFunctionType(*CurrentFn, Module)->getIR();
+    auto DeclaredType = Module->getType(TypeDecl->getSymbol())->getIR();
     if (InferredType != DeclaredType) {
       auto Pos = CurrentFn->getTypeDecl()->getPosition();
 
-      auto Range = llvm::SMRange(
-          llvm::SMLoc::getFromPointer(Pos.Offset),
-          llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+      auto Range = Module->getRange(Pos);
 
       SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
           "return value type of `" + CurrentFn->getIdentifier() +  "` does't match the function type", Range);
@@ -73,7 +64,6 @@ Value *IRBuilder::visit(ast::BlockStmt &Block) {
       Builder.CreateRetVoid();
   }
 
-  CurrentScope = Scope.getParent();
   return Result;
 }
 
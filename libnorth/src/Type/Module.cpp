@@ -11,6 +11,7 @@
 #include "Type/Scope.h"
 #include "Type/Type.h"
 
+#include <llvm/ADT/STLExtras.h>
 #include <llvm/Support/Path.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Transforms/IPO/FunctionImport.h>
@@ -23,62 +24,109 @@ namespace north::type {
 using namespace llvm;
 using namespace sys::path;
 
-Module::Module(llvm::StringRef ModuleID, llvm::LLVMContext &C, llvm::SourceMgr &SourceMgr)
-    : llvm::Module(stem(ModuleID), C), GlobalScope(new Scope(this)), SourceManager(SourceMgr) {
+Module::Module(llvm::StringRef ModuleID, llvm::LLVMContext &C,
+               llvm::SourceMgr &SourceMgr, const PrimitiveTypes &Primitives)
+    : llvm::Module(stem(ModuleID), C), GlobalScope(new Scope(this)),
+      Primitives(Primitives), SourceManager(SourceMgr),
+      Lines(SourceMgr.getMemoryBuffer(SourceMgr.getMainFileID())->getBuffer()) {
+  assert(&Primitives.Void->getIR()->getContext() == &C &&
+         "Primitive types of another context");
 
   setSourceFileName(ModuleID);
 
-  TypeList.try_emplace("void",   Type::Void  );
-  TypeList.try_emplace("i8",     Type::Int8  );
-  TypeList.try_emplace("i16",    Type::Int16 );
-  TypeList.try_emplace("i32",    Type::Int32 );
-  TypeList.try_emplace("i64",    Type::Int64 );
-  TypeList.try_emplace("float",  Type::Float );
-  TypeList.try_emplace("double", Type::Double);
-  TypeList.try_emplace("char",   Type::Char  );
+  TypeList.insert(Symbols.intern("void"),   Primitives.Void,   Symbols);
+  TypeList.insert(Symbols.intern("i8"),     Primitives.Int8,   Symbols);
+  TypeList.insert(Symbols.intern("i16"),    Primitives.Int16,  Symbols);
+  TypeList.insert(Symbols.intern("i32"),    Primitives.Int32,  Symbols);
+  TypeList.insert(Symbols.intern("i64"),    Primitives.Int64,  Symbols);
+  TypeList.insert(Symbols.intern("float"),  Primitives.Float,  Symbols);
+  TypeList.insert(Symbols.intern("double"), Primitives.Double, Symbols);
+  TypeList.insert(Symbols.intern("char"),   Primitives.Char,   Symbols);
+
+  for (auto T : {Primitives.Void, Primitives.Int8, Primitives.Int16,
+                 Primitives.Int32, Primitives.Int64, Primitives.Float,
+                 Primitives.Double})
+    UniqueTypes.try_emplace(T->getIR(), T);
 }
 
-Type *Module::getType(llvm::StringRef Name) const {
-  auto res = TypeList.find(Name);
-  if (res != TypeList.end())
-    return res->second;
+Type *Module::getType(SymbolId Name) const {
+  if (auto Res = TypeList.lookup(Name))
+    return Res;
 
   auto Range = llvm::SMRange(llvm::SMLoc(), llvm::SMLoc());
   SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-      "The type '" + Name + "' is undefined", Range);
+      "The type '" + Symbols.getName(Name) + "' is undefined", Range);
 
-  return nullptr;
+  return Primitives.Int32;
 }
 
-Type *Module::getTypeOrNull(llvm::StringRef Name) const {
-  auto res = TypeList.find(Name);
-  if (res != TypeList.end())
-    return res->second;
-  return nullptr;
+Type *Module::getTypeOrNull(SymbolId Name) const {
+  return TypeList.lookup(Name);
 }
 
-Module::InterfaceDecl *Module::getInterface(llvm::StringRef Name) const {
-  auto res = InterfaceList.find(Name);
-  if (res != InterfaceList.end())
-    return res->second;
+Type *Module::getUniqueType(llvm::Type *IR) {
+  if (!IR)
+    return nullptr;
 
-  auto Range = llvm::SMRange(llvm::SMLoc(), llvm::SMLoc());
+  auto &Entry = UniqueTypes[IR];
+  if (!Entry)
+    Entry = new (Allocator.Allocate<Type>()) Type(IR);
+  return Entry;
+}
+
+Type *Module::getPointerType(Type *Pointee) {
+  return getUniqueType(Pointee->getIR()->getPointerTo(0));
+}
+
+Type *Module::getArrayType(Type *Element, uint64_t Size) {
+  return getUniqueType(llvm::ArrayType::get(Element->getIR(), Size));
+}
+
+Type *Module::getGenericParamType(ast::GenericDecl *Owner, SymbolId Param) {
+  auto &Entry = ParamTypes[{Owner, Param}];
+  if (!Entry)
+    Entry = new (Allocator.Allocate<Type>()) Type(Owner, Param);
+  return Entry;
+}
+
+void Module::registerType(Type *T) {
+  // An alias shares its IR with the aliased type, which keeps the entry.
+  UniqueTypes.try_emplace(T->getIR(), T);
+}
+
+Module::InterfaceDecl *Module::getInterface(SymbolId Name,
+                                            const Position &Pos) const {
+  if (auto Res = InterfaceList.lookup(Name))
+    return Res;
+
+  auto Range = getRange(Pos);
   SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-      "The interface '" + Name + "' is undefined", Range);
+      "The interface '" + Symbols.getName(Name) + "' is undefined", Range);
 
   return nullptr;
 }
 
+NodeArena::~NodeArena() {
+  // The nodes' memory goes away with the allocator, but their members may
+  // still own heap storage.
+  for (auto Node : llvm::reverse(Nodes))
+    Node->~Node();
+}
+
+Module::~Module() = default;
+
+llvm::SMRange Module::getRange(const Position &Pos) const {
+  auto Start = Lines.getBuffer().data() + Pos.Offset;
+  return llvm::SMRange(llvm::SMLoc::getFromPointer(Start),
+                       llvm::SMLoc::getFromPointer(Start + Pos.Length));
+}
+
 ast::FunctionDecl *Module::getFn(ast::CallExpr &Callee, Scope *S) {
   auto Ident = Callee.getIdentifier();
 
   if (Ident->getSize() == 1) {
     // TODO: check named elements
-    auto Found = FunctionList.find(Ident->getPart(0));
-    if (Found == FunctionList.end())
-      return nullptr;
-
-    return Found->second;
+    return FunctionList.lookup(Ident->getSymbol(0));
   }
   return nullptr;
 
@@ -112,9 +160,9 @@ ast::FunctionDecl *Module::getFn(ast::CallExpr &Callee, Scope *S) {
 }
 
 void Module::addType(north::ast::GenericDecl *TypeDecl) {
-  auto Type = new type::Type(TypeDecl, this);
+  auto Type = new (Allocator.Allocate<type::Type>()) type::Type(TypeDecl, this);
   
-  if (!TypeList.try_emplace(TypeDecl->getIdentifier(), Type).second) {
+  if (!TypeList.insert(TypeDecl->getSymbol(), Type, Symbols)) {
     auto Range = llvm::SMRange(llvm::SMLoc(), llvm::SMLoc());
     SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
         "Duplicate definition of type '" + TypeDecl->getIdentifier() + "'", Range);
@@ -122,16 +170,16 @@ void Module::addType(north::ast::GenericDecl *TypeDecl) {
 }
 
 void Module::addInterface(north::ast::InterfaceDecl *Interface) {
-  if (!InterfaceList.try_emplace(Interface->getIdentifier(), Interface).second) {
+  if (!InterfaceList.insert(Interface->getSymbol(), Interface, Symbols)) {
     auto Range = llvm::SMRange(llvm::SMLoc(), llvm::SMLoc());
     SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
         "Duplicate definition of interface '" +  Interface->getIdentifier() + "'", Range);
   }
 }
 
-void Module::addFunction(north::ast::FunctionDecl *Fn) {
+void Module::addFunction(north::ast::FunctionDecl *Fn, bool CreateIR) {
   // TODO: overloading
-  if (!FunctionList.try_emplace(Fn->getIdentifier(), Fn).second) {
+  if (!FunctionList.insert(Fn->getSymbol(), Fn, Symbols)) {
     auto Id = Fn->getIdentifier();
     auto Range = llvm::SMRange(
         llvm::SMLoc::getFromPointer(Id.data()),
@@ -145,35 +193,32 @@ void Module::addFunction(north::ast::FunctionDecl *Fn) {
     return;
   }
 
-  Fn->createIR(this);
+  if (CreateIR)
+    Fn->createIR(this);
 }
 
 void Module::addImport(north::ast::OpenStmt *Import) {
   ImportList.push_back(Import->getModuleName());
+  if (Loader && !Loader->load(*this, *Import))
+    FailedImport = true;
 }
-  
-void Module::checkCall(ast::CallExpr *Callee) {
-  assert(Callee);
-  
-  auto Fn = this->getFn(*Callee, nullptr); // FIXME
-  
-  if (!Fn) {
-    auto Pos = Callee->getPosition();
 
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+void Module::addDeclaration(ast::Node *Decl, bool CreateIR) {
+  AST.push_back(*Decl);
+
+  if (auto Type = dyn_cast<ast::TypeDef>(Decl))
+    addType(Type);
+  else if (auto Interface = dyn_cast<ast::InterfaceDecl>(Decl))
+    addInterface(Interface);
+  else if (auto Fn = dyn_cast<ast::FunctionDecl>(Decl))
+    addFunction(Fn, CreateIR);
+  else if (auto Import = dyn_cast<ast::OpenStmt>(Decl))
+    addImport(Import);
+}
 
-    SourceManager.PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-                               "unknown function referenced", Range);
-  }
-  
-  if (this->hasGenericDeclarations && Fn->hasGenerics()) {
-    static_cast<ast::GenericFunctionDecl *>(Fn)->addCallExpr(Callee);
-    return;
-  }
-  
-  Callee->setCallableFn(Fn, this);
+void Module::addImportedDeclaration(ast::Node *Decl) {
+  ImportedDecls.insert(Decl);
+  addDeclaration(Decl);
 }
 
 } // namespace north::type
@@ -13,30 +13,39 @@
 
 namespace north::type {
 
-void Scope::addElement(north::ast::VarDecl *Var) {
-  if (!Vars.try_emplace(Var->getIdentifier(), Var).second) {
-    auto Pos = Var->getPosition();
-
-    auto Range = llvm::SMRange(
-        llvm::SMLoc::getFromPointer(Pos.Offset),
-        llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
+void Scope::leaveBlock() {
+  assert(!Blocks.empty() && "no block to leave");
+
+  for (auto Size = Blocks.pop_back_val(); Bindings.size() > Size;) {
+    auto &Last = Bindings.back();
+    if (Last.Shadowed == NoBinding)
+      Innermost.erase(Last.Symbol);
+    else
+      Innermost[Last.Symbol] = Last.Shadowed;
+    Bindings.pop_back();
+  }
+}
 
-    Owner->getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-        "duplicate definition of variable '" + Var->getIdentifier() + "'", Range);
+bool Scope::addElement(north::ast::VarDecl *Var) {
+  auto Symbol = Var->getSymbol();
+  auto [It, Inserted] = Innermost.try_emplace(Symbol, Bindings.size());
 
+  auto Shadowed = NoBinding;
+  if (!Inserted) {
+    if (Bindings[It->second].Depth == getDepth())
+      return false;
+    Shadowed = It->second;
+    It->second = Bindings.size();
   }
-}
 
-north::ast::VarDecl *Scope::lookupParentScopes(llvm::StringRef Name) {
-  auto Res = Vars.find(Name);
-  if (Res != Vars.end())
-    return Res->second;
-  return !Parent ? nullptr : Parent->lookup(Name);
+  Bindings.push_back({Symbol, getDepth(), Var, Shadowed});
+  return true;
 }
 
-north::ast::VarDecl *Scope::lookup(llvm::StringRef Name) {
-  if (auto Res = lookupParentScopes(Name))
-    return Res;
+north::ast::VarDecl *Scope::lookup(SymbolId Name) const {
+  auto Res = Innermost.find(Name);
+  if (Res != Innermost.end())
+    return Bindings[Res->second].Var;
   // TODO: global variables
   // if (auto Res = Owner->getGlobalVariable(Name))
   //  return Res;
@@ -8,46 +8,45 @@
 //===----------------------------------------------------------------------===//
 
 #include "Type/Type.h"
-#include "Targets/IRBuilder.h"
+#include "Type/Module.h"
 
 #include <llvm/ADT/StringSwitch.h>
 #include <llvm/ADT/Twine.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DerivedTypes.h>
 #include <llvm/Support/raw_ostream.h>
 
 namespace north::type {
   
-#define PRIMITIVE(P) \
-  new Type(llvm::Type::get ## P ## Ty(targets::IRBuilder::getContext()))
-
-Type *Type::Void   = PRIMITIVE(Void  );
-Type *Type::Int8   = PRIMITIVE(Int8  );
-Type *Type::Int16  = PRIMITIVE(Int16 );
-Type *Type::Int32  = PRIMITIVE(Int32 );
-Type *Type::Int64  = PRIMITIVE(Int64 );
-Type *Type::Float  = PRIMITIVE(Float );
-Type *Type::Double = PRIMITIVE(Double);
-Type *Type::Char   = PRIMITIVE(Int8  );
+#define PRIMITIVE(P) P ## Ty(llvm::Type::get ## P ## Ty(Context))
+
+PrimitiveTypes::PrimitiveTypes(llvm::LLVMContext &Context)
+    : PRIMITIVE(Void  ), PRIMITIVE(Int8  ), PRIMITIVE(Int16 ),
+      PRIMITIVE(Int32 ), PRIMITIVE(Int64 ), PRIMITIVE(Float ),
+      PRIMITIVE(Double) {}
+
+#undef PRIMITIVE
 
 namespace {
 
-llvm::Type *createStructIR(ast::GenericDecl *Decl) {
+llvm::Type *createStructIR(ast::GenericDecl *Decl, Module *M) {
   auto Struct = static_cast<ast::TypeDef *>(Decl)->getTypeDecl();
-  auto IR = llvm::StructType::create(targets::IRBuilder::getContext(),
-                                     Decl->getIdentifier());
+  auto IR = llvm::StructType::create(M->getContext(), Decl->getIdentifier());
   static_cast<ast::StructDecl *>(Struct)->setIR(IR);
   return IR;
 }
 
-llvm::Type *createEnumIR(ast::GenericDecl *Decl) {
+llvm::Type *createEnumIR(ast::GenericDecl *Decl, Module *M) {
   auto Enum = static_cast<ast::EnumDecl *>(Decl);
+  auto Int32 = M->getPrimitives().Int32->getIR();
 
   uint64_t I = 0;
   for (auto Member : Enum->getMemberList()) {
-    Enum->addValue(Member.getTokenInfo().toString(),
-                   llvm::ConstantInt::get(Type::Int32->getIR(), ++I));
+    Enum->addValue(Member.getTokenInfo().Symbol,
+                   llvm::ConstantInt::get(Int32, ++I));
   }
 
-  return Type::Int32->getIR(); // TODO: typed enum
+  return Int32; // TODO: typed enum
 }
 
 llvm::Type *createIR(ast::GenericDecl *Decl, Module *M) {
@@ -62,16 +61,16 @@ llvm::Type *createIR(ast::GenericDecl *Decl, Module *M) {
 
     switch (TypeDef->getTypeDecl()->getKind()) {
     case ast::AST_StructDecl:
-      return createStructIR(TypeDef);
+      return createStructIR(TypeDef, M);
 
     case ast::AST_AliasDecl:
-      Result = M->getType(TypeDef->getTypeDecl()->getIdentifier())->getIR();
+      Result = M->getType(TypeDef->getTypeDecl()->getSymbol())->getIR();
       if (Decl->isPtr())
         Result = Result->getPointerTo(0);
       return Result;
 
     case ast::AST_EnumDecl:
-      return createEnumIR(TypeDef->getTypeDecl());
+      return createEnumIR(TypeDef->getTypeDecl(), M);
 
     default:
       break;
@@ -85,31 +84,17 @@ llvm::Type *createIR(ast::GenericDecl *Decl, Module *M) {
 } // namespace
 
 llvm::Type *Type::getIR() {
+  assert(!isGenericParam() && "Generic parameters have no IR");
   if (!IRType)
-    IRType = createIR(Decl, Mod);
+    setIR(createIR(Decl, Mod));
   return IRType;
 }
   
 void Type::setIR(llvm::Type *T) {
   assert(T && "IR type must not be null");
   IRType = T;
-}
-  
-bool Type::operator==(const Type &RHS) const {
-  bool A = true, B = true;
-  
-  if (this->Decl && RHS.Decl)
-    A = this->Decl->getIdentifier() == RHS.Decl->getIdentifier();
-    
-  // TODO: More precise type checking
-  if (this->IRType && RHS.IRType)
-    B = this->IRType == RHS.IRType;
-  
-  return A && B;
-}
-  
-bool Type::operator!=(const Type &RHS) const {
-  return !(*this == RHS);
+  if (Mod)
+    Mod->registerType(this);
 }
 
 } // namespace north::type
@@ -10,7 +10,6 @@
 #include "Type/TypeInference.h"
 #include "AST/AST.h"
 #include "Type/Module.h"
-#include "Type/Scope.h"
 #include "Type/Type.h"
 #include "Targets/IRBuilder.h"
 #include <llvm/ADT/StringMap.h>
@@ -20,171 +19,417 @@ namespace north::type {
 
 namespace detail {
 
-class NamedValue : public llvm::Value {
-public:
-  explicit NamedValue(llvm::StringRef Name) : Value(nullptr, 0), Name(Name) {}
-
-  llvm::StringRef Name;
-};
+Type *InferenceVisitor::infer(ast::Node &N) {
+  if (auto T = Mod->getInferredType(&N))
+    return T;
 
-class TypedValue : public llvm::Value {
-public:
-  explicit TypedValue(llvm::Type *Type) : Value(nullptr, 1), Type(Type) {}
-  explicit TypedValue(llvm::Value *Val)
-      : Value(nullptr, 1), Type(Val->getType()) {}
+  auto T = N.accept(*this);
+  if (T)
+    Mod->setInferredType(&N, T);
+  return T;
+}
 
-  llvm::Type *Type;
-};
+Type *InferenceVisitor::typeOf(ast::VarDecl *Var) {
+  if (!Symbolic.empty())
+    if (auto T = Symbolic.lookup(Var))
+      return T;
+  return Mod->getUniqueType(Var->getIRType());
+}
 
-llvm::Value *InferenceVisitor::visit(ast::FunctionDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::FunctionDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::GenericFunctionDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::GenericFunctionDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::InterfaceDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::InterfaceDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::VarDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::VarDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::AliasDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::AliasDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::StructDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::StructDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::EnumDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::EnumDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::UnionDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::UnionDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::TupleDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::TupleDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::RangeDecl &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::RangeDecl &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::TypeDef &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::TypeDef &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::UnaryExpr &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::UnaryExpr &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::BinaryExpr &Binary) {
-  return Binary.getRHS()->accept(*this);
+Type *InferenceVisitor::visit(ast::BinaryExpr &Binary) {
+  return infer(*Binary.getRHS());
 }
 
-llvm::Value *InferenceVisitor::visit(ast::LiteralExpr &Literal) {
+Type *InferenceVisitor::visit(ast::LiteralExpr &Literal) {
   auto L = Literal.getTokenInfo();
+  auto &Primitives = Mod->getPrimitives();
   switch (L.Type) {
   case Token::Char:
-    return new TypedValue(Type::Int8->getIR());
+    return Primitives.Int8;
   case Token::Int:
-    return new TypedValue(Type::Int32->getIR());
+    return Primitives.Int32;
   case Token::String:
-    return new TypedValue(llvm::Type::getInt8Ty(targets::IRBuilder::getContext())->getPointerTo(0));
+    return Mod->getPointerType(Primitives.Int8);
   case Token::Nil:
-    return new TypedValue(Type::Int32->getIR());
+    return Primitives.Int32;
   default:
     break;
   }
 
-  if (auto Var = CurrentScope->lookup(L.toString()))
-    return new TypedValue(Var->getIRType());
-  if (auto Type = Mod->getTypeOrNull(L.toString()))
-    return new TypedValue(Type->getIR());
-
-  auto Pos = Literal.getPosition();
-
-  auto Range = llvm::SMRange(
-      llvm::SMLoc::getFromPointer(Pos.Offset),
-      llvm::SMLoc::getFromPointer(Pos.Offset + Pos.Length));
-
-  Mod->getSourceManager().PrintMessage(Range.Start, llvm::SourceMgr::DiagKind::DK_Error,
-      "unknown symbol `" + L.toString() + "`", Range);
-
-  return nullptr;
+  assert(Literal.getVar() && "identifier must be resolved by Sema");
+  return typeOf(Literal.getVar());
 }
 
-llvm::Value *InferenceVisitor::visit(ast::RangeExpr &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::RangeExpr &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::CallExpr &Callee) {
-  return new TypedValue(Mod->getFn(Callee, CurrentScope)
-                            ->getIR()
-                            ->getFunctionType()
-                            ->getReturnType());
+Type *InferenceVisitor::visit(ast::CallExpr &Callee) {
+  return Mod->getUniqueType(Callee.getCallableFn()
+                                ->getIR()
+                                ->getFunctionType()
+                                ->getReturnType());
 }
 
-llvm::Value *InferenceVisitor::visit(ast::ArrayIndexExpr &Idx) {
-  return new TypedValue(Idx.getIdentifier()->accept(*this));
+Type *InferenceVisitor::visit(ast::ArrayIndexExpr &Idx) {
+  auto Array = infer(*Idx.getIdentifier());
+  if (Array && !Array->isGenericParam() && Array->getIR()->isArrayTy())
+    return Mod->getUniqueType(Array->getIR()->getArrayElementType());
+  return Array;
 }
 
-llvm::Value *InferenceVisitor::visit(ast::QualifiedIdentifierExpr &Ident) {
-  auto I = Ident.getPart(0);
-  if (auto Var = CurrentScope->lookup(I))
-    return new TypedValue(Var->getIRType());
-  if (auto Type = Mod->getTypeOrNull(I))
-    return new TypedValue(Type->getIR());
+Type *InferenceVisitor::visit(ast::QualifiedIdentifierExpr &Ident) {
+  if (auto Var = Ident.getVar())
+    return typeOf(Var);
+  if (Ident.getEnum())
+    return Mod->getTypeOrNull(Ident.getSymbol(0));
 
   return nullptr;
 }
 
-llvm::Value *InferenceVisitor::visit(ast::IfExpr &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::IfExpr &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::ForExpr &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::ForExpr &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::WhileExpr &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::WhileExpr &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::AssignExpr &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::AssignExpr &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::StructInitExpr &SI) {
-  return SI.getIdentifier()->accept(*this);
+Type *InferenceVisitor::visit(ast::StructInitExpr &SI) {
+  return SI.getStructType();
 }
 
-llvm::Value *InferenceVisitor::visit(ast::ArrayExpr &Array) {
-  auto ArrTy =
-      type::inferExprType(Array.getValue(0), Mod, CurrentScope)->getIR();
-  return new TypedValue(llvm::ArrayType::get(ArrTy, Array.getCap()));
+Type *InferenceVisitor::visit(ast::ArrayExpr &Array) {
+  auto Element = infer(*Array.getValue(0));
+  if (!Element || Element->isGenericParam())
+    return nullptr;
+  return Mod->getArrayType(Element, Array.getCap());
 }
 
-llvm::Value *InferenceVisitor::visit(ast::OpenStmt &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::OpenStmt &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::BlockStmt &) { return nullptr; }
+Type *InferenceVisitor::visit(ast::BlockStmt &) { return nullptr; }
 
-llvm::Value *InferenceVisitor::visit(ast::ReturnStmt &Return) {
-  return Return.getReturnExpr()->accept(*this);
+Type *InferenceVisitor::visit(ast::ReturnStmt &Return) {
+  return infer(*Return.getReturnExpr());
 }
 
 } // namespace detail
 
-Type *inferFunctionType(ast::FunctionDecl &Fn, Module *Mod, Scope *CurrentScope) {
-  llvm::Value *Type = nullptr;
+Type *inferFunctionType(ast::FunctionDecl &Fn, Module *Mod) {
+  Type *Type = nullptr;
   
-  auto Visitor = detail::InferenceVisitor(Mod, CurrentScope);
+  auto Visitor = detail::InferenceVisitor(Mod);
   auto Body = Fn.getBlockStmt()->getBody();
 
   for (auto I = Body->begin(), E = Body->end(); I != E; ++I) {
     if (auto Return = llvm::dyn_cast<ast::ReturnStmt>(I))
-      Type = I->accept(Visitor);
+      Type = Visitor.infer(*I);
   }
 
-  if (Type->getValueID() == 0) {
-    llvm::outs() << static_cast<detail::NamedValue *>(Type)->Name << '\n';
-    return Mod->getType(static_cast<detail::NamedValue *>(Type)->Name);
-  } else
-    return new type::Type(
-        static_cast<detail::TypedValue *>(Type)->Type); // FIXME
+  return Type;
 }
 
-Type *inferVarType(ast::VarDecl &Var, Module *Mod, Scope *CurrentScope) {
-  auto Visitor = detail::InferenceVisitor(Mod, CurrentScope);
-  auto Type = Var.getValue()->accept(Visitor);
+Type *inferVarType(ast::VarDecl &Var, Module *Mod) {
+  auto Visitor = detail::InferenceVisitor(Mod);
+  return Visitor.infer(*Var.getValue());
+}
+
+Type *inferExprType(ast::Node *Expr, Module *Mod) {
+  auto Visitor = detail::InferenceVisitor(Mod);
+  return Visitor.infer(*Expr);
+}
+
+namespace {
+
+/// Checks a generic body with its parameters standing for themselves. A
+/// value of a parameter type allows only what the parameter's bound
+/// demands: calls to the interface's functions, typed by their signatures.
+class GenericBodyChecker {
+  struct Bound {
+    const ast::GenericDecl::Generic *Param;
+    ast::InterfaceDecl *Interface;
+  };
+
+  ast::GenericFunctionDecl &Fn;
+  Module *Mod;
+  detail::InferenceVisitor Visitor;
+  llvm::DenseMap<Type *, Bound> Bounds;
+  bool Returns = false;
+
+  void report(const Position &Pos, const llvm::Twine &Message) {
+    auto Range = Mod->getRange(Pos);
+    Mod->getSourceManager().PrintMessage(
+        Range.Start, llvm::SourceMgr::DiagKind::DK_Error, Message, Range);
+  }
+
+  Type *typeOf(ast::GenericDecl *TypeDecl) {
+    auto Symbol = TypeDecl->getSymbol();
+    if (Fn.containsGeneric(Symbol) != size_t(-1))
+      return Mod->getGenericParamType(&Fn, Symbol);
+    auto Result = Mod->getType(Symbol);
+    return TypeDecl->isPtr() ? Mod->getPointerType(Result) : Result;
+  }
+
+  /// The type of a demand's argument or result, where the interface's own
+  /// parameter stands for \p Param.
+  Type *substitute(ast::InterfaceDecl *Interface, ast::GenericDecl *TypeDecl,
+                   Type *Param) {
+    if (!TypeDecl)
+      return Mod->getPrimitives().Void;
+    if (Interface->containsGeneric(TypeDecl->getSymbol()) != size_t(-1))
+      return Param;
+    return typeOf(TypeDecl);
+  }
+
+  /// Finds the function \p Name among the demands of \p Interface and of
+  /// the interfaces it extends.
+  std::pair<ast::InterfaceDecl *, ast::FunctionDecl *>
+  findDemand(ast::InterfaceDecl *Interface, SymbolId Name) {
+    while (Interface) {
+      for (auto Required : Interface->getDemands())
+        if (Required->getSymbol() == Name)
+          return {Interface, Required};
+
+      auto Parent = Interface->getParent();
+      Interface = Parent ? Mod->getInterface(Parent->getSymbol(),
+                                             Parent->getPosition())
+                         : nullptr;
+    }
+    return {nullptr, nullptr};
+  }
+
+  const Bound *boundOf(Type *T) {
+    if (!T || !T->isGenericParam())
+      return nullptr;
+    auto Found = Bounds.find(T);
+    return Found == Bounds.end() ? nullptr : &Found->second;
+  }
+
+  /// Reports an operator applied to a value of a parameter type.
+  bool checkOperand(ast::Node &Op, ast::Node &Operand) {
+    auto B = boundOf(Visitor.infer(Operand));
+    if (B)
+      report(Op.getPosition(), "`" + B->Param->BoundName +
+                                   "` provides no operators for `" +
+                                   B->Param->Name + "`");
+    return B;
+  }
+
+  void checkCall(ast::CallExpr &Call) {
+    auto Args = Call.getArgumentList();
+    for (auto Arg : Args)
+      check(*Arg->Arg);
+
+    auto Param = llvm::find_if(Args, [&](auto *Arg) {
+      return boundOf(Visitor.infer(*Arg->Arg));
+    });
+    if (Param == Args.end())
+      return;
+
+    auto ParamType = Visitor.infer(*(*Param)->Arg);
+    auto B = boundOf(ParamType);
+    auto Name = Call.getIdentifier()->getSymbol(0);
+    auto [Interface, Required] = findDemand(B->Interface, Name);
+    if (!Required) {
+      report(Call.getPosition(), "`" + Call.getIdentifier(0) +
+                                     "` isn't demanded by `" + B->Param->BoundName +
+                                     "`, the bound of `" + B->Param->Name + "`");
+      return;
+    }
+
+    bool Matches = Required->countOfArgs() == Args.size();
+    for (size_t I = 0; Matches && I < Args.size(); ++I)
+      Matches = Visitor.infer(*Args[I]->Arg) ==
+                substitute(Interface, Required->getArg(I)->getType(), ParamType);
+    if (!Matches)
+      report(Call.getPosition(), "arguments of `" + Call.getIdentifier(0) +
+                                     "` don't match its demand in `" +
+                                     Interface->getIdentifier() + "`");
+
+    // Typed by the demand rather than by the function the call resolved to.
+    Mod->setInferredType(
+        &Call, substitute(Interface, Required->getTypeDecl(), ParamType));
+  }
+
+  /// Checks the operations within \p Expr, then infers its type.
+  Type *check(ast::Node &Expr) {
+    if (auto Call = llvm::dyn_cast<ast::CallExpr>(&Expr)) {
+      checkCall(*Call);
+    } else if (auto Binary = llvm::dyn_cast<ast::BinaryExpr>(&Expr)) {
+      check(*Binary->getLHS());
+      check(*Binary->getRHS());
+      if (!checkOperand(Expr, *Binary->getLHS()))
+        checkOperand(Expr, *Binary->getRHS());
+    } else if (auto Unary = llvm::dyn_cast<ast::UnaryExpr>(&Expr)) {
+      check(*Unary->getOperand());
+      checkOperand(Expr, *Unary->getOperand());
+    } else if (auto Assign = llvm::dyn_cast<ast::AssignExpr>(&Expr)) {
+      auto Target = check(*Assign->getLHS());
+      auto Value = check(*Assign->getRHS());
+      if (Target && Value && Target != Value)
+        report(Expr.getPosition(),
+               "type of the value doesn't match the assigned variable type");
+    }
+    return Visitor.infer(Expr);
+  }
+
+  void checkVar(ast::VarDecl &Var) {
+    auto Value = Var.getValue() ? check(*Var.getValue()) : nullptr;
+    auto VarType = Var.getType() ? typeOf(Var.getType()) : Value;
 
-  if (Type->getValueID() == 0)
-    return Mod->getType(static_cast<detail::NamedValue *>(Type)->Name);
-  else
-    return new type::Type(
-        static_cast<detail::TypedValue *>(Type)->Type); // FIXME
+    if (Value && Value != VarType)
+      report(Var.getPosition(), "type of value `" + Var.getIdentifier() +
+                                    "` type does't match the variable type");
+
+    Visitor.bind(&Var, VarType);
+  }
+
+  void checkReturn(ast::ReturnStmt &Return) {
+    Returns = true;
+    auto Result = Return.getReturnExpr() ? check(*Return.getReturnExpr())
+                                         : Mod->getPrimitives().Void;
+    if (auto TypeDecl = Fn.getTypeDecl(); TypeDecl && Result != typeOf(TypeDecl))
+      report(TypeDecl->getPosition(), "return value type of `" +
+                                          Fn.getIdentifier() +
+                                          "` does't match the function type");
+  }
+
+  void checkBlock(ast::BlockStmt *Block) {
+    auto Body = Block ? Block->getBody() : nullptr;
+    if (!Body)
+      return;
+
+    for (auto &Stmt : *Body) {
+      if (auto Var = llvm::dyn_cast<ast::VarDecl>(&Stmt)) {
+        checkVar(*Var);
+      } else if (auto Return = llvm::dyn_cast<ast::ReturnStmt>(&Stmt)) {
+        checkReturn(*Return);
+      } else if (auto If = llvm::dyn_cast<ast::IfExpr>(&Stmt)) {
+        for (; If; If = If->getElseBranch()) {
+          if (If->getExpr())
+            check(*If->getExpr());
+          checkBlock(If->getBlock());
+        }
+      } else if (auto For = llvm::dyn_cast<ast::ForExpr>(&Stmt)) {
+        // Loops count with i32, see IRBuilder::visit(ForExpr &).
+        if (auto Iter = For->getIterVar())
+          Visitor.bind(Iter, Mod->getPrimitives().Int32);
+        checkBlock(For->getBlock());
+      } else if (auto While = llvm::dyn_cast<ast::WhileExpr>(&Stmt)) {
+        check(*While->getExpr());
+        checkBlock(While->getBlock());
+      } else {
+        check(Stmt);
+      }
+    }
+  }
+
+public:
+  GenericBodyChecker(ast::GenericFunctionDecl &Fn, Module *Mod)
+      : Fn(Fn), Mod(Mod), Visitor(Mod) {}
+
+  /// Resolves the bounds; false if a parameter is unbounded or its bound
+  /// is undefined.
+  bool bind() {
+    for (auto &Generic : Fn.getGenericsList()) {
+      if (!Generic.isBounded())
+        return false;
+      auto Interface = Mod->getInterface(Generic.Bound, Generic.Pos);
+      if (!Interface)
+        return false;
+      Bounds[Mod->getGenericParamType(&Fn, Generic.Symbol)] = {&Generic,
+                                                               Interface};
+    }
+
+    for (auto Arg : Fn.getArgumentList())
+      if (auto TypeDecl = Arg->getType())
+        Visitor.bind(Arg, typeOf(TypeDecl));
+    return true;
+  }
+
+  void run() {
+    checkBlock(Fn.getBlockStmt());
+
+    if (auto TypeDecl = Fn.getTypeDecl(); TypeDecl && !Returns)
+      report(TypeDecl->getPosition(), "return value type of `" +
+                                          Fn.getIdentifier() +
+                                          "` does't match the function type");
+  }
+};
+
+} // namespace
+
+bool checkGenericFunction(ast::GenericFunctionDecl &Fn, Module *Mod) {
+  GenericBodyChecker Checker(Fn, Mod);
+  if (!Checker.bind())
+    return false;
+
+  // The results depend on the substitution, keep them out of the cache.
+  Mod->enterGenericBody();
+  Checker.run();
+  Mod->leaveGenericBody();
+
+  Fn.setBodyChecked();
+  return true;
 }
 
-Type *inferExprType(ast::Node *Expr, Module *Mod, Scope *CurrentScope) {
-  auto Visitor = detail::InferenceVisitor(Mod, CurrentScope);
-  auto Type = Expr->accept(Visitor);
+bool implementsInterface(Type *T, ast::InterfaceDecl *Interface, Module *Mod) {
+  if (!T || !Interface)
+    return false;
+
+  auto Substitute = [&](ast::GenericDecl *TypeDecl) {
+    if (!TypeDecl)
+      return Mod->getPrimitives().Void->getIR();
+
+    auto Symbol = TypeDecl->getSymbol();
+    auto Result = Interface->containsGeneric(Symbol) != size_t(-1)
+                      ? T->getIR()
+                      : Mod->getType(Symbol)->getIR();
+    return TypeDecl->isPtr() ? Result->getPointerTo(0) : Result;
+  };
+
+  for (auto Required : Interface->getDemands()) {
+    auto Impl = Mod->lookupFunction(Required->getSymbol());
+    if (!Impl || Impl->hasGenerics() ||
+        Impl->countOfArgs() != Required->countOfArgs())
+      return false;
+
+    auto FnType = Impl->getIR()->getFunctionType();
+    if (FnType->getReturnType() != Substitute(Required->getTypeDecl()))
+      return false;
+
+    for (size_t I = 0, E = Required->countOfArgs(); I < E; ++I)
+      if (FnType->getParamType(I) != Substitute(Required->getArg(I)->getType()))
+        return false;
+  }
 
-  if (Type->getValueID() == 0)
-    return Mod->getType(static_cast<detail::NamedValue *>(Type)->Name);
-  else
-    return new type::Type(static_cast<detail::TypedValue *>(Type)->Type); // FIXME
+  if (auto Parent = Interface->getParent())
+    return implementsInterface(
+        T, Mod->getInterface(Parent->getSymbol(), Parent->getPosition()), Mod);
+  return true;
 }
 
 } // namespace north::type
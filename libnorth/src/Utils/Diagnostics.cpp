@@ -0,0 +1,21 @@
+//===--- Utils/Diagnostics.cpp - Deferred diagnostics -----------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Utils/Diagnostics.h"
+
+namespace north::utils {
+
+void DiagnosticBuffer::flush(llvm::SourceMgr &SourceManager) {
+  for (auto &Diag : Entries)
+    SourceManager.PrintMessage(Diag.Range.Start, Diag.Kind, Diag.Message,
+                               Diag.Range);
+  Entries.clear();
+}
+
+} // namespace north::utils
@@ -9,27 +9,46 @@
 
 #include "Utils/FileSystem.h"
 
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
 namespace north::utils {
   
-llvm::SourceMgr *openFile(llvm::StringRef Path) {
+bool openFile(llvm::StringRef Path, llvm::SourceMgr &SourceManager) {
   auto MemBuff = llvm::MemoryBuffer::getFile(Path);
   if (auto Error = MemBuff.getError()) {
     llvm::errs() << Path << ": " << Error.message() << '\n';
-    std::exit(0);
+    return false;
   }
 
-  if (!MemBuff->get()->getBufferSize())
-    std::exit(0);
+  SourceManager.AddNewSourceBuffer(std::move(*MemBuff), llvm::SMLoc());
+  return true;
+}
 
-  auto SourceManager = new llvm::SourceMgr();
-  SourceManager->AddNewSourceBuffer(std::move(*MemBuff), llvm::SMLoc());
+bool writeFileAtomically(llvm::StringRef Path,
+                         llvm::function_ref<bool(llvm::raw_ostream &)> Write) {
+  llvm::SmallString<128> Model(Path);
+  Model += "-%%%%%%%%.tmp";
 
-  SourceManager->setDiagHandler([](const llvm::SMDiagnostic &SMD, void *Context) {
-    SMD.print("", llvm::errs());
-    std::exit(0);
-  });
-  
-  return SourceManager;
+  int FD;
+  llvm::SmallString<128> TempPath;
+  if (llvm::sys::fs::createUniqueFile(Model, FD, TempPath))
+    return false;
+
+  bool Written;
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    Written = Write(OS);
+    OS.close();
+    Written = Written && !OS.has_error();
+    OS.clear_error();
+  }
+
+  if (Written && !llvm::sys::fs::rename(TempPath, Path))
+    return true;
+  llvm::sys::fs::remove(TempPath);
+  return false;
 }
 
 } // north::utils
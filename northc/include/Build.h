@@ -0,0 +1,115 @@
+//===--- Build.h — Build command ---------------------------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NORTHC_BUILD_H
+#define NORTHC_BUILD_H
+
+#include "Commands.h"
+
+#include "Frontend/CompilerInstance.h"
+#include "Serialization/ObjectCache.h"
+#include "Type/Module.h"
+
+#include <llvm/Support/Chrono.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace north {
+
+template <typename VisitorT> void applyVisitor(VisitorT &V, type::Module *M) {
+  for (auto I = M->getAST()->begin(), E = M->getAST()->end(); I != E; ++I)
+    I->accept(V);
+}
+
+/// Parses and resolves the module at \p Path. Returns null if errors were
+/// reported, the module then can't be compiled.
+type::Module *parseModule(CompilerInstance &Instance, llvm::StringRef Path,
+                          bool LazyBodies = false,
+                          llvm::StringRef ASTCacheDir = "",
+                          type::ModuleLoader *Loader = nullptr);
+
+/// What builds set up before compiling anything: the host's target and its
+/// target machines. The driver makes one per build, while `northc serve`
+/// keeps one for all the builds it runs, which may also keep the modules
+/// compiled for the next builds.
+class BuildContext {
+public:
+  /// A compiled module, and what it was compiled from.
+  struct CompiledModule {
+    llvm::sys::TimePoint<> Modified;
+    uint64_t Size = 0;
+    /// Hash of the flags and of the interfaces of the modules it opens.
+    serialization::ObjectCache::Key Key;
+    std::string Interface;
+    std::string Object;
+
+    /// Whether the source of \p Status, whose imports hash to \p ImportsKey,
+    /// still compiles to this module. The size and time of the source stand
+    /// for its contents.
+    bool isUpToDate(const llvm::sys::fs::file_status &Status,
+                    const serialization::ObjectCache::Key &ImportsKey) const {
+      return Key == ImportsKey && Size == Status.getSize() &&
+             Modified == Status.getLastModificationTime();
+    }
+  };
+
+private:
+  std::string TargetTriple;
+  const llvm::Target *Target = nullptr;
+  std::mutex Lock;
+  std::vector<std::unique_ptr<llvm::TargetMachine>> Machines;
+
+public:
+  BuildContext() = default;
+  BuildContext(const BuildContext &) = delete;
+  BuildContext &operator=(const BuildContext &) = delete;
+  virtual ~BuildContext();
+
+  /// Initializes the targets and looks up the host's, unless done already.
+  /// Returns false, having reported why to \p Errs, if there's none.
+  bool initTarget(llvm::raw_ostream &Errs);
+
+  llvm::StringRef getTargetTriple() const { return TargetTriple; }
+
+  /// Creates \p Count target machines ahead of the builds needing them.
+  void reserveTargetMachines(unsigned Count);
+
+  /// A target machine for one module at a time, to be given back once it's
+  /// compiled. Safe to call from any thread.
+  std::unique_ptr<llvm::TargetMachine> takeTargetMachine();
+  void returnTargetMachine(std::unique_ptr<llvm::TargetMachine> TM);
+
+  /// Whether the modules compiled are kept, in which case the build hands
+  /// them to remember().
+  virtual bool keepsModules() const { return false; }
+
+  /// The module last compiled from the source at the absolute \p Path, or
+  /// null.
+  virtual const CompiledModule *lookup(llvm::StringRef /*Path*/) const {
+    return nullptr;
+  }
+
+  /// Keeps \p Module, compiled from the source at the absolute \p Path, for
+  /// the next builds. Called from the build's worker threads.
+  virtual void remember(llvm::StringRef /*Path*/,
+                        CompiledModule /*Module*/) {}
+};
+
+/// Builds and links the modules of \p Command. Returns false on failure.
+bool build(const BuildCommand &Command, BuildContext &Context);
+
+} // namespace north
+
+#endif // NORTHC_BUILD_H
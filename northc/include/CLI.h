@@ -27,6 +27,7 @@ public:
   BuildCommand getBuildFlags();
   DumpASTCommand getDumpASTFlags();
   EmitIRCommand getEmitIRFlags();
+  ServeCommand getServeFlags();
 
   void printHelp(Command For = Command::Help);
   void error();
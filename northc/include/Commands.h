@@ -12,6 +12,8 @@
 
 #include <llvm/ADT/StringRef.h>
 
+#include <vector>
+
 namespace north {
 
 enum class Command {
@@ -19,24 +21,50 @@ enum class Command {
   Build,
   DumpAST,
   EmitIR,
+  Serve,
 };
 
+/// Socket of `northc serve`, in the directory it's started from, unless
+/// told otherwise.
+constexpr const char *DefaultServerSocket = ".northc.sock";
+
 enum class BuildType { Debug, Release };
 enum class CompilationTarget { LLVM, C };
 
 struct BuildCommand {
   BuildType Build = BuildType::Debug;
   CompilationTarget Target = CompilationTarget::LLVM;
-  llvm::StringRef Input;
+  bool FoldInstances = false;
+  bool LazyBodies = false;
+  bool CacheStats = false;
+  /// Modules compiled at once, 0 for one per hardware thread.
+  unsigned Jobs = 0;
+  std::vector<llvm::StringRef> Inputs;
+  /// Where opened modules are looked for after the opener's directory.
+  std::vector<llvm::StringRef> SearchPath;
   llvm::StringRef Output;
+  llvm::StringRef ASTCacheDir;
+  llvm::StringRef InterfaceDir;
+  llvm::StringRef ObjectCacheDir;
+  /// Socket of the server to build with, if any.
+  llvm::StringRef Server;
 };
 
 struct DumpASTCommand {
+  bool Binary = false;
   llvm::StringRef Input;
+  llvm::StringRef ASTCacheDir;
 };
 
 struct EmitIRCommand {
+  bool LazyBodies = false;
   llvm::StringRef Input;
+  llvm::StringRef ASTCacheDir;
+  llvm::StringRef InterfaceDir;
+};
+
+struct ServeCommand {
+  llvm::StringRef Socket = DefaultServerSocket;
 };
 
 } // namespace north
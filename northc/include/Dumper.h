@@ -10,15 +10,21 @@
 #ifndef NORTHC_AST_DUMPER_H
 #define NORTHC_AST_DUMPER_H
 
-#include "AST/Visitor.h"
+#include "AST/ASTVisitor.h"
+#include "Grammar/LineTable.h"
 
 #include <llvm/Support/raw_ostream.h>
 
 namespace north::ast {
 
-class Dumper : public Visitor {
+class Dumper : public ASTVisitor<Dumper> {
 public:
-  AST_WALKER_METHODS
+  /// Node positions are printed as lines and columns of \p Lines. The dump
+  /// goes to \p OS.
+  explicit Dumper(const LineTable &Lines,
+                  llvm::raw_ostream &OS = llvm::outs());
+
+  AST_WALKER_METHODS(void)
 };
 
 } // namespace north::ast
@@ -18,9 +18,26 @@
 namespace north {
 
 void configureOpimizations(llvm::TargetMachine *TM,
-                           north::type::Module *Module,
+                           llvm::Module *Module,
                            const north::BuildCommand &Command,
-                           llvm::raw_fd_ostream &dest);
+                           llvm::raw_pwrite_stream &dest);
+
+/// Makes the instances of generic functions private to \p Module, so that
+/// foldInstances() replaces a duplicate outright instead of leaving a thunk
+/// behind.
+void internalizeInstances(north::type::Module &Module);
+
+/// Folds functions whose IR is identical into one body, which is what the
+/// instances of a generic function often lower to. Pointer types compare
+/// equal there, so every pointer-typed instance shares a single body.
+void foldInstances(north::type::Module &Module);
+
+/// Size of the .text sections \p Module compiles to with \p Command's
+/// settings. Works on a copy, \p Module itself is left untouched. Fails if
+/// no object file could be emitted.
+llvm::Expected<uint64_t> getTextSize(llvm::TargetMachine *TM,
+                                     const llvm::Module &Module,
+                                     const north::BuildCommand &Command);
 
 } // namespace north 
 
@@ -0,0 +1,53 @@
+//===--- Server.h — Compile server -------------------------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// `northc serve` sets the targets up once, and builds for `northc build
+// --server` clients on a Unix socket. A client passes its working directory,
+// its arguments and its standard output and error, and gets the exit status
+// of the build back.
+//
+// Each build runs in a process forked from the server, so that a fatal
+// diagnostic or a crash only ends that build. The build reports the modules
+// it compiled to the server, which hands them to the next builds: a module
+// whose source has the same size and modification time, and whose imports
+// export the same, isn't compiled again. Builds are run one at a time, a
+// client waits for those requested before its own.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NORTHC_SERVER_H
+#define NORTHC_SERVER_H
+
+#include "Build.h"
+#include "Commands.h"
+
+#include <llvm/ADT/StringMap.h>
+
+namespace north {
+
+/// Serves builds until killed. Returns the exit status if it can't start.
+int serve(const ServeCommand &Command);
+
+/// Has the server on \p Socket run `northc` with the arguments in \p Args,
+/// and returns its exit status.
+int requestBuild(llvm::StringRef Socket, int Count, const char *Args[]);
+
+/// The record a build sends the server for \p Module, compiled from the
+/// source at \p Path.
+std::string encodeModule(llvm::StringRef Path,
+                         const BuildContext::CompiledModule &Module);
+
+/// Adds the modules of the records in \p Data to \p Modules, up to the first
+/// incomplete or damaged one.
+void decodeModules(llvm::StringRef Data,
+                   llvm::StringMap<BuildContext::CompiledModule> &Modules);
+
+} // namespace north
+
+#endif // NORTHC_SERVER_H
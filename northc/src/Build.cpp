@@ -0,0 +1,466 @@
+//===--- Build.cpp — Build command -------------------------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Build.h"
+#include "Opt.h"
+
+#include "Frontend/ImportGraph.h"
+#include "Grammar/Parser.h"
+#include "Sema/Sema.h"
+#include "Serialization/ASTCache.h"
+#include "Serialization/ASTFile.h"
+#include "Serialization/InterfaceFile.h"
+#include "Serialization/InterfaceLoader.h"
+#include "Targets/CBuilder.h"
+#include "Targets/IRBuilder.h"
+#include "Utils/FileSystem.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/TargetRegistry.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetOptions.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace north {
+
+type::Module *parseModule(CompilerInstance &Instance, llvm::StringRef Path,
+                          bool LazyBodies, llvm::StringRef ASTCacheDir,
+                          type::ModuleLoader *Loader) {
+  if (!utils::openFile(Path, Instance.getSourceManager()))
+    return nullptr;
+  Lexer Lexer(Instance.getSourceManager());
+
+  auto Module = &Instance.createModule(Path);
+
+  // Opened modules are loaded as their `open` statements are met.
+  Module->setLoader(Loader);
+
+  // A lazily parsed AST lacks the bodies found unreachable, so it is neither
+  // taken from nor put in the cache.
+  if (ASTCacheDir.empty() || LazyBodies) {
+    Parser(Lexer, Module, LazyBodies).parse();
+  } else {
+    serialization::ASTCache Cache(ASTCacheDir);
+    if (!Cache.load(*Module)) {
+      Parser(Lexer, Module).parse();
+      if (!Instance.getErrorCount())
+        Cache.store(*Module);
+    }
+  }
+  // What the failed imports declare would only be reported missing. Not
+  // all that Sema checks goes through what resolve() returns.
+  bool Resolved = !Instance.getErrorCount() && !Module->hasFailedImport() &&
+                  sema::Sema(Module).resolve() && !Instance.getErrorCount();
+  Module->setLoader(nullptr);
+
+  return Resolved ? Module : nullptr;
+}
+
+void storeInterface(llvm::StringRef Name, llvm::StringRef Interface,
+                    const BuildCommand &Command, llvm::raw_ostream &Errs) {
+  if (!Command.InterfaceDir.empty() &&
+      !serialization::InterfaceLoader::store(Name, Interface,
+                                             Command.InterfaceDir))
+    Errs << Name << ": couldn't write the interface to "
+         << Command.InterfaceDir << '\n';
+}
+
+/// Returns false if the module exports what it can't, which was reported.
+/// Failing to write the interface only warns.
+bool storeInterface(type::Module &Module, const BuildCommand &Command,
+                    llvm::raw_ostream &Errs) {
+  if (Command.InterfaceDir.empty())
+    return true;
+
+  std::string Interface;
+  llvm::raw_string_ostream OS(Interface);
+  if (!serialization::writeInterface(Module, OS))
+    return false;
+  OS.flush();
+
+  storeInterface(llvm::sys::path::stem(Module.getModuleIdentifier()),
+                 Interface, Command, Errs);
+  return true;
+}
+
+// FIXME
+constexpr const char *CPU = "generic", *Features = "";
+
+/// Describes the target and the flags for the object cache and the modules a
+/// server keeps, which must tell apart the builds producing different
+/// objects. The interfaces found in the interface directory rather than built
+/// are part of it, since modules may open them.
+std::string getCacheOptions(llvm::StringRef TargetTriple,
+                            const BuildCommand &Command,
+                            const ImportGraph &Graph) {
+  std::string Options;
+  llvm::raw_string_ostream OS(Options);
+  OS << TargetTriple << ' ' << CPU << ' ' << Features << ' '
+     << (Command.Build == BuildType::Release ? "release" : "debug");
+  if (Command.FoldInstances)
+    OS << " fold-instances";
+  if (Command.LazyBodies)
+    OS << " lazy-bodies";
+
+  if (Command.InterfaceDir.empty())
+    return OS.str();
+
+  std::error_code EC;
+  std::vector<std::string> Precompiled;
+  for (llvm::sys::fs::directory_iterator I(Command.InterfaceDir, EC), E;
+       I != E && !EC; I.increment(EC)) {
+    auto Path = I->path();
+    if (llvm::sys::path::extension(Path) ==
+            serialization::InterfaceFileExtension &&
+        Graph.lookup(llvm::sys::path::stem(Path)) < 0)
+      Precompiled.push_back(Path);
+  }
+  std::sort(Precompiled.begin(), Precompiled.end());
+
+  for (auto &Path : Precompiled)
+    if (auto Buffer = llvm::MemoryBuffer::getFile(Path))
+      OS << ' ' << llvm::sys::path::filename(Path) << ':'
+         << llvm::toHex(serialization::hashSource((*Buffer)->getBuffer()));
+  return OS.str();
+}
+
+/// Lowers \p Module down to an object file in the working directory, and
+/// returns the file's path, or an empty string on failure. Meant to run on a
+/// worker thread, so what it prints goes to \p Out and \p Errs rather than
+/// to the shared streams. \p Jobs threads may emit the instances of its
+/// generic functions. Errors reported to \p Instance while lowering stop it
+/// before the object is written.
+std::string emitObject(llvm::TargetMachine *TM, CompilerInstance &Instance,
+                       type::Module *Module, const BuildCommand &Command,
+                       llvm::raw_ostream &Out, llvm::raw_ostream &Errs,
+                       unsigned Jobs) {
+  targets::IRBuilder IR(Module);
+  if (!IR.instantiateGenerics(Jobs)) {
+    Errs << Module->getModuleIdentifier()
+         << ": couldn't link the instances of generic functions\n";
+    return "";
+  }
+  if (Instance.getErrorCount())
+    return "";
+  applyVisitor(IR, Module);
+  if (Instance.getErrorCount())
+    return "";
+
+  verifyModule(*Module, &Out);
+
+  Module->setTargetTriple(TM->getTargetTriple().str());
+  Module->setDataLayout(TM->createDataLayout());
+
+  std::string Filename = Module->getModuleIdentifier() + ".o";
+  std::error_code EC;
+  llvm::raw_fd_ostream dest(Filename, EC, llvm::sys::fs::F_None);
+
+  if (EC) {
+    Errs << "couldn't open file: " << EC.message() << '\n';
+    return "";
+  }
+
+  if (Command.FoldInstances) {
+    // Both sides are measured with internal instances, so that the figure
+    // is down to the folding alone.
+    internalizeInstances(*Module);
+    auto Before = getTextSize(TM, *Module, Command);
+    foldInstances(*Module);
+    auto After = getTextSize(TM, *Module, Command);
+
+    if (Before && After) {
+      Out << Module->getModuleIdentifier() << ": folded instances: "
+          << int64_t(*Before - *After) << " bytes of .text saved\n";
+    } else {
+      auto Err = llvm::joinErrors(Before.takeError(), After.takeError());
+      Errs << Module->getModuleIdentifier()
+           << ": couldn't measure folded instances: "
+           << llvm::toString(std::move(Err)) << '\n';
+    }
+  }
+
+  configureOpimizations(TM, Module, Command, dest);
+
+  dest.flush();
+  return Filename;
+}
+
+BuildContext::~BuildContext() = default;
+
+bool BuildContext::initTarget(llvm::raw_ostream &Errs) {
+  if (Target)
+    return true;
+
+  llvm::InitializeAllTargetInfos();
+  llvm::InitializeAllTargets();
+  llvm::InitializeAllTargetMCs();
+  llvm::InitializeAllAsmParsers();
+  llvm::InitializeAllAsmPrinters();
+
+  TargetTriple = llvm::sys::getDefaultTargetTriple();
+  std::string Error;
+  Target = llvm::TargetRegistry::lookupTarget(TargetTriple, Error);
+
+  if (!Target) {
+    Errs << Error;
+    return false;
+  }
+  return true;
+}
+
+void BuildContext::reserveTargetMachines(unsigned Count) {
+  std::vector<std::unique_ptr<llvm::TargetMachine>> Created;
+  for (unsigned I = 0; I < Count; ++I)
+    Created.push_back(takeTargetMachine());
+  for (auto &TM : Created)
+    returnTargetMachine(std::move(TM));
+}
+
+std::unique_ptr<llvm::TargetMachine> BuildContext::takeTargetMachine() {
+  {
+    std::lock_guard<std::mutex> Guard(Lock);
+    if (!Machines.empty()) {
+      auto TM = std::move(Machines.back());
+      Machines.pop_back();
+      return TM;
+    }
+  }
+
+  llvm::TargetOptions opt;
+  auto RM = llvm::Optional<llvm::Reloc::Model>();
+  return std::unique_ptr<llvm::TargetMachine>(
+      Target->createTargetMachine(TargetTriple, CPU, Features, opt, RM));
+}
+
+void BuildContext::returnTargetMachine(
+    std::unique_ptr<llvm::TargetMachine> TM) {
+  std::lock_guard<std::mutex> Guard(Lock);
+  Machines.push_back(std::move(TM));
+}
+
+bool build(const BuildCommand &Command, BuildContext &Context) {
+  if (Command.Target == CompilationTarget::C) {
+    // The C builder prints to the standard output, one module after another.
+    for (auto Input : Command.Inputs) {
+      CompilerInstance Instance;
+      serialization::InterfaceLoader Loader(Command.InterfaceDir);
+      auto *Module = parseModule(
+          Instance, Input, Command.LazyBodies, Command.ASTCacheDir,
+          Command.InterfaceDir.empty() ? nullptr : &Loader);
+      if (!Module)
+        return false;
+      if (!storeInterface(*Module, Command, llvm::errs()))
+        return false;
+
+      targets::CBuilder CBuilder(Module);
+      applyVisitor(CBuilder, Module);
+    }
+    return true;
+  }
+
+  std::vector<std::string> SearchPath(Command.SearchPath.begin(),
+                                      Command.SearchPath.end());
+  ImportGraph Graph(std::move(SearchPath), Command.InterfaceDir);
+
+  bool Resolved = true;
+  for (auto Input : Command.Inputs)
+    Resolved &= Graph.addInput(Input);
+  if (!Resolved || !Graph.checkCycles() || !Context.initTarget(llvm::errs()))
+    return false;
+
+  // A module is parsed once the interfaces of those it opens are written, and
+  // is kept until lowered, unless its object was cached or kept by the
+  // context. What it prints is held back until it's done, so that outputs
+  // don't interleave.
+  struct Unit {
+    std::unique_ptr<CompilerInstance> Instance;
+    type::Module *Module = nullptr;
+    serialization::ObjectCache::Key Key;
+    bool Cached = false;
+    /// For the context keeping the modules.
+    std::string Path;
+    llvm::sys::fs::file_status Status;
+    serialization::ObjectCache::Key ImportsKey;
+    bool Kept = false;
+    std::string Interface;
+    std::string Object;
+    std::string Out, Errs;
+  };
+
+  std::vector<Unit> Units(Graph.size());
+  std::mutex OutputLock;
+  std::atomic<unsigned> Kept(0);
+
+  std::unique_ptr<serialization::ObjectCache> Cache;
+  if (!Command.ObjectCacheDir.empty())
+    Cache = std::make_unique<serialization::ObjectCache>(Command.ObjectCacheDir);
+
+  std::string CacheOptions;
+  if (Cache || Context.keepsModules())
+    CacheOptions = getCacheOptions(Context.getTargetTriple(), Command, Graph);
+
+  // Opened modules bring in the modules they open in turn, all of which
+  // were exported before the module opening them.
+  auto GetImports = [&](unsigned Id) {
+    std::vector<serialization::ObjectCache::Import> Imports;
+    std::vector<unsigned> Worklist(Graph.getModules()[Id].Imports);
+    std::vector<bool> Added(Graph.size());
+    while (!Worklist.empty()) {
+      auto Import = Worklist.back();
+      Worklist.pop_back();
+      if (Added[Import])
+        continue;
+      Added[Import] = true;
+
+      auto &Imported = Graph.getModules()[Import];
+      Imports.emplace_back(Imported.Name, Units[Import].Interface);
+      Worklist.insert(Worklist.end(), Imported.Imports.begin(),
+                      Imported.Imports.end());
+    }
+    return Imports;
+  };
+
+  auto Export = [&](unsigned Id) {
+    auto &Source = Graph.getModules()[Id];
+    auto &Unit = Units[Id];
+
+    serialization::InterfaceLoader Loader(Command.InterfaceDir);
+    auto Imports = GetImports(Id);
+    for (auto &[Name, Interface] : Imports)
+      Loader.addInterface(Name, Interface);
+
+    llvm::raw_string_ostream ErrsOS(Unit.Errs);
+
+    // An unchanged source, whose imports export the same, compiles to what
+    // the context kept. Its contents are then never read.
+    llvm::SmallString<128> Path(Source.Path);
+    if (Context.keepsModules() && !llvm::sys::fs::make_absolute(Path) &&
+        !llvm::sys::fs::status(Path, Unit.Status)) {
+      Unit.Path = std::string(Path.str());
+      Unit.ImportsKey =
+          serialization::ObjectCache::getKey(CacheOptions, "", Imports);
+
+      auto Known = Context.lookup(Unit.Path);
+      if (Known && Known->isUpToDate(Unit.Status, Unit.ImportsKey)) {
+        auto Object = Source.Name + ".o";
+        bool Written = utils::writeFileAtomically(
+            Object, [&](llvm::raw_ostream &OS) {
+              OS << Known->Object;
+              return true;
+            });
+        if (Written) {
+          Unit.Object = Object;
+          Unit.Interface = Known->Interface;
+          Unit.Cached = Unit.Kept = true;
+          ++Kept;
+          storeInterface(Source.Name, Unit.Interface, Command, ErrsOS);
+          return true;
+        }
+      }
+    }
+
+    auto Buffer = llvm::MemoryBuffer::getFile(Source.Path);
+    if (Cache && Buffer) {
+      Unit.Key = serialization::ObjectCache::getKey(
+          CacheOptions, (*Buffer)->getBuffer(), Imports);
+      auto Object = Source.Name + ".o";
+      if (Cache->load(Unit.Key, Object, Unit.Interface)) {
+        Unit.Object = Object;
+        Unit.Cached = true;
+        storeInterface(Source.Name, Unit.Interface, Command, ErrsOS);
+        return true;
+      }
+    }
+
+    Unit.Instance = std::make_unique<CompilerInstance>();
+    Unit.Module = parseModule(*Unit.Instance, Source.Path, Command.LazyBodies,
+                              Command.ASTCacheDir, &Loader);
+    if (!Unit.Module)
+      return false;
+
+    llvm::raw_string_ostream InterfaceOS(Unit.Interface);
+    if (!serialization::writeInterface(*Unit.Module, InterfaceOS))
+      return false;
+    InterfaceOS.flush();
+
+    storeInterface(Source.Name, Unit.Interface, Command, ErrsOS);
+    return true;
+  };
+
+  unsigned Jobs = Command.Jobs ? Command.Jobs
+                               : std::max(1u, std::thread::hardware_concurrency());
+  // The modules are compiled side by side already, what threads are left
+  // over go to the instances of their generic functions. Linking those
+  // back costs about what emitting them does, so only when asked for.
+  unsigned InstanceJobs =
+      Command.Jobs ? std::max<size_t>(1, Jobs / Graph.size()) : 1;
+
+  auto Complete = [&](unsigned Id) {
+    auto &Unit = Units[Id];
+    llvm::raw_string_ostream OutOS(Unit.Out), ErrsOS(Unit.Errs);
+    if (!Unit.Cached) {
+      auto TM = Context.takeTargetMachine();
+      Unit.Object = emitObject(TM.get(), *Unit.Instance, Unit.Module, Command,
+                               OutOS, ErrsOS, InstanceJobs);
+      Context.returnTargetMachine(std::move(TM));
+      Unit.Instance.reset();
+      if (Cache && !Unit.Object.empty())
+        Cache->store(Unit.Key, Unit.Object, Unit.Interface);
+    }
+
+    if (!Unit.Kept && !Unit.Path.empty() && !Unit.Object.empty()) {
+      if (auto Object = llvm::MemoryBuffer::getFile(Unit.Object))
+        Context.remember(Unit.Path, {Unit.Status.getLastModificationTime(),
+                                     Unit.Status.getSize(), Unit.ImportsKey,
+                                     Unit.Interface,
+                                     std::string((*Object)->getBuffer())});
+    }
+
+    std::lock_guard<std::mutex> Lock(OutputLock);
+    llvm::outs() << OutOS.str();
+    llvm::errs() << ErrsOS.str();
+    return !Unit.Object.empty();
+  };
+
+  bool Compiled = Graph.compile(Jobs, Export, Complete);
+
+  if (Cache && Command.CacheStats)
+    llvm::outs() << "object cache: " << Cache->getHits() << " hits, "
+                 << Cache->getMisses() << " misses\n";
+  if (Context.keepsModules() && Command.CacheStats)
+    llvm::outs() << "server: " << Kept << " of " << Graph.size()
+                 << " modules unchanged\n";
+
+  if (!Compiled)
+    return false;
+
+  // FIXME
+  auto Output = Command.Output.empty()
+                    ? llvm::sys::path::stem(Command.Inputs.front())
+                    : Command.Output;
+  std::string Cmd = "gcc";
+  for (auto &Unit : Units) {
+    llvm::outs() << Unit.Object << '\n';
+    Cmd += " " + Unit.Object;
+  }
+  llvm::outs() << Output << '\n';
+  Cmd += " -o " + Output.str();
+  return !system(Cmd.c_str());
+}
+
+} // namespace north
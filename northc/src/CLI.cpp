@@ -23,6 +23,8 @@ Command CLI::getCommand() {
     return Command::DumpAST;
   if (strcmp(Args[1], "emit-ir") == 0)
     return Command::EmitIR;
+  if (strcmp(Args[1], "serve") == 0)
+    return Command::Serve;
 
   error();
 }
@@ -34,11 +36,14 @@ BuildCommand CLI::getBuildFlags() {
   }
 
   BuildCommand Command;
-  Command.Input = Args[2];
-
-  uint8_t Current = 3;
+  int Current = 2;
 
   while (Current < Count) {
+    if (Args[Current][0] != '-') {
+      Command.Inputs.push_back(Args[Current++]);
+      continue;
+    }
+
     if (strncmp(Args[Current], "--target", 8) == 0) {
       if (strncmp((Args[Current] + 8), "=llvm", 5) == 0)
         Command.Target = CompilationTarget::LLVM;
@@ -50,6 +55,42 @@ BuildCommand CLI::getBuildFlags() {
     
     if (strncmp(Args[Current], "--release", 8) == 0)
       Command.Build = BuildType::Release;
+
+    if (strcmp(Args[Current], "--fold-instances") == 0)
+      Command.FoldInstances = true;
+
+    if (strcmp(Args[Current], "--lazy-bodies") == 0)
+      Command.LazyBodies = true;
+
+    if (strncmp(Args[Current], "--ast-cache=", 12) == 0)
+      Command.ASTCacheDir = Args[Current] + 12;
+
+    if (strncmp(Args[Current], "--interface-dir=", 16) == 0)
+      Command.InterfaceDir = Args[Current] + 16;
+
+    if (strncmp(Args[Current], "--object-cache=", 15) == 0)
+      Command.ObjectCacheDir = Args[Current] + 15;
+
+    if (strcmp(Args[Current], "--cache-stats") == 0)
+      Command.CacheStats = true;
+
+    if (strcmp(Args[Current], "--server") == 0)
+      Command.Server = DefaultServerSocket;
+    else if (strncmp(Args[Current], "--server=", 9) == 0)
+      Command.Server = Args[Current] + 9;
+
+    if (strncmp(Args[Current], "-I", 2) == 0) {
+      auto Dir = Args[Current][2] ? Args[Current] + 2 : Args[++Current];
+      if (!Dir)
+        error();
+      Command.SearchPath.push_back(Dir);
+    }
+
+    if (strncmp(Args[Current], "-j", 2) == 0) {
+      auto Jobs = Args[Current][2] ? Args[Current] + 2 : Args[++Current];
+      if (!Jobs || llvm::StringRef(Jobs).getAsInteger(10, Command.Jobs))
+        error();
+    }
     
     if (strncmp(Args[Current], "-o", 2) == 0 || strncmp(Args[Current], "--output", 8) == 0)
       Command.Output = Args[++Current];
@@ -57,18 +98,59 @@ BuildCommand CLI::getBuildFlags() {
     ++Current;
   }
 
+  if (Command.Inputs.empty())
+    error();
+
   return Command;
 }
 
 DumpASTCommand CLI::getDumpASTFlags() {
+  if (Count < 3 || strcmp(Args[2], "help") == 0) {
+    printHelp(Command::DumpAST);
+    exit(0);
+  }
+
   DumpASTCommand Command;
   Command.Input = Args[2];
+
+  for (int Current = 3; Current < Count; ++Current) {
+    if (strcmp(Args[Current], "--binary") == 0)
+      Command.Binary = true;
+    if (strncmp(Args[Current], "--ast-cache=", 12) == 0)
+      Command.ASTCacheDir = Args[Current] + 12;
+  }
+
   return Command;
 }
 
 EmitIRCommand CLI::getEmitIRFlags() {
   EmitIRCommand Command;
   Command.Input = Args[2];
+
+  for (int Current = 3; Current < Count; ++Current) {
+    if (strcmp(Args[Current], "--lazy-bodies") == 0)
+      Command.LazyBodies = true;
+    if (strncmp(Args[Current], "--ast-cache=", 12) == 0)
+      Command.ASTCacheDir = Args[Current] + 12;
+    if (strncmp(Args[Current], "--interface-dir=", 16) == 0)
+      Command.InterfaceDir = Args[Current] + 16;
+  }
+
+  return Command;
+}
+
+ServeCommand CLI::getServeFlags() {
+  ServeCommand Command;
+
+  for (int Current = 2; Current < Count; ++Current) {
+    if (strcmp(Args[Current], "help") == 0) {
+      printHelp(Command::Serve);
+      exit(0);
+    }
+    if (strncmp(Args[Current], "--socket=", 9) == 0)
+      Command.Socket = Args[Current] + 9;
+  }
+
   return Command;
 }
 
@@ -81,18 +163,68 @@ COMMAND:
   build
   dump-ast
   emit-ir
+  serve
   help
 )";
     break;
 
   case Command::Build:
     llvm::outs() << R"(
-Usage: northc build file [options]
+Usage: northc build file... [options]
 OPTIONS:
+  -o, --output
+              - name of the linked executable
+  -I DIR      - look for the modules opened in DIR, after the
+                directory of the module opening them
+  -j N        - compile N modules at once, one per hardware thread
+                by default; given, the threads left over emit the
+                instances of generic functions
   --target    — compilation target
     =llvm
     =c
   --release   - release build
+  --fold-instances
+              - share one body between identical generic instances
+                and report the .text bytes saved
+  --lazy-bodies
+              - parse only the bodies reachable from exported
+                functions (ones not starting with `_`)
+  --ast-cache=DIR
+              - reuse the ASTs of unchanged sources, kept in DIR
+  --interface-dir=DIR
+              - load the opened modules which have no source from
+                their interfaces in DIR, and write the interfaces of
+                the modules built there
+  --object-cache=DIR
+              - reuse the objects of modules whose source, imports
+                and flags are unchanged, kept in DIR
+  --cache-stats
+              - report the hits and misses of the object cache, and
+                the modules a server reused
+  --server[=SOCKET]
+              - have the `northc serve` listening on SOCKET build,
+                .northc.sock by default
+)";
+    break;
+
+  case Command::Serve:
+    llvm::outs() << R"(
+Usage: northc serve [options]
+Builds for `northc build --server` clients, keeping the targets set up
+and the modules compiled from one build to the next.
+OPTIONS:
+  --socket=SOCKET
+              - listen on SOCKET, .northc.sock by default
+)";
+    break;
+
+  case Command::DumpAST:
+    llvm::outs() << R"(
+Usage: northc dump-ast file [options]
+OPTIONS:
+  --binary    - check that the binary AST reads back to the same dump
+  --ast-cache=DIR
+              - reuse the ASTs of unchanged sources, kept in DIR
 )";
     break;
     
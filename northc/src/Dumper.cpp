@@ -16,6 +16,10 @@
 
 namespace {
 
+/// Where the dump goes, see Dumper::Dumper().
+llvm::raw_ostream *Stream = &llvm::outs();
+llvm::raw_ostream &out() { return *Stream; }
+
 class Tabulator {
   static unsigned Tab;
 
@@ -35,6 +39,7 @@ using namespace llvm;
 using namespace north::ast;
 
 class NodePrinter {
+  static const north::LineTable *Lines;
   static int Tab;
   bool In;
   static bool Out;
@@ -52,11 +57,11 @@ public:
     if (OnlyData)
       return;
 
-    outs().changeColor(raw_ostream::MAGENTA, true);
-    outs() << NodeName;
-    outs().resetColor() << ": ";
+    out().changeColor(raw_ostream::MAGENTA, true);
+    out() << NodeName;
+    out().resetColor() << ": ";
     printPos(Node.getPosition());
-    outs().resetColor() << " {" << (In ? "\n" : " ");
+    out().resetColor() << " {" << (In ? "\n" : " ");
   }
 
   explicit NodePrinter(StringRef NodeName, bool InIndent = true) {
@@ -69,9 +74,9 @@ public:
     if (OnlyData)
       return;
 
-    outs().changeColor(raw_ostream::YELLOW, true);
-    outs() << NodeName;
-    outs().resetColor() << ": {" << (In ? "\n" : " ");
+    out().changeColor(raw_ostream::YELLOW, true);
+    out() << NodeName;
+    out().resetColor() << ": {" << (In ? "\n" : " ");
   }
 
   ~NodePrinter() {
@@ -83,7 +88,7 @@ public:
     }
     if (In)
       indent();
-    outs() << (!In ? " }\n" : "}\n");
+    out() << (!In ? " }\n" : "}\n");
   }
 
   void offOutIndent() { Out = false; }
@@ -91,28 +96,33 @@ public:
 
   void printOnlyData() { OnlyData = true; }
 
-  void indent() { outs().indent(Tab * 2); }
+  static void setLineTable(const north::LineTable &Table) { Lines = &Table; }
+
+  void indent() { out().indent(Tab * 2); }
 
   raw_ostream &printField(const char *Name) {
     if (In)
       indent();
-    outs().changeColor(raw_ostream::YELLOW, true) << Name;
-    outs().resetColor() << ": ";
-    return outs();
+    out().changeColor(raw_ostream::YELLOW, true) << Name;
+    out().resetColor() << ": ";
+    return out();
   }
 
   void printGenericList(GenericDecl &Decl) {
     NodePrinter Node("Generics");
     for (auto &Generic : Decl.getGenericsList()) {
       indent();
-      outs() << Generic.Name << ' ';
+      out() << Generic.Name;
+      if (Generic.isBounded())
+        out() << ": " << Generic.BoundName;
+      out() << ' ';
       printPos(Generic.Pos) << ",\n";
     }
   }
 
   void printArgumentList(FunctionDecl &Func) {
     NodePrinter Node("Arguments");
-    Dumper Dump;
+    Dumper Dump(*Lines, out());
 
     for (auto Arg : Func.getArgumentList()) {
       Node.indent();
@@ -128,28 +138,30 @@ public:
     NodePrinter Node("Arguments");
 
     for (auto Arg : Func.getArgumentList()) {
-      Dumper Dump;
+      Dumper Dump(*Lines, out());
       Arg->Arg->accept(Dump);
     }
   }
 
   raw_ostream &printPos(const north::Position &Pos) {
-    outs().resetColor() << '(';
-    outs().changeColor(raw_ostream::RED) << Pos.Line;
-    outs().resetColor() << ':';
-    outs().changeColor(raw_ostream::RED) << Pos.Column;
-    outs().resetColor() << ", ";
-    outs().changeColor(raw_ostream::RED) << Pos.Length;
-    outs().resetColor() << ')';
-    return outs();
+    auto Loc = Lines->getLineAndColumn(Pos.Offset);
+    out().resetColor() << '(';
+    out().changeColor(raw_ostream::RED) << Loc.Line;
+    out().resetColor() << ':';
+    out().changeColor(raw_ostream::RED) << Loc.Column;
+    out().resetColor() << ", ";
+    out().changeColor(raw_ostream::RED) << Pos.Length;
+    out().resetColor() << ')';
+    return out();
   }
 
   raw_ostream &printIdentifier(const StringRef Identifier) {
-    outs().changeColor(raw_ostream::CYAN) << Identifier;
-    return outs().resetColor();
+    out().changeColor(raw_ostream::CYAN) << Identifier;
+    return out().resetColor();
   }
 };
 
+const north::LineTable *NodePrinter::Lines = nullptr;
 int NodePrinter::Tab = 0;
 bool NodePrinter::Out = true;
 bool NodePrinter::OnlyData = false;
@@ -158,7 +170,12 @@ bool NodePrinter::OnlyData = false;
 
 namespace north::ast {
 
-Value *Dumper::visit(FunctionDecl &Func) {
+Dumper::Dumper(const LineTable &Lines, raw_ostream &OS) {
+  NodePrinter::setLineTable(Lines);
+  Stream = &OS;
+}
+
+void Dumper::visit(FunctionDecl &Func) {
   NodePrinter Node("FunctionDecl", Func);
 
   Node.printField("Name");
@@ -178,15 +195,12 @@ Value *Dumper::visit(FunctionDecl &Func) {
 
   if (auto Block = Func.getBlockStmt())
     visit(*Block);
-
-  return nullptr;
 }
   
-Value *Dumper::visit(ast::GenericFunctionDecl &Fn) {
-  return nullptr;
+void Dumper::visit(ast::GenericFunctionDecl &Fn) {
 }
 
-Value *Dumper::visit(InterfaceDecl &Interface) {
+void Dumper::visit(InterfaceDecl &Interface) {
   NodePrinter Node("InterfaceDecl", Interface);
 
   Node.printField("Name") << Interface.getIdentifier() << '\n';
@@ -201,11 +215,9 @@ Value *Dumper::visit(InterfaceDecl &Interface) {
   for (const auto &Signature : Interface.getDemands()) {
     Signature->accept(*this);
   }
-
-  return nullptr;
 }
 
-Value *Dumper::visit(VarDecl &Var) {
+void Dumper::visit(VarDecl &Var) {
   NodePrinter Node("VarDecl", Var);
 
   Node.printField("Name") << Var.getIdentifier() << ",\n";
@@ -221,76 +233,62 @@ Value *Dumper::visit(VarDecl &Var) {
     Node.offOutIndent();
     Value->accept(*this);
   }
-
-  return nullptr;
 }
 
-Value *Dumper::visit(AliasDecl &Alias) {
+void Dumper::visit(AliasDecl &Alias) {
   NodePrinter Node("AliasDecl", Alias, Alias.hasGenerics());
 
   if (Alias.hasGenerics())
     Node.printField("Name");
   Node.printIdentifier(Alias.getIdentifier());
   if (Alias.hasGenerics()) {
-    outs() << '\n';
+    out() << '\n';
     Node.indent();
     Node.printGenericList(Alias);
   }
-
-  return nullptr;
 }
 
-Value *Dumper::visit(StructDecl &Struct) {
+void Dumper::visit(StructDecl &Struct) {
   NodePrinter Node("StructDecl", Struct);
 
   for (const auto &Field : Struct.getFieldList())
     Field->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(EnumDecl &Enum) {
+void Dumper::visit(EnumDecl &Enum) {
   NodePrinter Node("EnumDecl", Enum);
 
   Node.indent();
   for (const auto &Member : Enum.getMemberList())
     Node.printIdentifier(tokenView(Member.getTokenInfo())) << ", ";
-  outs() << '\n';
+  out() << '\n';
 
   if (Enum.hasGenerics())
     Node.printGenericList(Enum);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(UnionDecl &Union) {
+void Dumper::visit(UnionDecl &Union) {
   NodePrinter Node("UnionDecl", Union);
 
   for (auto Member : Union.getFieldList())
     Member->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(TupleDecl &Tuple) {
+void Dumper::visit(TupleDecl &Tuple) {
   NodePrinter Node("TupleDecl", Tuple);
 
   for (auto Member : Tuple.getMemberList())
     Member->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(RangeDecl &Ranges) {
+void Dumper::visit(RangeDecl &Ranges) {
   NodePrinter Node("RangeDecl", Ranges);
 
   for (auto Range : Ranges.getRangeList())
     Range->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(TypeDef &Def) {
+void Dumper::visit(TypeDef &Def) {
   NodePrinter Node("TypeDef", Def);
   Node.printField("Identifier");
 
@@ -299,21 +297,17 @@ Value *Dumper::visit(TypeDef &Def) {
     Node.printGenericList(Def);
 
   Def.getTypeDecl()->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(UnaryExpr &Unary) {
+void Dumper::visit(UnaryExpr &Unary) {
   NodePrinter Node("UnaryExpr", Unary);
 
   Node.indent();
   Node.printIdentifier(tokenToString(Unary.getOperator())) << '\n';
   Unary.getOperand()->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(BinaryExpr &Binary) {
+void Dumper::visit(BinaryExpr &Binary) {
   NodePrinter Node("BinaryExpr", Binary);
 
   Node.indent();
@@ -321,28 +315,22 @@ Value *Dumper::visit(BinaryExpr &Binary) {
   Node.onOutIndent();
   Binary.getLHS()->accept(*this);
   Binary.getRHS()->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(LiteralExpr &Literal) {
+void Dumper::visit(LiteralExpr &Literal) {
   NodePrinter Node("LiteralExpr", Literal, false);
   Node.printIdentifier(Literal.getTokenInfo().toString());
-
-  return nullptr;
 }
 
-Value *Dumper::visit(RangeExpr &Range) {
+void Dumper::visit(RangeExpr &Range) {
   NodePrinter Node("RangeExpr", Range, false);
 
   Node.printField("From") << Range.getBeginValue()->getTokenInfo().toString()
                           << ", ";
   Node.printField("To") << Range.getEndValue()->getTokenInfo().toString();
-
-  return nullptr;
 }
 
-Value *Dumper::visit(CallExpr &Callee) {
+void Dumper::visit(CallExpr &Callee) {
   NodePrinter Node("CallExpr", Callee);
 
   Node.printField("Name");
@@ -351,38 +339,34 @@ Value *Dumper::visit(CallExpr &Callee) {
 
   if (Callee.hasArgs())
     Node.printArgumentList(Callee);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(ArrayIndexExpr &Index) {
+void Dumper::visit(ArrayIndexExpr &Index) {
   NodePrinter Node("ArrayIndexExpr", Index);
   Node.printField("Identifier");
   Node.printOnlyData();
   Index.getIdentifier()->accept(*this);
-  llvm::outs() << "\n";
+  out() << "\n";
   Node.printField("Index");
   Node.offOutIndent();
   Index.getIdxExpr()->accept(*this);
-  return nullptr;
 }
 
-Value *Dumper::visit(QualifiedIdentifierExpr &Ident) {
+void Dumper::visit(QualifiedIdentifierExpr &Ident) {
   NodePrinter Node("QualifiedIdentifierExpr", Ident, false);
 
   auto Identifier = Ident.getIdentifier();
   int I = 0, E = Identifier.size();
   for (auto PartOfIdent : Identifier) {
-    outs().changeColor(raw_ostream::CYAN) << PartOfIdent.toString();
+    out().changeColor(raw_ostream::CYAN) << PartOfIdent.toString();
     if (++I != E)
-      outs().resetColor() << '.';
+      out().resetColor() << '.';
   }
 
-  outs().resetColor();
-  return nullptr;
+  out().resetColor();
 }
 
-Value *Dumper::visit(IfExpr &If) {
+void Dumper::visit(IfExpr &If) {
   NodePrinter Node("IfExpr", If);
   Node.offOutIndent();
 
@@ -403,11 +387,9 @@ Value *Dumper::visit(IfExpr &If) {
     Node.offOutIndent();
     ElseBranch->accept(*this);
   }
-
-  return nullptr;
 }
 
-Value *Dumper::visit(ForExpr &For) {
+void Dumper::visit(ForExpr &For) {
   NodePrinter Node("ForExpr", For);
 
   Node.printField("Iter");
@@ -418,22 +400,18 @@ Value *Dumper::visit(ForExpr &For) {
   Node.offOutIndent();
   For.getRange()->accept(*this);
   For.getBlock()->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(WhileExpr &While) {
+void Dumper::visit(WhileExpr &While) {
   NodePrinter Node("WhileExpr", While);
 
   Node.printField("Expr");
   Node.offOutIndent();
   While.getExpr()->accept(*this);
   While.getBlock()->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(AssignExpr &Assign) {
+void Dumper::visit(AssignExpr &Assign) {
   NodePrinter Node("AssignExpr", Assign);
 
   Node.indent();
@@ -442,41 +420,33 @@ Value *Dumper::visit(AssignExpr &Assign) {
     LHS->accept(*this);
   if (auto RHS = Assign.getRHS())
     RHS->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(ast::StructInitExpr &Struct) {
+void Dumper::visit(ast::StructInitExpr &Struct) {
   NodePrinter Node("StructInitExpr", Struct);
   Node.onOutIndent();
 
   for (auto FieldVal : Struct.getValues())
     FieldVal->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(ast::ArrayExpr &Array) {
+void Dumper::visit(ast::ArrayExpr &Array) {
   NodePrinter Node("ArrayExpr", Array);
   Node.indent();
 
   for (auto Val : Array.getValues())
     Val->accept(*this);
-
-  return nullptr;
 }
 
-Value *Dumper::visit(OpenStmt &Stmt) {
+void Dumper::visit(OpenStmt &Stmt) {
   NodePrinter Node("OpenStmt", Stmt);
 
   Node.printField("Module");
   Node.printIdentifier(Stmt.getModuleName());
-  outs() << '\n';
-
-  return nullptr;
+  out() << '\n';
 }
 
-Value *Dumper::visit(BlockStmt &Block) {
+void Dumper::visit(BlockStmt &Block) {
   NodePrinter Node("BlockStmt", Block);
 
   if (auto Body = Block.getBody()) {
@@ -485,17 +455,13 @@ Value *Dumper::visit(BlockStmt &Block) {
       CurrentLine->accept(*this);
     }
   }
-
-  return nullptr;
 }
 
-Value *Dumper::visit(ReturnStmt &Stmt) {
+void Dumper::visit(ReturnStmt &Stmt) {
   NodePrinter Node("ReturnStmt", Stmt);
 
   if (auto Expr = Stmt.getReturnExpr())
     Expr->accept(*this);
-
-  return nullptr;
 }
 
 } // namespace north::ast
@@ -7,109 +7,41 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "Build.h"
 #include "CLI.h"
 #include "Dumper.h"
-#include "Opt.h"
+#include "Server.h"
 
-#include "Grammar/Parser.h"
-#include "Targets/CBuilder.h"
+#include "Frontend/CompilerInstance.h"
+#include "Sema/Sema.h"
+#include "Serialization/ASTFile.h"
+#include "Serialization/InterfaceLoader.h"
 #include "Targets/IRBuilder.h"
-#include "Utils/FileSystem.h"
 
-#include <llvm/Target/TargetOptions.h>
 #include <llvm/IR/Verifier.h>
-#include <llvm/IR/LegacyPassManager.h>
-#include <llvm/IR/PassManager.h>
-#include <llvm/Support/TargetRegistry.h>
-#include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/Casting.h>
 #include <llvm/Support/Format.h>
 
 namespace north {
 
-void applyVisitor(ast::Visitor &V, type::Module *M) {
-  for (auto I = M->getAST()->begin(), E = M->getAST()->end(); I != E; ++I)
-    I->accept(V);
-}
-
-type::Module *parseModule(llvm::StringRef Path) {
-  auto SrcMgr = utils::openFile(Path);
-  Lexer Lexer(*SrcMgr);
-
-  auto Module = new type::Module(
-      Path, targets::IRBuilder::getContext(), *SrcMgr);
-  Parser(Lexer, Module).parse();
-
-  return Module;
-}
-
-void build(const BuildCommand &Command) {
-  auto *Module = parseModule(Command.Input);
-
-  if (Command.Target == CompilationTarget::C) {
-    targets::CBuilder CBuilder(Module);
-    applyVisitor(CBuilder, Module);
-  } else {
-    targets::IRBuilder IR(Module);
-    applyVisitor(IR, Module);
-
-    verifyModule(*Module, &llvm::outs());
-
-    llvm::InitializeAllTargetInfos();
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmParsers();
-    llvm::InitializeAllAsmPrinters();
-
-    auto TargetTriple = llvm::sys::getDefaultTargetTriple();
-    Module->setTargetTriple(TargetTriple);
-
-    std::string Error;
-    auto Target = llvm::TargetRegistry::lookupTarget(TargetTriple, Error);
-
-    if (!Target) {
-      llvm::errs() << Error;
-      return;
-    }
-
-    // FIXME
-    auto CPU = "generic", Features = "";
-
-    llvm::TargetOptions opt;
-    auto RM = llvm::Optional<llvm::Reloc::Model>();
-    auto TM = Target->createTargetMachine(TargetTriple, CPU, Features, opt, RM);
-
-    Module->setDataLayout(TM->createDataLayout());
-
-    std::string Filename = Module->getModuleIdentifier() + ".o";
-    std::error_code EC;
-    llvm::raw_fd_ostream dest(Filename, EC, llvm::sys::fs::F_None);
-
-    if (EC) {
-      llvm::errs() << "couldn't open file: " << EC.message();
-      return;
-    }
-
-    configureOpimizations(TM, Module, Command, dest);
-
-    dest.flush();
-
-    // FIXME
-    auto Output = Command.Output.empty()
-                      ? llvm::StringRef(Module->getModuleIdentifier())
-                      : Command.Output;
-    llvm::outs() << Filename << '\n' << Output << '\n';
-    auto Cmd = "gcc " + Filename + " -o " + Output;
-    system(Cmd.str().c_str());
-  }
-}
-
 // TODO: Emit IR after optimizations
 void emitIR(const EmitIRCommand &Command) {
-  auto *Module = parseModule(Command.Input);
+  CompilerInstance Instance;
+  serialization::InterfaceLoader Loader(Command.InterfaceDir);
+  auto *Module =
+      parseModule(Instance, Command.Input, Command.LazyBodies,
+                  Command.ASTCacheDir,
+                  Command.InterfaceDir.empty() ? nullptr : &Loader);
+  if (!Module)
+    exit(1);
 
   targets::IRBuilder IRBuilder(Module);
+  IRBuilder.instantiateGenerics();
+  if (Instance.getErrorCount())
+    exit(1);
   applyVisitor(IRBuilder, Module);
+  if (Instance.getErrorCount())
+    exit(1);
 
   verifyModule(*Module, &llvm::outs());
 
@@ -117,8 +49,51 @@ void emitIR(const EmitIRCommand &Command) {
 }
 
 void dumpAST(const DumpASTCommand &Command) {
-  ast::Dumper Dumper;
-  applyVisitor(Dumper, parseModule(Command.Input));
+  CompilerInstance Instance;
+  auto *Module =
+      parseModule(Instance, Command.Input, false, Command.ASTCacheDir);
+  if (!Module)
+    exit(1);
+
+  if (!Command.Binary) {
+    ast::Dumper Dumper(Module->getLineTable());
+    applyVisitor(Dumper, Module);
+    return;
+  }
+
+  // Reads the binary AST back into a second module, and compares the dumps.
+  std::string Binary;
+  llvm::raw_string_ostream BinaryOS(Binary);
+  bool Written = serialization::writeAST(*Module, BinaryOS);
+  BinaryOS.flush();
+
+  auto Loaded = &Instance.createModule(Command.Input);
+  if (!Written || !serialization::readAST(Binary, *Loaded)) {
+    llvm::errs() << Command.Input << ": binary AST can't be read back\n";
+    exit(1);
+  }
+  if (!sema::Sema(Loaded).resolve())
+    exit(1);
+
+  auto Dump = [](type::Module *M) {
+    std::string Result;
+    llvm::raw_string_ostream OS(Result);
+    ast::Dumper Dumper(M->getLineTable(), OS);
+    applyVisitor(Dumper, M);
+    return OS.str();
+  };
+
+  auto Expected = Dump(Module);
+  if (Dump(Loaded) != Expected) {
+    llvm::errs() << Command.Input << ": binary AST differs from the source\n";
+    exit(1);
+  }
+
+  ast::Dumper Dumper(Loaded->getLineTable());
+  applyVisitor(Dumper, Loaded);
+  llvm::outs() << "binary AST: " << Binary.size() << " bytes, "
+               << Module->getLineTable().getBuffer().size()
+               << " bytes of source\n";
 }
 
 } // namespace north
@@ -127,9 +102,17 @@ int main(int argc, const char *argv[]) {
   north::CLI CLI(argc, argv);
 
   switch (CLI.getCommand()) {
-  case north::Command::Build:
-    build(CLI.getBuildFlags());
-    break;
+  case north::Command::Build: {
+    auto Command = CLI.getBuildFlags();
+    if (!Command.Server.empty())
+      return north::requestBuild(Command.Server, argc, argv);
+
+    north::BuildContext Context;
+    return north::build(Command, Context) ? 0 : 1;
+  }
+
+  case north::Command::Serve:
+    return north::serve(CLI.getServeFlags());
 
   case north::Command::EmitIR:
     emitIR(CLI.getEmitIRFlags());
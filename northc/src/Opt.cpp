@@ -17,6 +17,7 @@
 #include <llvm/Analysis/TargetTransformInfo.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/PassManager.h>
+#include <llvm/Object/ObjectFile.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Host.h>
 #include <llvm/Support/TargetRegistry.h>
@@ -28,14 +29,15 @@
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 #include <llvm/Transforms/Scalar.h>
 #include <llvm/Transforms/Scalar/GVN.h>
+#include <llvm/Transforms/Utils/Cloning.h>
 #include <llvm/Transforms/Utils/Mem2Reg.h>
 
 namespace north {
 
 void configureOpimizations(llvm::TargetMachine *TM,
-                           north::type::Module *Module,
+                           llvm::Module *Module,
                            const north::BuildCommand &Command,
-                           llvm::raw_fd_ostream &dest) {
+                           llvm::raw_pwrite_stream &dest) {
   
   llvm::legacy::PassManager PM;
   
@@ -112,4 +114,44 @@ void configureOpimizations(llvm::TargetMachine *TM,
   PM.run(*Module);
 }
 
+void internalizeInstances(north::type::Module &Module) {
+  for (auto &Node : *Module.getAST()) {
+    if (auto Generic = llvm::dyn_cast<ast::GenericFunctionDecl>(&Node)) {
+      for (auto &Instance : Generic->getInstantiatedFunctions()) {
+        auto IR = Instance.Fn->getIR();
+        IR->setLinkage(llvm::GlobalValue::InternalLinkage);
+        IR->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+      }
+    }
+  }
+}
+
+void foldInstances(north::type::Module &Module) {
+  llvm::legacy::PassManager PM;
+  PM.add(llvm::createMergeFunctionsPass());
+  PM.run(Module);
+}
+
+llvm::Expected<uint64_t> getTextSize(llvm::TargetMachine *TM,
+                                     const llvm::Module &Module,
+                                     const north::BuildCommand &Command) {
+  auto Copy = llvm::CloneModule(Module);
+
+  llvm::SmallVector<char, 0> Buffer;
+  llvm::raw_svector_ostream Stream(Buffer);
+  configureOpimizations(TM, Copy.get(), Command, Stream);
+
+  auto Object = llvm::object::ObjectFile::createObjectFile(
+      llvm::MemoryBufferRef(llvm::StringRef(Buffer.data(), Buffer.size()),
+                            Module.getModuleIdentifier()));
+  if (!Object)
+    return Object.takeError();
+
+  uint64_t Size = 0;
+  for (auto &Section : (*Object)->sections())
+    if (Section.isText())
+      Size += Section.getSize();
+  return Size;
+}
+
 } // namespace north
@@ -0,0 +1,469 @@
+//===--- Server.cpp — Compile server -----------------------------*- C++ -*-===//
+//
+//                       The North Compiler Infrastructure
+//
+//                This file is distributed under the MIT License.
+//                        See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Server.h"
+#include "Build.h"
+#include "CLI.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace north {
+
+namespace {
+
+bool writeAll(int FD, llvm::StringRef Data) {
+  while (!Data.empty()) {
+    auto Written = ::write(FD, Data.data(), Data.size());
+    if (Written < 0 && errno == EINTR)
+      continue;
+    if (Written < 0)
+      return false;
+    Data = Data.drop_front(Written);
+  }
+  return true;
+}
+
+bool readAll(int FD, char *Data, size_t Size) {
+  while (Size) {
+    auto Read = ::read(FD, Data, Size);
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read <= 0)
+      return false;
+    Data += Read;
+    Size -= Read;
+  }
+  return true;
+}
+
+bool getAddress(llvm::StringRef Socket, sockaddr_un &Address) {
+  Address = {};
+  Address.sun_family = AF_UNIX;
+  if (Socket.size() >= sizeof(Address.sun_path)) {
+    llvm::errs() << "northc: socket path is too long: " << Socket << '\n';
+    return false;
+  }
+  std::memcpy(Address.sun_path, Socket.data(), Socket.size());
+  return true;
+}
+
+// A request is the size of what follows, sent along with the client's
+// standard output and error, then its working directory and its arguments,
+// each ended by a NUL.
+
+constexpr uint32_t MaxRequestSize = 1 << 24;
+
+/// Seconds a client has to send its request. Builds are served one after
+/// another, so a client sending nothing mustn't hold up those after it.
+constexpr time_t RequestTimeout = 10;
+
+bool sendRequest(int Server, llvm::StringRef Request) {
+  uint32_t Size = Request.size();
+  iovec IO{&Size, sizeof(Size)};
+
+  int Streams[2] = {STDOUT_FILENO, STDERR_FILENO};
+  alignas(cmsghdr) char Control[CMSG_SPACE(sizeof(Streams))] = {};
+
+  msghdr Message{};
+  Message.msg_iov = &IO;
+  Message.msg_iovlen = 1;
+  Message.msg_control = Control;
+  Message.msg_controllen = sizeof(Control);
+
+  auto Header = CMSG_FIRSTHDR(&Message);
+  Header->cmsg_level = SOL_SOCKET;
+  Header->cmsg_type = SCM_RIGHTS;
+  Header->cmsg_len = CMSG_LEN(sizeof(Streams));
+  std::memcpy(CMSG_DATA(Header), Streams, sizeof(Streams));
+
+  return ::sendmsg(Server, &Message, 0) == sizeof(Size) &&
+         writeAll(Server, Request);
+}
+
+/// Closes the descriptors passed along with \p Message.
+void closeDescriptors(msghdr &Message) {
+  for (auto Header = CMSG_FIRSTHDR(&Message); Header;
+       Header = CMSG_NXTHDR(&Message, Header)) {
+    if (Header->cmsg_level != SOL_SOCKET || Header->cmsg_type != SCM_RIGHTS)
+      continue;
+    auto Count = (Header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    for (size_t I = 0; I < Count; ++I) {
+      int FD;
+      std::memcpy(&FD, CMSG_DATA(Header) + I * sizeof(int), sizeof(FD));
+      ::close(FD);
+    }
+  }
+}
+
+bool receiveRequest(int Client, int (&Streams)[2], std::string &Request) {
+  uint32_t Size;
+  iovec IO{&Size, sizeof(Size)};
+  alignas(cmsghdr) char Control[CMSG_SPACE(sizeof(Streams))];
+
+  msghdr Message{};
+  Message.msg_iov = &IO;
+  Message.msg_iovlen = 1;
+  Message.msg_control = Control;
+  Message.msg_controllen = sizeof(Control);
+
+  auto Received = ::recvmsg(Client, &Message, 0);
+  if (Received < 0)
+    return false;
+
+  // Whatever descriptors came with a malformed request are closed.
+  auto Header = CMSG_FIRSTHDR(&Message);
+  if (Received != sizeof(Size) || (Message.msg_flags & MSG_CTRUNC) ||
+      !Header || Header->cmsg_level != SOL_SOCKET ||
+      Header->cmsg_type != SCM_RIGHTS ||
+      Header->cmsg_len != CMSG_LEN(sizeof(Streams))) {
+    closeDescriptors(Message);
+    return false;
+  }
+  std::memcpy(Streams, CMSG_DATA(Header), sizeof(Streams));
+
+  // The size is checked before anything is allocated for it.
+  if (Size && Size <= MaxRequestSize) {
+    Request.resize(Size);
+    if (readAll(Client, &Request[0], Size) && Request.back() == '\0')
+      return true;
+  }
+
+  ::close(Streams[0]);
+  ::close(Streams[1]);
+  return false;
+}
+
+// Builds send the modules they compile as records of fields one after
+// another: the numbers as they are in memory, the strings after their size.
+
+void writeField(std::string &Record, uint64_t Value) {
+  Record.append(reinterpret_cast<const char *>(&Value), sizeof(Value));
+}
+
+void writeField(std::string &Record, llvm::StringRef Value) {
+  writeField(Record, uint64_t(Value.size()));
+  Record.append(Value.begin(), Value.end());
+}
+
+class RecordReader {
+  llvm::StringRef Data;
+  bool Failed = false;
+
+public:
+  explicit RecordReader(llvm::StringRef Data) : Data(Data) {}
+
+  bool atEnd() const { return Data.empty() || Failed; }
+  bool failed() const { return Failed; }
+
+  uint64_t readNumber() {
+    uint64_t Value = 0;
+    if (Data.size() < sizeof(Value)) {
+      Failed = true;
+      return 0;
+    }
+    std::memcpy(&Value, Data.data(), sizeof(Value));
+    Data = Data.drop_front(sizeof(Value));
+    return Value;
+  }
+
+  llvm::StringRef readString() {
+    auto Size = readNumber();
+    if (Failed || Data.size() < Size) {
+      Failed = true;
+      return "";
+    }
+    auto Value = Data.take_front(Size);
+    Data = Data.drop_front(Size);
+    return Value;
+  }
+};
+
+/// The context of the server, and of the builds it forks. Builds see the
+/// modules kept until they were forked, and send those they compile back.
+class ServerContext : public BuildContext {
+  llvm::StringMap<CompiledModule> Modules;
+  /// In a build, the pipe to the server.
+  int UpdatesFD = -1;
+  std::mutex UpdatesLock;
+
+public:
+  bool keepsModules() const override { return true; }
+
+  const CompiledModule *lookup(llvm::StringRef Path) const override {
+    auto Known = Modules.find(Path);
+    return Known == Modules.end() ? nullptr : &Known->second;
+  }
+
+  void remember(llvm::StringRef Path, CompiledModule Module) override {
+    auto Record = encodeModule(Path, Module);
+    std::lock_guard<std::mutex> Guard(UpdatesLock);
+    writeAll(UpdatesFD, Record);
+  }
+
+  /// Runs the build \p Client requests in a process of its own, and sends it
+  /// the exit status.
+  void serveClient(int Client, int Listener);
+
+private:
+  [[noreturn]] void runBuild(std::string &Request);
+  void readUpdates(int FD);
+};
+
+void ServerContext::serveClient(int Client, int Listener) {
+  int Streams[2];
+  std::string Request;
+  if (!receiveRequest(Client, Streams, Request))
+    return;
+
+  // The pipe is closed on exec, so that the linker a build runs doesn't keep
+  // it open.
+  int Updates[2];
+  if (::pipe(Updates)) {
+    ::close(Streams[0]);
+    ::close(Streams[1]);
+    return;
+  }
+  ::fcntl(Updates[0], F_SETFD, FD_CLOEXEC);
+  ::fcntl(Updates[1], F_SETFD, FD_CLOEXEC);
+
+  llvm::outs().flush();
+  llvm::errs().flush();
+
+  auto Build = ::fork();
+  if (!Build) {
+    ::close(Listener);
+    ::close(Client);
+    ::close(Updates[0]);
+    ::dup2(Streams[0], STDOUT_FILENO);
+    ::dup2(Streams[1], STDERR_FILENO);
+    ::close(Streams[0]);
+    ::close(Streams[1]);
+    UpdatesFD = Updates[1];
+    runBuild(Request);
+  }
+
+  ::close(Updates[1]);
+  ::close(Streams[0]);
+  ::close(Streams[1]);
+
+  char Result = 1;
+  if (Build > 0) {
+    readUpdates(Updates[0]);
+
+    int Status = 0;
+    while (::waitpid(Build, &Status, 0) < 0 && errno == EINTR)
+      ;
+    if (WIFEXITED(Status))
+      Result = WEXITSTATUS(Status);
+  }
+  ::close(Updates[0]);
+
+  writeAll(Client, llvm::StringRef(&Result, 1));
+}
+
+void ServerContext::runBuild(std::string &Request) {
+  std::vector<const char *> Args;
+  for (size_t I = 0; I < Request.size(); I = Request.find('\0', I) + 1)
+    Args.push_back(Request.data() + I);
+
+  if (Args.size() < 3 || ::chdir(Args[0])) {
+    llvm::errs() << "northc: the server can't build in " << Args[0] << '\n';
+    std::exit(1);
+  }
+
+  CLI CLI(Args.size() - 1, Args.data() + 1);
+  if (CLI.getCommand() != Command::Build) {
+    llvm::errs() << "northc: the server only builds\n";
+    std::exit(1);
+  }
+
+  bool Built = build(CLI.getBuildFlags(), *this);
+  llvm::outs().flush();
+  llvm::errs().flush();
+  std::exit(Built ? 0 : 1);
+}
+
+void ServerContext::readUpdates(int FD) {
+  std::string Data;
+  char Buffer[1 << 16];
+  while (true) {
+    auto Read = ::read(FD, Buffer, sizeof(Buffer));
+    if (Read < 0 && errno == EINTR)
+      continue;
+    if (Read <= 0)
+      break;
+    Data.append(Buffer, Read);
+  }
+
+  // A build ended by a diagnostic may have left its last record incomplete.
+  decodeModules(Data, Modules);
+}
+
+} // namespace
+
+std::string encodeModule(llvm::StringRef Path,
+                         const BuildContext::CompiledModule &Module) {
+  std::string Record;
+  writeField(Record, Path);
+  writeField(Record, uint64_t(Module.Modified.time_since_epoch().count()));
+  writeField(Record, Module.Size);
+  writeField(Record,
+             llvm::StringRef(reinterpret_cast<const char *>(Module.Key.data()),
+                             Module.Key.size()));
+  writeField(Record, Module.Interface);
+  writeField(Record, Module.Object);
+  return Record;
+}
+
+void decodeModules(llvm::StringRef Data,
+                   llvm::StringMap<BuildContext::CompiledModule> &Modules) {
+  RecordReader Reader(Data);
+  while (!Reader.atEnd()) {
+    auto Path = Reader.readString();
+    BuildContext::CompiledModule Module;
+    Module.Modified =
+        llvm::sys::TimePoint<>(std::chrono::nanoseconds(Reader.readNumber()));
+    Module.Size = Reader.readNumber();
+    auto Key = Reader.readString();
+    Module.Interface = std::string(Reader.readString());
+    Module.Object = std::string(Reader.readString());
+    if (Reader.failed() || Key.size() != Module.Key.size())
+      break;
+
+    std::memcpy(Module.Key.data(), Key.data(), Key.size());
+    Modules[Path] = std::move(Module);
+  }
+}
+
+int serve(const ServeCommand &Command) {
+  sockaddr_un Address;
+  if (!getAddress(Command.Socket, Address))
+    return 1;
+
+  auto Connect = [&](int FD) {
+    return !::connect(FD, reinterpret_cast<sockaddr *>(&Address),
+                      sizeof(Address));
+  };
+
+  // The socket of a server which is gone is taken over.
+  int Probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  bool Serving = Connect(Probe);
+  ::close(Probe);
+  if (Serving) {
+    llvm::errs() << "northc: a server listens on " << Command.Socket << '\n';
+    return 1;
+  }
+
+  llvm::sys::fs::file_status Status;
+  if (!llvm::sys::fs::status(Command.Socket, Status) &&
+      Status.type() == llvm::sys::fs::file_type::socket_file)
+    ::unlink(Address.sun_path);
+
+  ServerContext Context;
+  if (!Context.initTarget(llvm::errs()))
+    return 1;
+  Context.reserveTargetMachines(
+      std::max(1u, std::thread::hardware_concurrency()));
+
+  int Listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ::fcntl(Listener, F_SETFD, FD_CLOEXEC);
+  if (Listener < 0 ||
+      ::bind(Listener, reinterpret_cast<sockaddr *>(&Address),
+             sizeof(Address)) ||
+      ::listen(Listener, SOMAXCONN)) {
+    llvm::errs() << "northc: can't listen on " << Command.Socket << ": "
+                 << std::strerror(errno) << '\n';
+    return 1;
+  }
+
+  // A client gone before its status is sent mustn't end the server.
+  ::signal(SIGPIPE, SIG_IGN);
+
+  llvm::outs() << "northc: serving on " << Command.Socket << '\n';
+  llvm::outs().flush();
+
+  while (true) {
+    int Client = ::accept(Listener, nullptr, nullptr);
+    if (Client < 0 && errno == EINTR)
+      continue;
+    if (Client < 0) {
+      llvm::errs() << "northc: " << std::strerror(errno) << '\n';
+      return 1;
+    }
+
+    timeval Timeout{RequestTimeout, 0};
+    ::setsockopt(Client, SOL_SOCKET, SO_RCVTIMEO, &Timeout, sizeof(Timeout));
+
+    // Builds are served one after another: each one hands the next the
+    // modules it compiled, and the builds of a directory write the same
+    // objects.
+    Context.serveClient(Client, Listener);
+    ::close(Client);
+  }
+}
+
+int requestBuild(llvm::StringRef Socket, int Count, const char *Args[]) {
+  sockaddr_un Address;
+  if (!getAddress(Socket, Address))
+    return 1;
+
+  int Server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (::connect(Server, reinterpret_cast<sockaddr *>(&Address),
+                sizeof(Address))) {
+    llvm::errs() << "northc: can't reach the server on " << Socket << ": "
+                 << std::strerror(errno) << '\n';
+    return 1;
+  }
+
+  llvm::SmallString<128> WorkingDir;
+  if (llvm::sys::fs::current_path(WorkingDir)) {
+    llvm::errs() << "northc: can't get the working directory\n";
+    return 1;
+  }
+
+  std::string Request(WorkingDir.str());
+  Request += '\0';
+  for (int I = 0; I < Count; ++I) {
+    if (std::strncmp(Args[I], "--server", 8) == 0)
+      continue;
+    Request += Args[I];
+    Request += '\0';
+  }
+
+  char Status;
+  if (!sendRequest(Server, Request) || !readAll(Server, &Status, 1)) {
+    llvm::errs() << "northc: the server on " << Socket
+                 << " dropped the build\n";
+    return 1;
+  }
+
+  ::close(Server);
+  return Status;
+}
+
+} // namespace north
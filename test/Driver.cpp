@@ -0,0 +1,315 @@
+#include <catch2/catch.hpp>
+#include <Targets/IRBuilder.h>
+
+#include <mutex>
+
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/TargetRegistry.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include "Frontend/CompilerInstance.h"
+#include "Frontend/ImportGraph.h"
+#include "Grammar/Lexer.h"
+#include "Grammar/Parser.h"
+#include "Sema/Sema.h"
+#include "Serialization/ObjectCache.h"
+#include "Opt.h"
+#include "Server.h"
+
+using namespace north;
+
+namespace {
+
+llvm::TargetMachine *createTargetMachine() {
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+
+  std::string Error;
+  auto Triple = llvm::sys::getDefaultTargetTriple();
+  auto Target = llvm::TargetRegistry::lookupTarget(Triple, Error);
+  REQUIRE( Target );
+
+  return Target->createTargetMachine(Triple, "generic", "",
+                                     llvm::TargetOptions(), llvm::None);
+}
+
+} // namespace
+
+TEST_CASE( "001-FoldInstances", "[driver]" ) {
+  CompilerInstance Instance;
+  auto &SourceManager = Instance.getSourceManager();
+  SourceManager.AddNewSourceBuffer(
+      llvm::MemoryBuffer::getMemBuffer(
+          "def id[T](_ x: T) -> T:\n  return x\n"
+          "def ints(_ p: *i32):\n  id(p)\n"
+          "def main():\n  id(\"s\")\n"),
+      llvm::SMLoc());
+
+  auto &Module = Instance.createModule("fold.n");
+  Lexer Lexer(SourceManager);
+  north::Parser(Lexer, &Module).parse();
+  sema::Sema(&Module).resolve();
+
+  targets::IRBuilder IR(&Module);
+  IR.instantiateGenerics();
+  for (auto &Node : *Module.getAST())
+    Node.accept(IR);
+  REQUIRE( !llvm::verifyModule(Module) );
+
+  std::unique_ptr<llvm::TargetMachine> TM(createTargetMachine());
+  Module.setTargetTriple(TM->getTargetTriple().str());
+  Module.setDataLayout(TM->createDataLayout());
+  BuildCommand Command;
+
+  auto Instances = [&] {
+    auto Id = (ast::GenericFunctionDecl *)&Module.getAST()->front();
+    return Id->getInstantiatedFunctions().size();
+  };
+  REQUIRE( Instances() == 2 );
+
+  internalizeInstances(Module);
+  auto Functions = Module.size();
+  auto Before = getTextSize(TM.get(), Module, Command);
+  REQUIRE( bool(Before) );
+
+  // Both instances only pass a pointer through, so one of them goes.
+  foldInstances(Module);
+  REQUIRE( Module.size() == Functions - 1 );
+  REQUIRE( !llvm::verifyModule(Module) );
+
+  auto After = getTextSize(TM.get(), Module, Command);
+  REQUIRE( bool(After) );
+  REQUIRE( *After < *Before );
+}
+
+TEST_CASE( "002-KeptModules", "[driver]" ) {
+  BuildContext::CompiledModule Module;
+  Module.Modified = llvm::sys::TimePoint<>(std::chrono::seconds(1700000000));
+  Module.Size = 42;
+  Module.Key.fill(7);
+  Module.Interface = std::string("NI\0face", 7);
+  Module.Object = "object";
+
+  auto Data = encodeModule("/src/a.n", Module) + encodeModule("/src/b.n", {});
+  llvm::StringMap<BuildContext::CompiledModule> Modules;
+  decodeModules(Data, Modules);
+  REQUIRE( Modules.size() == 2 );
+
+  auto &A = Modules["/src/a.n"];
+  REQUIRE( A.Modified == Module.Modified );
+  REQUIRE( A.Size == 42 );
+  REQUIRE( A.Key == Module.Key );
+  REQUIRE( A.Interface == Module.Interface );
+  REQUIRE( A.Object == "object" );
+  REQUIRE( Modules["/src/b.n"].Object.empty() );
+
+  // A build ended midway leaves its last record incomplete, which is
+  // dropped along with what follows it.
+  auto Size = encodeModule("/src/a.n", Module).size();
+  for (size_t Cut = 0; Cut < Data.size(); ++Cut) {
+    llvm::StringMap<BuildContext::CompiledModule> Read;
+    decodeModules(llvm::StringRef(Data).take_front(Cut), Read);
+    REQUIRE( Read.size() == (Cut < Size ? 0u : 1u) );
+  }
+
+  // A source is known by its size and time, its imports by their key.
+  llvm::SmallString<128> Path;
+  int FD;
+  REQUIRE( !llvm::sys::fs::createTemporaryFile("kept", "n", FD, Path) );
+  {
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << "def main():\n  return\n";
+  }
+  llvm::sys::fs::file_status Status;
+  REQUIRE( !llvm::sys::fs::status(Path, Status) );
+
+  Module.Size = Status.getSize();
+  Module.Modified = Status.getLastModificationTime();
+  REQUIRE( Module.isUpToDate(Status, Module.Key) );
+
+  auto Key = Module.Key;
+  Key[0] ^= 1;
+  REQUIRE_FALSE( Module.isUpToDate(Status, Key) );
+
+  Module.Size += 1;
+  REQUIRE_FALSE( Module.isUpToDate(Status, Module.Key) );
+  Module.Size -= 1;
+
+  REQUIRE( !llvm::sys::fs::openFileForWrite(Path, FD,
+                                            llvm::sys::fs::CD_OpenExisting) );
+  REQUIRE( !llvm::sys::fs::setLastAccessAndModificationTime(
+      FD, Module.Modified + std::chrono::seconds(1)) );
+  llvm::sys::Process::SafelyCloseFileDescriptor(FD);
+  REQUIRE( !llvm::sys::fs::status(Path, Status) );
+  REQUIRE( Status.getSize() == Module.Size );
+  REQUIRE_FALSE( Module.isUpToDate(Status, Module.Key) );
+
+  llvm::sys::fs::remove(Path);
+}
+
+TEST_CASE( "003-ErrorsReported", "[driver]" ) {
+  llvm::SmallVector<llvm::SmallString<128>, 2> Paths(2);
+  const char *Sources[] = {
+      // The parse stops at its first error.
+      "def f( -> i32:\n  return 1\ndef g( -> i32:\n  return 2\n",
+      "def h() -> i32:\n  return zz\n"};
+  for (unsigned I = 0; I < 2; ++I) {
+    int FD;
+    REQUIRE( !llvm::sys::fs::createTemporaryFile("errors", "n", FD, Paths[I]) );
+    llvm::raw_fd_ostream OS(FD, /*shouldClose=*/true);
+    OS << Sources[I];
+  }
+
+  // Errors are counted rather than fatal, and keep the module from Sema.
+  for (unsigned I = 0; I < 2; ++I) {
+    CompilerInstance Instance;
+    REQUIRE( !parseModule(Instance, Paths[I]) );
+    REQUIRE( Instance.getErrorCount() == 1 );
+  }
+
+  // Modules failing side by side both report, and the build returns.
+  BuildCommand Command;
+  Command.Inputs = {Paths[0], Paths[1]};
+  Command.Jobs = 2;
+  BuildContext Context;
+  REQUIRE_FALSE( build(Command, Context) );
+
+  for (auto &Path : Paths)
+    llvm::sys::fs::remove(Path);
+}
+
+TEST_CASE( "004-ImportGraph", "[driver]" ) {
+  llvm::SmallString<128> Dir;
+  REQUIRE_FALSE( llvm::sys::fs::createUniqueDirectory("north-graph", Dir) );
+  auto Write = [&](llvm::StringRef Name, llvm::StringRef Source) {
+    llvm::SmallString<128> Path(Dir);
+    llvm::sys::path::append(Path, Name);
+    llvm::sys::fs::create_directories(llvm::sys::path::parent_path(Path));
+    std::error_code EC;
+    llvm::raw_fd_ostream(Path, EC) << Source;
+    return std::string(Path.str());
+  };
+
+  auto Main = Write("Main.n", "open Left\nopen Right\nopen Main\n"
+                              "def main():\n  return\n");
+  Write("Left.n", "open Base\ndef left():\n  return\n");
+  Write("Right.n", "open Base\nopen Base\ndef right():\n  return\n");
+  Write("lib/Base.n", "def base():\n  return\n");
+  llvm::SmallString<128> Lib(Dir);
+  llvm::sys::path::append(Lib, "lib");
+
+  std::string Errors;
+  llvm::raw_string_ostream ErrorOS(Errors);
+  ImportGraph Graph({std::string(Lib.str())}, "", ErrorOS);
+  REQUIRE( Graph.addInput(Main) );
+  REQUIRE( Graph.checkCycles() );
+  REQUIRE( Graph.size() == 4 );
+
+  auto Base = Graph.lookup("Base");
+  REQUIRE( Base >= 0 );
+  REQUIRE( Graph.getModules()[Base].Importers.size() == 2 );
+  REQUIRE( Graph.getModules()[Graph.lookup("Right")].Imports ==
+           std::vector<unsigned>{unsigned(Base)} );
+  REQUIRE( Graph.getModules()[Graph.lookup("Main")].Imports.size() == 2 );
+
+  // A module is exported after every module it opens, and completed after
+  // being exported.
+  for (unsigned Jobs : {1u, 4u}) {
+    std::mutex Lock;
+    std::vector<int> Exported(Graph.size(), -1), Completed(Graph.size(), -1);
+    int Clock = 0;
+    auto Record = [&](std::vector<int> &Times, unsigned Id) {
+      std::lock_guard<std::mutex> Guard(Lock);
+      Times[Id] = Clock++;
+      return true;
+    };
+    REQUIRE( Graph.compile(
+        Jobs, [&](unsigned Id) { return Record(Exported, Id); },
+        [&](unsigned Id) { return Record(Completed, Id); }) );
+
+    for (unsigned Id = 0; Id < Graph.size(); ++Id) {
+      REQUIRE( Exported[Id] < Completed[Id] );
+      for (auto Import : Graph.getModules()[Id].Imports)
+        REQUIRE( Exported[Import] < Exported[Id] );
+    }
+  }
+
+  // Modules opening one which failed are skipped.
+  std::vector<unsigned> Exported;
+  REQUIRE_FALSE( Graph.compile(
+      1,
+      [&](unsigned Id) {
+        Exported.push_back(Id);
+        return Id != unsigned(Base);
+      },
+      [](unsigned) { return true; }) );
+  REQUIRE( Exported == std::vector<unsigned>{unsigned(Base)} );
+
+  Write("Cycle.n", "open Loop\n");
+  Write("Loop.n", "open Cycle\n");
+  ImportGraph Cyclic({}, "", ErrorOS);
+  REQUIRE( Cyclic.addInput(Write("Top.n", "open Cycle\n")) );
+  REQUIRE_FALSE( Cyclic.checkCycles() );
+
+  ImportGraph Missing({}, "", ErrorOS);
+  REQUIRE_FALSE( Missing.addInput(Main) );
+  REQUIRE( ErrorOS.str().find("can't find module 'Base'") !=
+           std::string::npos );
+
+  llvm::sys::fs::remove_directories(Dir);
+}
+
+TEST_CASE( "005-ObjectCache", "[driver]" ) {
+  using serialization::ObjectCache;
+
+  auto Key = ObjectCache::getKey("x86_64 generic release", "def main():\n",
+                                 {{"Base", "interface"}, {"Left", "left"}});
+  REQUIRE( Key == ObjectCache::getKey("x86_64 generic release",
+                                      "def main():\n",
+                                      {{"Left", "left"}, {"Base", "interface"}}) );
+  REQUIRE( Key != ObjectCache::getKey("x86_64 generic debug", "def main():\n",
+                                      {{"Base", "interface"}, {"Left", "left"}}) );
+  REQUIRE( Key != ObjectCache::getKey("x86_64 generic release", "def main():",
+                                      {{"Base", "interface"}, {"Left", "left"}}) );
+  REQUIRE( Key != ObjectCache::getKey("x86_64 generic release",
+                                      "def main():\n",
+                                      {{"Base", "interfac"}, {"eLeft", "left"}}) );
+  REQUIRE( Key != ObjectCache::getKey("x86_64 generic release",
+                                      "def main():\n", {{"Base", "interface"}}) );
+
+  llvm::SmallString<128> Dir;
+  REQUIRE_FALSE( llvm::sys::fs::createUniqueDirectory("north-objects", Dir) );
+  auto PathOf = [&](llvm::StringRef Name) {
+    llvm::SmallString<128> Path(Dir);
+    llvm::sys::path::append(Path, Name);
+    return std::string(Path.str());
+  };
+
+  auto Object = PathOf("Main.o");
+  {
+    std::error_code EC;
+    llvm::raw_fd_ostream(Object, EC) << "object";
+  }
+
+  ObjectCache Cache(PathOf("cache"));
+  std::string Interface = "untouched";
+  REQUIRE_FALSE( Cache.load(Key, PathOf("Loaded.o"), Interface) );
+  REQUIRE( Interface == "untouched" );
+
+  Cache.store(Key, Object, "interface");
+  REQUIRE( Cache.load(Key, PathOf("Loaded.o"), Interface) );
+  REQUIRE( Interface == "interface" );
+
+  auto Loaded = llvm::MemoryBuffer::getFile(PathOf("Loaded.o"));
+  REQUIRE( Loaded );
+  REQUIRE( (*Loaded)->getBuffer() == "object" );
+
+  REQUIRE( Cache.getHits() == 1 );
+  REQUIRE( Cache.getMisses() == 1 );
+
+  llvm::sys::fs::remove_directories(Dir);
+}
@@ -0,0 +1,83 @@
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <vector>
+
+#include "Grammar/Token.h"
+
+using namespace north;
+
+namespace {
+
+/// The linear table walk the lexer used before the perfect hash.
+Token linearKeywordLookup(llvm::StringRef Str) {
+  struct Keyword {
+    const char *Keyword;
+    unsigned char Length;
+    Token KwToken;
+  };
+
+  static const Keyword Keywords[] = {
+      {"def", 3, Token::Def},       {"else", 4, Token::Else},
+      {"for", 3, Token::For},       {"if", 2, Token::If},
+      {"in", 2, Token::In},         {"interface", 9, Token::Interface},
+      {"let", 3, Token::Let},       {"nil", 3, Token::Nil},
+      {"open", 4, Token::Open},     {"return", 6, Token::Return},
+      {"switch", 6, Token::Switch}, {"type", 4, Token::Type},
+      {"var", 3, Token::Var},       {"while", 5, Token::While}};
+
+  if (Str.size() < 2 || Str.size() > 9)
+    return Token::Identifier;
+
+  for (auto &K : Keywords)
+    if (Str.size() == K.Length && strncmp(K.Keyword, Str.data(), K.Length) == 0)
+      return K.KwToken;
+  return Token::Identifier;
+}
+
+std::vector<llvm::StringRef> identifierHeavyInput() {
+  static const char *Words[] = {
+      "def",  "main",    "let",    "x",      "lhs",       "rhs",
+      "if",   "ifx",     "in",     "index",  "interface", "interfaces",
+      "nil",  "nul",     "return", "result", "printf",    "mult",
+      "type", "typed",   "var",    "value",  "while",     "whilst",
+      "for",  "fur",     "else",   "ease",   "switch",    "sketch",
+      "open", "options", "_tmp",   "T",      "count",     "random_label"};
+
+  std::vector<llvm::StringRef> Input;
+  for (int I = 0; I != 64; ++I)
+    for (auto *W : Words)
+      Input.emplace_back(W);
+  return Input;
+}
+
+} // namespace
+
+TEST_CASE( "001-Keywords", "[lexer]" ) {
+  for (auto Str : identifierHeavyInput())
+    REQUIRE( lookupKeyword(Str) == linearKeywordLookup(Str) );
+
+  REQUIRE( lookupKeyword("switch") == Token::Switch );
+  REQUIRE( lookupKeyword("interface") == Token::Interface );
+  REQUIRE( lookupKeyword("") == Token::Identifier );
+  REQUIRE( lookupKeyword("defs") == Token::Identifier );
+  REQUIRE( llvm::StringRef(tokenToString(Token::Return)) == "`return`" );
+  REQUIRE( llvm::StringRef(tokenToString(Token::RightArrow)) == "`->`" );
+}
+
+TEST_CASE( "002-KeywordsBenchmark", "[lexer][!benchmark]" ) {
+  auto Input = identifierHeavyInput();
+
+  BENCHMARK( "linear scan" ) {
+    unsigned Keywords = 0;
+    for (auto Str : Input)
+      Keywords += linearKeywordLookup(Str) != Token::Identifier;
+    return Keywords;
+  };
+
+  BENCHMARK( "perfect hash" ) {
+    unsigned Keywords = 0;
+    for (auto Str : Input)
+      Keywords += lookupKeyword(Str) != Token::Identifier;
+    return Keywords;
+  };
+}
@@ -1,8 +1,11 @@
 #define CATCH_CONFIG_MAIN
 #include <catch2/catch.hpp>
+#include <random>
 #include <utility>
 
+#include "Grammar/CharScan.h"
 #include "Grammar/Lexer.h"
+#include "Grammar/LineTable.h"
 
 using namespace north;
 
@@ -51,12 +54,12 @@ public:
       REQUIRE( Lex->getNextToken().Type == Token::LBracket );
 
       TokenInfo Tk = Lex->getNextToken();
-      auto* Start = Tk.Pos.Offset;
+      auto* Start = Tk.getPointer();
       while (Tk.Type != Token::RBracket) {
         Tk = Lex->getNextToken();
         REQUIRE( Tk.Type != Token::Eof );
       }
-      size_t End = (size_t)((Tk.Pos.Offset + Tk.Pos.Length) - Start - 1);
+      size_t End = (size_t)((Tk.getPointer() + Tk.Pos.Length) - Start - 1);
 
       REQUIRE( Generics == llvm::StringRef(Start, End) );
     }
@@ -65,12 +68,12 @@ public:
 
     if (!Args.empty()) {
       TokenInfo Tk = Lex->getNextToken();
-      auto* Start = Tk.Pos.Offset;
+      auto* Start = Tk.getPointer();
       while (Tk.Type != Token::RParen) {
         Tk = Lex->getNextToken();
         REQUIRE( Tk.Type != Token::Eof );
       }
-      size_t End = (size_t)((Tk.Pos.Offset + Tk.Pos.Length) - Start - 1);
+      size_t End = (size_t)((Tk.getPointer() + Tk.Pos.Length) - Start - 1);
 
       REQUIRE( Args == llvm::StringRef(Start, End) );
     } else {
@@ -82,12 +85,12 @@ public:
 
       REQUIRE( Tk.Type == Token::RightArrow );
       Tk = Lex->getNextToken();
-      auto* Start = Tk.Pos.Offset;
+      auto* Start = Tk.getPointer();
       while (Tk.Type != Token::Colon) {
         Tk = Lex->getNextToken();
         REQUIRE( Tk.Type != Token::Eof );
       }
-      size_t End = (size_t)((Tk.Pos.Offset + Tk.Pos.Length) - Start - 1);
+      size_t End = (size_t)((Tk.getPointer() + Tk.Pos.Length) - Start - 1);
 
       REQUIRE( ReturnType == llvm::StringRef(Start, End) );
     }
@@ -105,12 +108,12 @@ public:
   void expectReturnStmt(llvm::StringRef Value) {
     REQUIRE( Lex->getNextToken().Type == Token::Return );
     TokenInfo Tk = Lex->getNextToken();
-    auto* Start = Tk.Pos.Offset;
+    auto* Start = Tk.getPointer();
     while (Tk.Type != Token::Dedent) {
       Tk = Lex->getNextToken();
       REQUIRE( Tk.Type != Token::Eof );
     }
-    size_t End = (size_t)((Tk.Pos.Offset + Tk.Pos.Length) - Start - 1);
+    size_t End = (size_t)((Tk.getPointer() + Tk.Pos.Length) - Start - 1);
     if (*(Start+End) == '\n') --End;
     REQUIRE( llvm::StringRef(Start, End) == Value );
   }
@@ -124,12 +127,12 @@ public:
     if (!Args.empty()) {
 
       TokenInfo Tk = Lex->getNextToken();
-      auto* Start = Tk.Pos.Offset;
+      auto* Start = Tk.getPointer();
       while (Tk.Type != Token::Dedent && Tk.Type != Token::Indent) {
         Tk = Lex->getNextToken();
         REQUIRE( Tk.Type != Token::Eof );
       }
-      size_t End = (size_t)((Tk.Pos.Offset + Tk.Pos.Length) - Start - 2);
+      size_t End = (size_t)((Tk.getPointer() + Tk.Pos.Length) - Start - 2);
       REQUIRE( llvm::StringRef(Start, End) == Args );
     } else {
       REQUIRE( Lex->getNextToken().Type == Token::RParen );
@@ -154,4 +157,122 @@ TEST_CASE( "001-Lexer", "[lexer]" ) {
     Lex->expectCallExpr("printf", "\"%s: %d\", random_vararg_label: \"mult() res:\", mult(5, rhs: 5)");
   });
 
-}
\ No newline at end of file
+}
+
+TEST_CASE( "002-CharScan", "[lexer]" ) {
+  // Long enough to cross several 16 and 32 byte blocks of the vector scans.
+  std::string Ident(70, 'a');
+  for (size_t I = 0; I != Ident.size(); ++I)
+    Ident[I] = "aZ_09xY"[I % 7];
+
+  for (size_t Stop = 0; Stop != Ident.size(); ++Stop) {
+    std::string Text = Ident;
+    Text[Stop] = '-';
+    auto *Begin = Text.c_str(), *End = Begin + Text.size();
+    REQUIRE( scan::skipIdentifier(Begin, End) == Begin + Stop );
+  }
+  REQUIRE( scan::skipIdentifier(Ident.c_str(), Ident.c_str() + Ident.size())
+           == Ident.c_str() + Ident.size() );
+
+  std::string Text(40, ' ');
+  Text += "\t\r  x";
+  REQUIRE( scan::skipBlanks(Text.c_str(), Text.c_str() + Text.size())
+           == Text.c_str() + Text.size() - 1 );
+
+  Text = std::string(33, '7') + "@";
+  REQUIRE( scan::skipDigits(Text.c_str(), Text.c_str() + Text.size())
+           == Text.c_str() + 33 );
+
+  Text = std::string(50, '.') + "\"" + std::string(10, '.') + "\n";
+  REQUIRE( scan::findStringEnd(Text.c_str(), Text.c_str() + Text.size())
+           == Text.c_str() + 50 );
+  REQUIRE( scan::findLineEnd(Text.c_str(), Text.c_str() + Text.size())
+           == Text.c_str() + 61 );
+
+  Text = std::string(20, '.');
+  REQUIRE( scan::findLineEnd(Text.c_str(), Text.c_str() + Text.size())
+           == Text.c_str() + Text.size() );
+
+  // The vector scans agree with the scalar ones on random text, from every
+  // start and up to every end around the block boundaries. The alphabet
+  // holds the characters next to each class's bounds.
+  using ScanFn = const char *(*)(const char *, const char *);
+  const std::pair<ScanFn, ScanFn> Scans[] = {
+      {scan::skipBlanks, scan::scalar::skipBlanks},
+      {scan::skipIdentifier, scan::scalar::skipIdentifier},
+      {scan::skipDigits, scan::scalar::skipDigits},
+      {scan::findLineEnd, scan::scalar::findLineEnd},
+      {scan::findStringEnd, scan::scalar::findStringEnd}};
+  const char Alphabet[] = " \t\r\n\"#/09:@AZ[_`az{\x7f\x80\xff";
+
+  std::mt19937 Random(2024);
+  for (unsigned Round = 0; Round != 200; ++Round) {
+    std::string Text(Random() % 100, ' ');
+    // Long runs are what the vector loops skip over.
+    auto Filler = Alphabet[Random() % (sizeof(Alphabet) - 1)];
+    for (auto &C : Text)
+      C = Random() % 4 ? Filler : Alphabet[Random() % (sizeof(Alphabet) - 1)];
+
+    auto *Begin = Text.c_str();
+    for (size_t From = 0; From <= Text.size(); ++From)
+      for (size_t To : {Text.size(), From + (Text.size() - From) / 2})
+        for (auto &Scan : Scans)
+          REQUIRE( Scan.first(Begin + From, Begin + To)
+                   == Scan.second(Begin + From, Begin + To) );
+  }
+}
+
+TEST_CASE( "003-TokenStream", "[lexer]" ) {
+  llvm::SourceMgr SourceManager;
+  SourceManager.AddNewSourceBuffer(
+      llvm::MemoryBuffer::getMemBuffer(
+          "def f():\n\n    x # note\n    # only a comment\n  \n  y\n"),
+      llvm::SMLoc());
+
+  Interner Symbols;
+  auto Tokens = Lexer(SourceManager).tokenize(Symbols);
+  const Token Expected[] = {Token::Def,        Token::Identifier,
+                            Token::LParen,     Token::RParen,
+                            Token::Colon,      Token::Newline,
+                            Token::Identifier, Token::Newline,
+                            Token::Identifier, Token::Newline,
+                            Token::Eof};
+
+  REQUIRE( Tokens.size() == std::size(Expected) );
+  for (size_t I = 0; I != Tokens.size(); ++I)
+    REQUIRE( Tokens.getKind(I) == Expected[I] );
+
+  // Newline markers start the line and span its leading spaces.
+  REQUIRE( Tokens.getOffset(5) == 10 );
+  REQUIRE( Tokens.getLength(5) == 4 );
+  REQUIRE( Tokens.getLength(9) == 0 );
+
+  // A comment leaves the line break to its line, and lines holding only a
+  // comment or blanks are skipped like empty ones.
+  REQUIRE( Tokens.getLength(7) == 2 );
+  REQUIRE( Tokens.get(8).toString() == "y" );
+  REQUIRE( Tokens.getOffset(7) + 2 == Tokens.getOffset(8) );
+
+  // Identifiers are interned, other tokens carry no symbol.
+  REQUIRE( Symbols.getName(Tokens.getSymbol(1)) == "f" );
+  REQUIRE( Tokens.getSymbol(8) == Symbols.lookup("y") );
+  REQUIRE( Tokens.getSymbol(0) == InvalidSymbol );
+}
+
+TEST_CASE( "004-LineTable", "[lexer]" ) {
+  STATIC_REQUIRE( sizeof(Position) == 8 );
+
+  LineTable Lines("a\n\n  b # c\nd");
+
+  auto Check = [&](uint32_t Offset, unsigned Line, unsigned Column) {
+    auto Loc = Lines.getLineAndColumn(Offset);
+    REQUIRE( Loc.Line == Line );
+    REQUIRE( Loc.Column == Column );
+  };
+
+  Check(0, 1, 1);
+  Check(1, 1, 2);
+  Check(2, 2, 1);
+  Check(5, 3, 3);
+  Check(11, 4, 1);
+}
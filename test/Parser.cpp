@@ -1,9 +1,19 @@
 #include <catch2/catch.hpp>
 #include <Targets/IRBuilder.h>
 
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Frontend/CompilerInstance.h"
 #include "Grammar/Lexer.h"
 #include "Grammar/Parser.h"
+#include "Sema/Sema.h"
+#include "Serialization/ASTFile.h"
+#include "Serialization/InterfaceFile.h"
 #include "Type/Module.h"
+#include "Type/Scope.h"
+#include "Type/TypeInference.h"
 #include "AST/AST.h"
 
 using namespace north;
@@ -11,6 +21,7 @@ using namespace north::ast;
 
 class ParserTester {
   using ASTType = llvm::simple_ilist<ast::Node>;
+  CompilerInstance Instance;
   ASTType *AST;
 
 public:
@@ -19,7 +30,8 @@ public:
     llvm::SourceMgr SourceManager;
     SourceManager.AddNewSourceBuffer(std::move(*MemBuff), llvm::SMLoc());
 
-    auto Module = new type::Module(Path, north::targets::IRBuilder::getContext(), SourceManager);
+    auto Module = new type::Module(Path, Instance.getContext(), SourceManager,
+                                   Instance.getPrimitives());
 
     Lexer Lexer(SourceManager);
     north::Parser(Lexer, Module).parse();
@@ -36,7 +48,7 @@ public:
   void expectFuncDecl(llvm::StringRef Name,
                       std::function<void(FunctionDecl*)> DeclVerifier = nullptr,
                       std::function<void(BlockStmt*)> BlockVerifier = nullptr) {
-    REQUIRE( AST->front().getKind() == AST_FunctionDecl );
+    REQUIRE( llvm::isa<FunctionDecl>(AST->front()) );
     auto Fn = ((FunctionDecl *)&AST->front());
     REQUIRE( Fn->getIdentifier() == Name );
     if (DeclVerifier) DeclVerifier(Fn);
@@ -57,6 +69,25 @@ public:
   }
 };
 
+namespace {
+
+/// Parses \p Source as the module of \p Instance, which has no source yet.
+/// Errors are counted by the instance.
+type::Module &parseSource(CompilerInstance &Instance, llvm::StringRef Source,
+                          llvm::StringRef Name = "test.n",
+                          bool LazyBodies = false) {
+  auto &SourceManager = Instance.getSourceManager();
+  SourceManager.AddNewSourceBuffer(
+      llvm::MemoryBuffer::getMemBufferCopy(Source), llvm::SMLoc());
+
+  auto &Module = Instance.createModule(Name);
+  Lexer Lexer(SourceManager);
+  north::Parser(Lexer, &Module, LazyBodies).parse();
+  return Module;
+}
+
+} // namespace
+
 TEST_CASE( "001-Parser", "[parser]" ) {
   ParserTester Parser("../../test/tests/001.n");
 
@@ -89,4 +120,645 @@ TEST_CASE( "001-Parser", "[parser]" ) {
     });
   });
 
-}
\ No newline at end of file
+}
+
+TEST_CASE( "002-ModuleArena", "[parser]" ) {
+  CompilerInstance Instance;
+  auto &Module = parseSource(Instance,
+      "type Point = {x: i32, y: i32}\n"
+      "def sum(_ a: i32, _ b: i32) -> i32:\n  return a + b\n", "arena.n");
+
+  auto AST = Module.getAST();
+  REQUIRE( AST->size() == 2 );
+  REQUIRE( AST->front().getKind() == AST_TypeDef );
+  REQUIRE( AST->back().getKind() == AST_FunctionDecl );
+
+  auto Fn = (FunctionDecl *)&AST->back();
+  auto &Return = Fn->getBlockStmt()->getBody()->front();
+  REQUIRE( Return.getKind() == AST_ReturnStmt );
+
+  // Destroying an arena runs the destructors of its nodes, latest first, as
+  // they may own heap storage of their own.
+  struct Probe : Node {
+    std::vector<int> &Destroyed;
+    int Id;
+
+    Probe(std::vector<int> &Destroyed, int Id)
+        : Node(Position{}, AST_LiteralExpr), Destroyed(Destroyed), Id(Id) {}
+    ~Probe() override { Destroyed.push_back(Id); }
+  };
+
+  std::vector<int> Destroyed;
+  {
+    type::NodeArena Arena;
+    Arena.create<Probe>(Destroyed, 1);
+    Arena.create<Probe>(Destroyed, 2);
+    REQUIRE( Destroyed.empty() );
+  }
+  REQUIRE( Destroyed == std::vector<int>{2, 1} );
+}
+
+TEST_CASE( "003-TypeTable", "[parser]" ) {
+  CompilerInstance Instance;
+  auto &Module = parseSource(Instance,
+                             "type Point = {x: i32, y: i32}\n"
+                             "type Ptr = *i8\n", "types.n");
+
+  auto &Ctx = Instance.getContext();
+  auto &Primitives = Instance.getPrimitives();
+  REQUIRE( Module.getUniqueType(llvm::Type::getInt32Ty(Ctx)) == Primitives.Int32 );
+  REQUIRE( Primitives.Char == Primitives.Int8 );
+
+  auto Ptr = Module.getPointerType(Primitives.Int32);
+  REQUIRE( Ptr == Module.getPointerType(Primitives.Int32) );
+  REQUIRE( Module.getArrayType(Ptr, 4) == Module.getArrayType(Ptr, 4) );
+  REQUIRE( Module.getArrayType(Ptr, 4) != Module.getArrayType(Ptr, 8) );
+
+  auto Point = Module.getType(Module.getInterner().lookup("Point"));
+  REQUIRE( Module.getUniqueType(Point->getIR()) == Point );
+
+  // Types of the same IR are one: an alias keeps its declaration under its
+  // name, while its values have the type it names.
+  auto Alias = Module.getType(Module.getInterner().lookup("Ptr"));
+  auto Named = Module.getPointerType(Primitives.Int8);
+  REQUIRE( Alias != Named );
+  REQUIRE( Alias->getDecl() != nullptr );
+  REQUIRE( Module.getUniqueType(Alias->getIR()) == Named );
+  REQUIRE( Module.getType(Module.getInterner().lookup("char")) == Primitives.Int8 );
+}
+
+TEST_CASE( "004-FlatScope", "[parser]" ) {
+  CompilerInstance Instance;
+  Instance.getSourceManager().AddNewSourceBuffer(
+      llvm::MemoryBuffer::getMemBuffer("x y\n"), llvm::SMLoc());
+  auto &Module = Instance.createModule("scope.n");
+
+  auto Buffer = Module.getLineTable().getBuffer().data();
+  auto &Symbols = Module.getInterner();
+  auto X = Symbols.intern("x"), Y = Symbols.intern("y");
+
+  auto Outer = Module.create<VarDecl>(TokenInfo{{0, 1}, Token::Identifier, X, Buffer});
+  auto Inner = Module.create<VarDecl>(TokenInfo{{0, 1}, Token::Identifier, X, Buffer});
+  auto Other = Module.create<VarDecl>(TokenInfo{{2, 1}, Token::Identifier, Y, Buffer});
+
+  type::Scope Scope(&Module);
+  Scope.enterBlock();
+  Scope.addElement(Outer);
+  REQUIRE( Scope.lookup(X) == Outer );
+
+  Scope.enterBlock();
+  Scope.addElement(Inner);
+  Scope.addElement(Other);
+  REQUIRE( Scope.getDepth() == 2 );
+  REQUIRE( Scope.lookup(X) == Inner );
+  REQUIRE( Scope.lookup(Y) == Other );
+
+  Scope.leaveBlock();
+  REQUIRE( Scope.lookup(X) == Outer );
+  REQUIRE( Scope.lookup(Y) == nullptr );
+
+  Scope.leaveBlock();
+  REQUIRE( Scope.lookup(X) == nullptr );
+}
+
+TEST_CASE( "005-GenericBound", "[parser]" ) {
+  CompilerInstance Instance;
+  auto &Module = parseSource(Instance,
+      "interface Addable[T] =\n  def plus(_ lhs: T, rhs: T) -> T\n"
+      "def add[T: Addable, U](_ lhs: T, rhs: U) -> T:\n  return lhs\n",
+      "bound.n");
+
+  auto &Symbols = Module.getInterner();
+  auto Fn = (GenericFunctionDecl *)&Module.getAST()->back();
+  auto &Generics = Fn->getGenericsList();
+  REQUIRE( Module.getInterface(Symbols.lookup("Addable"), Generics[0].Pos) ==
+           &Module.getAST()->front() );
+  REQUIRE( Generics.size() == 2 );
+  REQUIRE( Generics[0].isBounded() );
+  REQUIRE( Generics[0].BoundName == "Addable" );
+  REQUIRE( Generics[0].Bound == Symbols.lookup("Addable") );
+  REQUIRE( !Generics[1].isBounded() );
+}
+
+TEST_CASE( "006-Sema", "[parser]" ) {
+  CompilerInstance Instance;
+  auto &Module = parseSource(Instance,
+      "def main() -> i32:\n  var x = 1\n  return twice(x)\n"
+      "def twice(_ a: i32) -> i32:\n  return a\n", "sema.n");
+  REQUIRE( sema::Sema(&Module).resolve() );
+
+  auto Main = (FunctionDecl *)&Module.getAST()->front();
+  auto Twice = (FunctionDecl *)&Module.getAST()->back();
+
+  // A call may precede the definition of its callee.
+  auto Body = Main->getBlockStmt()->getBody();
+  auto X = (VarDecl *)&Body->front();
+  auto Call = (CallExpr *)((ReturnStmt *)&Body->back())->getReturnExpr();
+  REQUIRE( Call->getCallableFn() == Twice );
+  REQUIRE( ((LiteralExpr *)Call->getArg(0)->Arg)->getVar() == X );
+
+  auto Return = (ReturnStmt *)&Twice->getBlockStmt()->getBody()->front();
+  REQUIRE( ((LiteralExpr *)Return->getReturnExpr())->getVar() == Twice->getArg(0) );
+
+  // A module with errors must not get to the backends.
+  CompilerInstance BadInstance;
+  auto &Bad = parseSource(BadInstance,
+      "def main() -> i32:\n  return p.x\n"
+      "def other() -> i32:\n  return Point{1}\n", "bad.n");
+  REQUIRE( BadInstance.getErrorCount() == 0 );
+  REQUIRE( !sema::Sema(&Bad).resolve() );
+  REQUIRE( BadInstance.getErrorCount() == 2 );
+}
+
+TEST_CASE( "007-ParallelSema", "[parser]" ) {
+  CompilerInstance Instance;
+  // Enough bodies to be spread over the workers.
+  std::string Source = "def id[T](_ x: T) -> T:\n  return x\n"
+                       "def f0(_ a: i32) -> i32:\n  return a\n";
+  for (int I = 1; I < 256; ++I)
+    Source += "def f" + std::to_string(I) + "(_ a: i32) -> i32:\n"
+              "  var b = id(a)\n  return f" + std::to_string(I - 1) + "(b)\n";
+
+  auto &Module = parseSource(Instance, Source, "parallel.n");
+  sema::Sema(&Module).resolve();
+
+  auto &AST = *Module.getAST();
+  auto Id = (GenericFunctionDecl *)&AST.front();
+  auto Calls = Id->getCalls();
+  REQUIRE( Calls.size() == 255 );
+
+  // Calls of generic functions are merged back in source order.
+  size_t I = 0;
+  FunctionDecl *Prev = nullptr;
+  for (auto &Node : llvm::make_range(std::next(AST.begin()), AST.end())) {
+    auto Fn = (FunctionDecl *)&Node;
+    auto Body = Fn->getBlockStmt()->getBody();
+    if (Prev) {
+      auto B = (VarDecl *)&Body->front();
+      REQUIRE( Calls[I++] == B->getValue() );
+
+      auto Call = (CallExpr *)((ReturnStmt *)&Body->back())->getReturnExpr();
+      REQUIRE( Call->getCallableFn() == Prev );
+      REQUIRE( ((LiteralExpr *)Call->getArg(0)->Arg)->getVar() == B );
+    }
+    Prev = Fn;
+  }
+
+  // So are the calls of top-level variables, around those of the bodies.
+  CompilerInstance GlobalInstance;
+  auto &Globals = parseSource(GlobalInstance,
+      "def id[T](_ x: T) -> T:\n  return x\n"
+      "var a = id(1)\n"
+      "def f() -> i32:\n  return id(2)\n"
+      "var b = id(3)\nvar c = id(4)\n"
+      "def g() -> i32:\n  return id(5)\n"
+      "var d = id(6)\n", "globals.n");
+  REQUIRE( sema::Sema(&Globals).resolve() );
+
+  auto GlobalId = (GenericFunctionDecl *)&Globals.getAST()->front();
+  auto GlobalCalls = GlobalId->getCalls();
+  REQUIRE( GlobalCalls.size() == 6 );
+  for (size_t I = 0; I != GlobalCalls.size(); ++I) {
+    auto Arg = (LiteralExpr *)GlobalCalls[I]->getArg(0)->Arg;
+    REQUIRE( Arg->getTokenInfo().toString() == std::to_string(I + 1) );
+  }
+}
+
+TEST_CASE( "008-LazyBodies", "[parser]" ) {
+  CompilerInstance Instance;
+  auto &Module = parseSource(Instance,
+      "def _deep() -> i32:\n  return 1\n"
+      "def _unused() -> i32:\n  if 1:\n    return _deep()\n  return 2\n"
+      "def _used() -> i32:\n  return _deep()\n"
+      "def main() -> i32:\n  return _used()\n", "lazy.n",
+      /*LazyBodies=*/true);
+
+  auto &Symbols = Module.getInterner();
+  auto Deep = Module.lookupFunction(Symbols.lookup("_deep"));
+  auto Unused = Module.lookupFunction(Symbols.lookup("_unused"));
+  auto Used = Module.lookupFunction(Symbols.lookup("_used"));
+  auto Main = Module.lookupFunction(Symbols.lookup("main"));
+
+  REQUIRE( Main->getBlockStmt() );
+  REQUIRE( Used->getBlockStmt() );
+  REQUIRE( Deep->getBlockStmt() );
+  REQUIRE( Deep->maybeGetIR() );
+
+  // Skipped up to the next top-level line, and never declared in the IR.
+  REQUIRE( !Unused->getBlockStmt() );
+  REQUIRE( !Unused->maybeGetIR() );
+  REQUIRE( &*std::next(Unused->getIterator()) == Used );
+}
+
+TEST_CASE( "009-ParallelParse", "[parser]" ) {
+  constexpr unsigned Count = 4096;
+
+  std::string Source = "type Pair = { a: i32, b: i32 }\n";
+  for (unsigned I = 0; I < Count; ++I)
+    Source += "def f" + std::to_string(I) +
+              "(x: i32) -> i32:\n  var y = x + 1\n  return y\n";
+
+  CompilerInstance Instance;
+  auto &Module = parseSource(Instance, Source, "parts.n");
+  REQUIRE( Instance.getErrorCount() == 0 );
+
+  // Merged in source order, and every declaration registered.
+  auto &Symbols = Module.getInterner();
+  REQUIRE( Module.getTypeOrNull(Symbols.lookup("Pair")) );
+
+  auto Node = std::next(Module.getAST()->begin());
+  for (unsigned I = 0; I < Count; ++I, ++Node) {
+    auto Fn = Module.lookupFunction(Symbols.lookup("f" + std::to_string(I)));
+    REQUIRE( Fn == &*Node );
+    REQUIRE( Fn->getBlockStmt()->getBody()->size() == 2 );
+  }
+  REQUIRE( Node == Module.getAST()->end() );
+
+  // Errors are reported once, by the serial parse.
+  std::string Broken = "def broken(x: i32 -> i32:\n  return x\n";
+  CompilerInstance BrokenInstance;
+  parseSource(BrokenInstance, Broken, "parts.n");
+  auto Expected = BrokenInstance.getErrorCount();
+  REQUIRE( Expected > 0 );
+
+  CompilerInstance Appended;
+  parseSource(Appended, Source + Broken, "parts.n");
+  REQUIRE( Appended.getErrorCount() == Expected );
+}
+
+TEST_CASE( "010-BinaryAST", "[parser]" ) {
+  CompilerInstance Instance;
+  auto &Original = parseSource(Instance,
+      "type Pair = { a: i32, b: i32 }\n"
+      "def add(p: Pair) -> i32:\n  var s = p.a + p.b\n  return s\n"
+      "def main() -> i32:\n  if 1 < 2:\n    return 3\n  return 4\n",
+      "binary.n");
+
+  // Modules read back share the source of the original.
+  auto &SourceManager = Instance.getSourceManager();
+  auto Empty = [&] {
+    return std::make_unique<type::Module>(
+        "binary.n", Instance.getContext(), SourceManager,
+        Instance.getPrimitives());
+  };
+
+  std::string Data;
+  llvm::raw_string_ostream OS(Data);
+  REQUIRE( serialization::writeAST(Original, OS) );
+  OS.flush();
+
+  auto Loaded = Empty();
+  REQUIRE( serialization::readAST(Data, *Loaded) );
+  REQUIRE( Loaded->getAST()->size() == Original.getAST()->size() );
+
+  auto &Symbols = Loaded->getInterner();
+  REQUIRE( Loaded->getTypeOrNull(Symbols.lookup("Pair")) );
+  auto Add = Loaded->lookupFunction(Symbols.lookup("add"));
+  REQUIRE( Add );
+  REQUIRE( Add->getBlockStmt()->getBody()->size() == 2 );
+  REQUIRE( Add->getBlockStmt()->getOwner() == Add );
+  REQUIRE( &*Loaded->getAST()->rbegin() ==
+           Loaded->lookupFunction(Symbols.lookup("main")) );
+
+  // Damaged data is rejected and leaves the module empty.
+  for (size_t Size = 0; Size < Data.size(); ++Size) {
+    auto Truncated = Empty();
+    REQUIRE_FALSE( serialization::readAST(Data.substr(0, Size), *Truncated) );
+    REQUIRE( Truncated->getAST()->empty() );
+  }
+
+  // Whatever a damaged byte turns into, positions stay within the source.
+  auto SourceSize = SourceManager.getMemoryBuffer(1)->getBufferSize();
+  for (size_t I = 0; I < Data.size(); ++I) {
+    auto Damaged = Data;
+    Damaged[I] = 0x7f;
+    auto Read = Empty();
+    if (!serialization::readAST(Damaged, *Read))
+      continue;
+    for (auto &Node : *Read->getAST()) {
+      auto &Pos = Node.getPosition();
+      REQUIRE( uint64_t(Pos.Offset) + Pos.Length <= SourceSize );
+    }
+  }
+}
+
+TEST_CASE( "011-ModuleInterface", "[parser]" ) {
+  CompilerInstance ExporterInstance;
+  auto &Exporter = parseSource(ExporterInstance,
+      "open Base\n"
+      "type Pair = { a: i32, b: i32 }\n"
+      "def printf(_: *i8, ...)\n"
+      "def _helper(_ x: i32) -> i32:\n  return x\n"
+      "def twice(_ x: i32) -> i32:\n  return _helper(x) * 2\n"
+      "def add[T](_ lhs: T, rhs: T) -> T:\n  return lhs + rhs\n",
+      "module.n");
+
+  std::string Data;
+  llvm::raw_string_ostream OS(Data);
+  REQUIRE( serialization::writeInterface(Exporter, OS) );
+  OS.flush();
+
+  // The importer numbers its symbols on its own.
+  CompilerInstance ImporterInstance;
+  auto &Importer =
+      parseSource(ImporterInstance, "def main():\n  twice(1)\n", "module.n");
+  Position Pos{0, 4};
+
+  std::vector<std::string> Imports;
+  auto LoadImport = [&](llvm::StringRef Name) {
+    Imports.push_back(Name.str());
+    return true;
+  };
+  REQUIRE( serialization::readInterface(Data, Importer, Pos, LoadImport) );
+  REQUIRE( Imports == std::vector<std::string>{"Base"} );
+
+  auto &Symbols = Importer.getInterner();
+  REQUIRE( Importer.getTypeOrNull(Symbols.lookup("Pair")) );
+  REQUIRE_FALSE( Importer.lookupFunction(Symbols.lookup("printf")) );
+  REQUIRE_FALSE( Importer.lookupFunction(Symbols.lookup("_helper")) );
+
+  auto Twice = Importer.lookupFunction(Symbols.lookup("twice"));
+  REQUIRE( Twice );
+  REQUIRE( Twice->getIdentifier() == "twice" );
+  REQUIRE( Importer.isImported(Twice) );
+  REQUIRE( Twice->getPosition().Offset == Pos.Offset );
+  REQUIRE_FALSE( Twice->getBlockStmt() );
+
+  auto Add = Importer.lookupFunction(Symbols.lookup("add"));
+  REQUIRE( Add );
+  REQUIRE( Add->hasGenerics() );
+  REQUIRE( Add->getBlockStmt()->getBody()->size() == 1 );
+  REQUIRE( Add->getArg(1)->getSymbol() == Symbols.lookup("rhs") );
+
+  // Damaged data registers nothing, and a failed import stops the read.
+  for (size_t Size = 0; Size < Data.size(); ++Size) {
+    CompilerInstance Instance;
+    auto &Truncated =
+        parseSource(Instance, "def main():\n  return\n", "module.n");
+    REQUIRE_FALSE( serialization::readInterface(Data.substr(0, Size),
+                                                Truncated, Pos, LoadImport) );
+    REQUIRE( Truncated.getAST()->size() == 1 );
+  }
+
+  CompilerInstance FailingInstance;
+  auto &Failing =
+      parseSource(FailingInstance, "def main():\n  return\n", "module.n");
+  REQUIRE_FALSE( serialization::readInterface(
+      Data, Failing, Pos, [](llvm::StringRef) { return false; }) );
+  REQUIRE( Failing.getAST()->size() == 1 );
+
+  // Exported generic bodies can't use what stays with the module.
+  CompilerInstance PrivateInstance;
+  auto &Private = parseSource(PrivateInstance,
+      "var scale = 2\n"
+      "def _helper(_ x: i32) -> i32:\n  return x\n"
+      "def call[T](_ x: T) -> i32:\n  return _helper(1)\n"
+      "def scaled[T](_ x: T) -> i32:\n  return scale\n", "module.n");
+  REQUIRE( sema::Sema(&Private).resolve() );
+  std::string Rejected;
+  llvm::raw_string_ostream RejectedOS(Rejected);
+  REQUIRE_FALSE( serialization::writeInterface(Private, RejectedOS) );
+  REQUIRE( RejectedOS.str().empty() );
+  REQUIRE( PrivateInstance.getErrorCount() == 2 );
+
+  // A module which can't be loaded is remembered by its importer.
+  struct FailingLoader : type::ModuleLoader {
+    bool load(type::Module &, ast::OpenStmt &) override { return false; }
+  } Loader;
+  CompilerInstance OpenInstance;
+  auto &OpenSource = OpenInstance.getSourceManager();
+  OpenSource.AddNewSourceBuffer(
+      llvm::MemoryBuffer::getMemBuffer("open Base\ndef main():\n  return\n"),
+      llvm::SMLoc());
+  auto &Opening = OpenInstance.createModule("opening.n");
+  Opening.setLoader(&Loader);
+  Lexer OpenLexer(OpenSource);
+  north::Parser(OpenLexer, &Opening).parse();
+  REQUIRE( Opening.hasFailedImport() );
+  REQUIRE_FALSE( Exporter.hasFailedImport() );
+}
+
+TEST_CASE( "012-CompilerInstance", "[parser]" ) {
+  constexpr unsigned Threads = 8;
+  const char *Source =
+      "def printf(_: *i8, ...)\n"
+      "def add[T](_ lhs: T, rhs: T) -> T:\n  return lhs + rhs\n"
+      "def twice(_ x: i32) -> i32:\n  return x * 2\n"
+      "def main():\n"
+      "  printf(\"%d %d %c\\n\", twice(21), add(5, rhs: 6), add('a', rhs: '0'))\n";
+
+  auto Compile = [&](CompilerInstance &Instance) {
+    auto &Module = parseSource(Instance, Source, "instance.n");
+    sema::Sema(&Module).resolve();
+
+    targets::IRBuilder IR(&Module);
+    IR.instantiateGenerics();
+    for (auto &Node : *Module.getAST())
+      Node.accept(IR);
+
+    std::string Result;
+    llvm::raw_string_ostream OS(Result);
+    OS << static_cast<llvm::Module &>(Module);
+    return OS.str();
+  };
+
+  CompilerInstance Serial;
+  auto Expected = Compile(Serial);
+  REQUIRE( Expected.find("define void @main()") != std::string::npos );
+
+  // Instances share nothing, so they compile side by side.
+  std::vector<CompilerInstance> Instances(Threads);
+  std::vector<std::string> Results(Threads);
+  std::vector<std::thread> Workers;
+  for (unsigned I = 0; I < Threads; ++I)
+    Workers.emplace_back([&, I] { Results[I] = Compile(Instances[I]); });
+  for (auto &Worker : Workers)
+    Worker.join();
+
+  for (unsigned I = 0; I < Threads; ++I) {
+    REQUIRE( Results[I] == Expected );
+    REQUIRE( &Instances[I].getContext() != &Serial.getContext() );
+    REQUIRE( Instances[I].getPrimitives().Int32->getIR() !=
+             Serial.getPrimitives().Int32->getIR() );
+  }
+}
+
+TEST_CASE( "015-InferenceMemo", "[parser]" ) {
+  CompilerInstance Instance;
+  auto &Module =
+      parseSource(Instance, "def main() -> i32:\n  return 1\n", "memo.n");
+  sema::Sema(&Module).resolve();
+
+  auto &Primitives = Instance.getPrimitives();
+  auto Main = (FunctionDecl *)&Module.getAST()->front();
+  auto Return = (ReturnStmt *)&Main->getBlockStmt()->getBody()->front();
+  auto Value = Return->getReturnExpr();
+
+  REQUIRE( Module.getInferredType(Value) == nullptr );
+  REQUIRE( type::inferExprType(Value, &Module) == Primitives.Int32 );
+  REQUIRE( Module.getInferredType(Value) == Primitives.Int32 );
+
+  // A memoized node is never inferred again.
+  Module.setInferredType(Value, Primitives.Int64);
+  REQUIRE( type::inferExprType(Value, &Module) == Primitives.Int64 );
+
+  // Results within a generic body last for one instance, and leave the
+  // module's untouched.
+  Module.enterGenericBody();
+  REQUIRE( Module.getInferredType(Value) == nullptr );
+  REQUIRE( type::inferExprType(Value, &Module) == Primitives.Int32 );
+  Module.setInferredType(Value, Primitives.Int8);
+  Module.leaveGenericBody();
+  REQUIRE( Module.getInferredType(Value) == Primitives.Int64 );
+
+  Module.enterGenericBody();
+  REQUIRE( Module.getInferredType(Value) == nullptr );
+  Module.leaveGenericBody();
+}
+
+TEST_CASE( "016-InstanceKeys", "[parser]" ) {
+  CompilerInstance Instance;
+  auto &Module = parseSource(Instance,
+      "def id[T](_ x: T) -> T:\n  return x\n"
+      "def wrap[U](_ y: U) -> U:\n  return id(y)\n", "keys.n");
+  sema::Sema(&Module).resolve();
+
+  auto Id = (GenericFunctionDecl *)&Module.getAST()->front();
+  auto Wrap = (GenericFunctionDecl *)&Module.getAST()->back();
+  auto Return = (ReturnStmt *)&Wrap->getBlockStmt()->getBody()->front();
+  auto Call = (CallExpr *)Return->getReturnExpr();
+  auto Y = Wrap->getArg(0);
+
+  // The call site is part of every instance of wrap, and instantiates id
+  // with the type of y in each.
+  auto &Primitives = Instance.getPrimitives();
+  auto InstanceFor = [&](type::Type *T) {
+    Module.enterGenericBody();
+    Y->setIRType(T ? T->getIR() : nullptr);
+    auto Fn = Id->instantiate(Call, &Module);
+    Module.leaveGenericBody();
+    return Fn;
+  };
+
+  auto OfInt = InstanceFor(Primitives.Int32);
+  auto OfPtr = InstanceFor(Module.getPointerType(Primitives.Int8));
+  REQUIRE( OfInt != nullptr );
+  REQUIRE( OfPtr != nullptr );
+  REQUIRE( OfInt != OfPtr );
+  REQUIRE( InstanceFor(Primitives.Int32) == OfInt );
+
+  // A type that can't be inferred makes no instance.
+  REQUIRE( InstanceFor(nullptr) == nullptr );
+}
+
+TEST_CASE( "017-ParallelInstances", "[parser]" ) {
+  // Enough instances for a few chunks, see IRBuilder::instantiateGenerics().
+  std::string Source = "def printf(_: *i8, ...)\n";
+  for (unsigned I = 0; I != 70; ++I)
+    Source += "def g" + std::to_string(I) +
+              "[T](_ x: T) -> T:\n  var y = x\n  printf(\"%d\\n\", y)\n"
+              "  return x\n";
+  Source += "def main():\n";
+  for (unsigned I = 0; I != 70; ++I)
+    Source += "  printf(\"%d %c\\n\", g" + std::to_string(I) + "(" +
+              std::to_string(I) + "), g" + std::to_string(I) + "('a'))\n";
+
+  auto Compile = [&](unsigned Jobs) {
+    CompilerInstance Instance;
+    auto &Module = parseSource(Instance, Source, "instances.n");
+    sema::Sema(&Module).resolve();
+
+    targets::IRBuilder IR(&Module);
+    REQUIRE( IR.instantiateGenerics(Jobs) );
+    for (auto &Node : *Module.getAST())
+      Node.accept(IR);
+
+    std::string Result;
+    llvm::raw_string_ostream OS(Result);
+    OS << static_cast<llvm::Module &>(Module);
+    return OS.str();
+  };
+
+  auto Serial = Compile(1);
+  REQUIRE( Serial.find("define i8 @g69") != std::string::npos );
+
+  // Linking the chunks back gives what emitting them in place does.
+  REQUIRE( Compile(3) == Serial );
+}
+
+TEST_CASE( "018-GenericCheck", "[parser]" ) {
+  CompilerInstance Instance;
+  using ErrorList = std::vector<std::pair<unsigned, std::string>>;
+  ErrorList Errors;
+  Instance.getSourceManager().setDiagHandler(
+      [](const llvm::SMDiagnostic &Diag, void *Errors) {
+        static_cast<ErrorList *>(Errors)->emplace_back(
+            Diag.getLineNo(), Diag.getMessage().str());
+      },
+      &Errors);
+
+  auto &Module = parseSource(Instance,
+      "interface Addable[T] =\n  def plus(_ lhs: T, rhs: T) -> T\n"
+      "def plus(_ lhs: i32, rhs: i32) -> i32:\n  return lhs + rhs\n"
+      "def twice(_ x: i32) -> i32:\n  return x * 2\n"
+      "def sum[T: Addable](_ a: T, b: T) -> T:\n"
+      "  var s = plus(a, rhs: b)\n"
+      "  while 1:\n    if 1:\n      var t = plus(s, rhs: a)\n"
+      "  return s\n"
+      "def sub[T: Addable](_ a: T, b: T) -> T:\n"
+      "  if 1:\n    return a - b\n  return a\n"
+      "def dbl[T: Addable](_ a: T) -> T:\n  while 1:\n    twice(a)\n"
+      "  return a\n"
+      "def lost[T: Missing](_ a: T) -> T:\n  return a\n"
+      "def main():\n  sum(1, b: 2)\n  sum('a', b: 'b')\n", "check.n");
+  sema::Sema(&Module).resolve();
+  REQUIRE( Errors.empty() );
+
+  auto &Symbols = Module.getInterner();
+  auto Generic = [&](llvm::StringRef Name) {
+    return (GenericFunctionDecl *)Module.lookupFunction(Symbols.lookup(Name));
+  };
+
+  // Calls to what the bound demands are fine, in nested blocks too.
+  auto Sum = Generic("sum");
+  REQUIRE( type::checkGenericFunction(*Sum, &Module) );
+  REQUIRE( Sum->isBodyChecked() );
+  REQUIRE( Errors.empty() );
+
+  // Operators and other functions aren't, wherever they are used.
+  REQUIRE( type::checkGenericFunction(*Generic("sub"), &Module) );
+  REQUIRE( Errors.size() == 1 );
+  REQUIRE( Errors.back().first == 15 );
+  REQUIRE( Errors.back().second == "`Addable` provides no operators for `T`" );
+
+  REQUIRE( type::checkGenericFunction(*Generic("dbl"), &Module) );
+  REQUIRE( Errors.size() == 2 );
+  REQUIRE( Errors.back().first == 19 );
+  REQUIRE( Errors.back().second ==
+           "`twice` isn't demanded by `Addable`, the bound of `T`" );
+
+  // An undefined bound is reported where it is used, the body is left
+  // to its instances.
+  auto Lost = Generic("lost");
+  REQUIRE( !type::checkGenericFunction(*Lost, &Module) );
+  REQUIRE( !Lost->isBodyChecked() );
+  REQUIRE( Errors.size() == 3 );
+  REQUIRE( Errors.back().first == 21 );
+
+  auto &Primitives = Instance.getPrimitives();
+  auto Addable = Module.getInterface(Symbols.lookup("Addable"),
+                                      Sum->getGenericsList()[0].Pos);
+  REQUIRE( type::implementsInterface(Primitives.Int32, Addable, &Module) );
+  REQUIRE( !type::implementsInterface(Primitives.Int8, Addable, &Module) );
+  REQUIRE( !type::implementsInterface(Primitives.Int32, nullptr, &Module) );
+
+  // An instance checks its types against the bounds instead.
+  auto Calls = Sum->getCalls();
+  REQUIRE( Calls.size() == 2 );
+  REQUIRE( Sum->instantiate(Calls[0], &Module) != nullptr );
+  REQUIRE( Errors.size() == 3 );
+  REQUIRE( Sum->instantiate(Calls[1], &Module) == nullptr );
+  REQUIRE( Errors.size() == 4 );
+  REQUIRE( Errors.back().first == 25 );
+  REQUIRE( Errors.back().second == "type of `T` doesn't implement `Addable`" );
+}